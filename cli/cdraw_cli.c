@@ -0,0 +1,381 @@
+// cdraw-cli: converts, exports and summarises .cdraw files without a window.
+// It links only the canvas, file and export code, so it runs on machines
+// with no display, and works through many files at once, one per thread.
+
+#include "canvas.h"
+#include "export.h"
+#include "export_png.h"
+#include "prefs.h"
+#include <dirent.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+#define CLI_MAX_JOBS 64
+// Canvas units count as pixels at this density, as in the app's exports.
+#define CLI_BASE_DPI 96.0f
+#define CLI_MAX_PIXELS 65535
+// Rows rendered at once by PNG exports stop growing past this many bytes.
+#define CLI_BAND_BYTES (16 << 20)
+
+typedef enum {
+  CLI_STATS = 0,
+  CLI_TEXT,
+  CLI_BINARY,
+  CLI_COMPRESSED,
+  CLI_SVG,
+  CLI_PNG,
+  CLI_PDF,
+  CLI_FORMAT_COUNT
+} CliFormat;
+
+static const struct {
+  const char *name;
+  const char *extension;
+} kFormats[CLI_FORMAT_COUNT] = {
+    {"stats", NULL},          {"text", ".cdraw"}, {"binary", ".cdraw"},
+    {"compressed", ".cdraw"}, {"svg", ".svg"},    {"png", ".png"},
+    {"pdf", ".pdf"},
+};
+
+static struct {
+  CliFormat format;
+  const char *outDir; // NULL writes each output beside its input
+  float dpi;
+  float pageWidth, pageHeight; // PDF pages in points; 0 for one page
+  int jobs;
+  char **paths;
+  int pathCount;
+  int pathCapacity;
+  int next; // next path to claim
+  int failed;
+  pthread_mutex_t printLock;
+} gCli;
+
+static void Usage(const char *argv0) {
+  fprintf(stderr,
+          "usage: %s [--to FORMAT] [-o DIR] [--dpi N] [--page WxH] [-j N] FILE|DIR...\n"
+          "  FORMAT is stats (the default), text, binary, compressed, svg, png or\n"
+          "  pdf. PDFs tile pages of W x H points (0x0 for one page).\n"
+          "  Outputs take the input's name with the format's extension and go\n"
+          "  beside it, or into DIR; .cdraw formats replace the input in place.\n"
+          "  Directories stand for every .cdraw file directly inside them.\n",
+          argv0);
+}
+
+static bool AddPath(const char *path) {
+  if (gCli.pathCount == gCli.pathCapacity) {
+    int newCap = gCli.pathCapacity == 0 ? 64 : gCli.pathCapacity * 2;
+    char **grown = (char **)realloc(gCli.paths, sizeof(char *) * (size_t)newCap);
+    if (!grown)
+      return false;
+    gCli.paths = grown;
+    gCli.pathCapacity = newCap;
+  }
+  char *copy = strdup(path);
+  if (!copy)
+    return false;
+  gCli.paths[gCli.pathCount++] = copy;
+  return true;
+}
+
+static bool AddArgument(const char *arg) {
+  struct stat st;
+  if (stat(arg, &st) != 0 || !S_ISDIR(st.st_mode))
+    return AddPath(arg);
+
+  DIR *dir = opendir(arg);
+  if (!dir) {
+    fprintf(stderr, "%s: cannot open directory\n", arg);
+    return false;
+  }
+  bool ok = true;
+  struct dirent *entry;
+  while (ok && (entry = readdir(dir)) != NULL) {
+    size_t len = strlen(entry->d_name);
+    if (len <= 6 || strcmp(entry->d_name + len - 6, ".cdraw") != 0)
+      continue;
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", arg, entry->d_name);
+    ok = AddPath(path);
+  }
+  closedir(dir);
+  return ok;
+}
+
+// `in` with its extension replaced, in gCli.outDir when one is given.
+static bool OutputPath(const char *in, const char *extension, char *out,
+                       size_t outSize) {
+  const char *slash = strrchr(in, '/');
+  const char *name = slash ? slash + 1 : in;
+  const char *dot = strrchr(name, '.');
+  int nameLen = dot && dot != name ? (int)(dot - name) : (int)strlen(name);
+  int n;
+  if (gCli.outDir)
+    n = snprintf(out, outSize, "%s/%.*s%s", gCli.outDir, nameLen, name, extension);
+  else
+    n = snprintf(out, outSize, "%.*s%s", (int)(name - in) + nameLen, in, extension);
+  return n > 0 && (size_t)n < outSize;
+}
+
+// Bytes the loaded drawing occupies: stroke records, points and render
+// caches. Points of a mapped file count as the pages they are read from.
+static uint64_t CanvasMemory(const Canvas *canvas) {
+  uint64_t bytes = (uint64_t)canvas->capacity * sizeof(Stroke);
+  for (int i = 0; i < canvas->strokeCount; i++) {
+    const Stroke *s = &canvas->strokes[i];
+    int points = s->store ? s->pointCount : s->capacity;
+    bytes += (uint64_t)points * sizeof(Point);
+    bytes += (uint64_t)s->cachedCapacity * sizeof(Point);
+  }
+  return bytes;
+}
+
+static void PrintStats(const char *path, Canvas *canvas) {
+  Rectangle b;
+  char bounds[96] = "empty";
+  if (CanvasStrokeBounds(canvas, &b))
+    snprintf(bounds, sizeof(bounds), "%.1f,%.1f %.1fx%.1f", b.x, b.y, b.width,
+             b.height);
+  pthread_mutex_lock(&gCli.printLock);
+  printf("%s: %d strokes, %lld points, bounds %s, %.1f MiB\n", path,
+         canvas->strokeCount, (long long)canvas->totalPoints, bounds,
+         (double)CanvasMemory(canvas) / (1024.0 * 1024.0));
+  pthread_mutex_unlock(&gCli.printLock);
+}
+
+// The drawing and a margin, or a small square at the origin when empty.
+static Rectangle ExportArea(Canvas *canvas) {
+  const float pad = 24.0f;
+  Rectangle b = {0};
+  (void)CanvasStrokeBounds(canvas, &b);
+  return (Rectangle){b.x - pad, b.y - pad, b.width + pad * 2.0f,
+                     b.height + pad * 2.0f};
+}
+
+static bool ExportSvg(Canvas *canvas, const char *path) {
+  Rectangle area = ExportArea(canvas);
+  ExportView view = {area, area.width, area.height, 1.0f};
+  return ExportSvgFile(canvas, &view, path);
+}
+
+static bool ExportPdf(Canvas *canvas, const char *path) {
+  Rectangle area = ExportArea(canvas);
+  ExportView view = {area, area.width, area.height, 1.0f};
+  ExportPdfOptions options = {gCli.pageWidth, gCli.pageHeight, true};
+  return ExportPdfFile(canvas, &view, &options, path);
+}
+
+// The whole drawing at gCli.dpi, shrunk to fit the PNG size limit, rendered
+// a band of rows at a time straight into the encoder.
+static bool ExportPng(Canvas *canvas, int threads, const char *path) {
+  Rectangle area = ExportArea(canvas);
+  float zoom = gCli.dpi / CLI_BASE_DPI;
+  float over = fmaxf(area.width * zoom, area.height * zoom) / (float)CLI_MAX_PIXELS;
+  if (over > 1.0f)
+    zoom /= over;
+  int width = (int)ceilf(area.width * zoom);
+  int height = (int)ceilf(area.height * zoom);
+  width = width < 1 ? 1 : (width > CLI_MAX_PIXELS ? CLI_MAX_PIXELS : width);
+  height = height < 1 ? 1 : (height > CLI_MAX_PIXELS ? CLI_MAX_PIXELS : height);
+
+  canvas->camera = (Camera2D){
+      .offset = {(float)width * 0.5f, (float)height * 0.5f},
+      .target = {area.x + area.width * 0.5f, area.y + area.height * 0.5f},
+      .rotation = 0.0f,
+      .zoom = zoom,
+  };
+  canvas->selectedStrokeIndex = -1;
+
+  size_t stride = (size_t)width * 4;
+  int bandRows = (int)(CLI_BAND_BYTES / stride);
+  if (bandRows < 64)
+    bandRows = 64;
+  if (bandRows > height)
+    bandRows = height;
+  uint8_t *band = (uint8_t *)malloc(stride * (size_t)bandRows);
+  PngWriter *png = band ? PngWriterOpen(path, width, height, gCli.dpi) : NULL;
+  if (!png) {
+    free(band);
+    return false;
+  }
+  bool ok = true;
+  for (int y = 0; ok && y < height; y += bandRows) {
+    int rows = height - y < bandRows ? height - y : bandRows;
+    ok = CanvasRasterize(canvas, 0, y, width, rows, band, stride, threads);
+    for (int r = 0; ok && r < rows; r++)
+      PngWriterRow(png, band + stride * (size_t)r);
+  }
+  ok = PngWriterClose(png) && ok;
+  free(band);
+  return ok;
+}
+
+static bool ProcessFile(const char *path, int threads) {
+  Canvas canvas;
+  InitCanvas(&canvas, 1000, 800);
+  if (!LoadCanvasFromFile(&canvas, path) || !CanvasEnsureLoaded(&canvas)) {
+    fprintf(stderr, "%s: cannot load\n", path);
+    FreeCanvas(&canvas);
+    return false;
+  }
+
+  if (gCli.format == CLI_STATS) {
+    PrintStats(path, &canvas);
+    FreeCanvas(&canvas);
+    return true;
+  }
+
+  char out[PATH_MAX];
+  if (!OutputPath(path, kFormats[gCli.format].extension, out, sizeof(out))) {
+    fprintf(stderr, "%s: output path too long\n", path);
+    FreeCanvas(&canvas);
+    return false;
+  }
+  bool ok;
+  switch (gCli.format) {
+  case CLI_TEXT:
+    ok = WriteCanvasTextFile(&canvas, out);
+    break;
+  case CLI_BINARY:
+  case CLI_COMPRESSED:
+    canvas.compressSaves = gCli.format == CLI_COMPRESSED;
+    ok = WriteCanvasFile(&canvas, out);
+    break;
+  case CLI_SVG:
+    ok = ExportSvg(&canvas, out);
+    break;
+  case CLI_PDF:
+    ok = ExportPdf(&canvas, out);
+    break;
+  default:
+    ok = ExportPng(&canvas, threads, out);
+    break;
+  }
+  if (ok) {
+    fprintf(stderr, "%s -> %s\n", path, out);
+  } else {
+    fprintf(stderr, "%s: cannot write %s\n", path, out);
+    // The .cdraw writers replace their target only on success.
+    if (gCli.format >= CLI_SVG)
+      remove(out);
+  }
+  FreeCanvas(&canvas);
+  return ok;
+}
+
+static void *CliWorker(void *arg) {
+  // With one file at a time, each PNG export renders on every core instead.
+  int threads = *(const int *)arg;
+  for (;;) {
+    int i = __atomic_fetch_add(&gCli.next, 1, __ATOMIC_RELAXED);
+    if (i >= gCli.pathCount)
+      break;
+    if (!ProcessFile(gCli.paths[i], threads))
+      __atomic_fetch_add(&gCli.failed, 1, __ATOMIC_RELAXED);
+  }
+  return NULL;
+}
+
+static int DefaultJobs(void) {
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  if (cores < 1)
+    return 1;
+  return cores < CLI_MAX_JOBS ? (int)cores : CLI_MAX_JOBS;
+}
+
+int main(int argc, char **argv) {
+  AppPrefs prefs = PrefsDefaults();
+  (void)PrefsLoad(&prefs);
+  CanvasSetLoadLimits((CanvasLoadLimits){prefs.maxLoadStrokes, prefs.maxLoadPoints});
+  gCli.format = CLI_STATS;
+  gCli.dpi = prefs.exportDpi > 0.0f ? prefs.exportDpi : CLI_BASE_DPI;
+  gCli.pageWidth = prefs.pdfPageWidth;
+  gCli.pageHeight = prefs.pdfPageHeight;
+  gCli.jobs = DefaultJobs();
+  pthread_mutex_init(&gCli.printLock, NULL);
+
+  int i = 1;
+  for (; i < argc && argv[i][0] == '-'; i++) {
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (strcmp(argv[i], "--") == 0) {
+      i++;
+      break;
+    }
+    if (!value) {
+      Usage(argv[0]);
+      return 2;
+    }
+    if (strcmp(argv[i], "--to") == 0) {
+      int f = 0;
+      while (f < CLI_FORMAT_COUNT && strcmp(kFormats[f].name, value) != 0)
+        f++;
+      if (f == CLI_FORMAT_COUNT) {
+        fprintf(stderr, "unknown format %s\n", value);
+        return 2;
+      }
+      gCli.format = (CliFormat)f;
+    } else if (strcmp(argv[i], "-o") == 0) {
+      gCli.outDir = value;
+    } else if (strcmp(argv[i], "--dpi") == 0) {
+      gCli.dpi = strtof(value, NULL);
+      if (!(gCli.dpi > 0.0f)) {
+        fprintf(stderr, "bad --dpi %s\n", value);
+        return 2;
+      }
+    } else if (strcmp(argv[i], "--page") == 0) {
+      if (sscanf(value, "%fx%f", &gCli.pageWidth, &gCli.pageHeight) != 2 ||
+          !(gCli.pageWidth >= 0.0f && gCli.pageHeight >= 0.0f)) {
+        fprintf(stderr, "bad --page %s\n", value);
+        return 2;
+      }
+    } else if (strcmp(argv[i], "-j") == 0) {
+      gCli.jobs = atoi(value);
+      if (gCli.jobs < 1 || gCli.jobs > CLI_MAX_JOBS) {
+        fprintf(stderr, "-j takes 1 to %d\n", CLI_MAX_JOBS);
+        return 2;
+      }
+    } else {
+      Usage(argv[0]);
+      return 2;
+    }
+    i++;
+  }
+  if (i == argc) {
+    Usage(argv[0]);
+    return 2;
+  }
+  for (; i < argc; i++) {
+    if (!AddArgument(argv[i]))
+      return 1;
+  }
+
+  int jobs = gCli.jobs < gCli.pathCount ? gCli.jobs : gCli.pathCount;
+  int threadsPerFile = jobs > 1 ? 1 : 0;
+  pthread_t threads[CLI_MAX_JOBS];
+  int started = 0;
+  // Fewer threads than asked for is fine; the main thread works too.
+  while (started + 1 < jobs &&
+         pthread_create(&threads[started], NULL, CliWorker, &threadsPerFile) == 0)
+    started++;
+  CliWorker(&threadsPerFile);
+  for (int t = 0; t < started; t++)
+    pthread_join(threads[t], NULL);
+
+  if (gCli.format != CLI_STATS || gCli.failed > 0)
+    fprintf(stderr, "%d files, %d failed\n", gCli.pathCount, gCli.failed);
+  for (int p = 0; p < gCli.pathCount; p++)
+    free(gCli.paths[p]);
+  free(gCli.paths);
+  pthread_mutex_destroy(&gCli.printLock);
+  return gCli.failed > 0 ? 1 : 0;
+}
@@ -23,27 +23,24 @@ static void Append(char *out, size_t out_sz,
 static void StrokeBounds(const Stroke *s,
                          float *min_x, float *min_y,
                          float *max_x, float *max_y) {
-  *min_x = 0.0f;
-  *min_y = 0.0f;
-  *max_x = 0.0f;
-  *max_y = 0.0f;
-  if (!s || s->pointCount <= 0)
-    return;
-  *min_x = s->points[0].x;
-  *min_y = s->points[0].y;
-  *max_x = s->points[0].x;
-  *max_y = s->points[0].y;
-  for (int i = 1; i < s->pointCount; i++) {
-    float x = s->points[i].x;
-    float y = s->points[i].y;
-    if (x < *min_x)
-      *min_x = x;
-    if (y < *min_y)
-      *min_y = y;
-    if (x > *max_x)
-      *max_x = x;
-    if (y > *max_y)
-      *max_y = y;
+  Rectangle b = {0};
+  StrokeGetBounds(s, &b);
+  *min_x = b.x;
+  *min_y = b.y;
+  *max_x = b.x + b.width;
+  *max_y = b.y + b.height;
+}
+
+static const char *StrokeKind(const Stroke *s) {
+  switch (s->shape) {
+  case STROKE_SHAPE_ARROW:
+    return "arrow";
+  case STROKE_SHAPE_RECT:
+    return "rect";
+  case STROKE_SHAPE_CIRCLE:
+    return "circle";
+  default:
+    return "path";
   }
 }
 
@@ -67,8 +64,8 @@ void AiBuildPrompt(const Canvas *c, char *out,
     float min_x, min_y, max_x, max_y;
     StrokeBounds(s, &min_x, &min_y, &max_x, &max_y);
     Append(out, out_sz, &off,
-           "[%d] pts=%d thick=%.1f ",
-           i + 1, s->pointCount, s->thickness);
+           "[%d] %s pts=%d thick=%.1f ",
+           i + 1, StrokeKind(s), s->pointCount, s->thickness);
     Append(out, out_sz, &off,
            "color=#%02X%02X%02X ",
            s->color.r, s->color.g, s->color.b);
@@ -6,6 +6,15 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(_WIN32)
+#include <direct.h>
+#define MKDIR(path) _mkdir(path)
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#define MKDIR(path) mkdir(path, 0755)
+#endif
+
 #ifndef PATH_MAX
 #define PATH_MAX 4096
 #endif
@@ -182,3 +191,47 @@ bool CdrawBackendPath(char *out, size_t size) {
   out[0] = '\0';
   return false;
 }
+
+// Creates every missing directory along `path`.
+static bool MakeDirs(const char *path) {
+  char buf[PATH_MAX];
+  CopyString(buf, sizeof(buf), path);
+  for (char *p = buf + 1; *p; p++) {
+    if (*p != '/' && *p != '\\')
+      continue;
+    char sep = *p;
+    *p = '\0';
+    (void)MKDIR(buf);
+    *p = sep;
+  }
+  (void)MKDIR(buf);
+  struct stat st;
+  return stat(buf, &st) == 0;
+}
+
+bool CdrawDataDir(char *out, size_t size, const char *subdir) {
+  if (!out || size == 0)
+    return false;
+
+  char base[PATH_MAX];
+  base[0] = '\0';
+#if defined(_WIN32)
+  const char *appData = getenv("APPDATA");
+  if (appData && appData[0] != '\0')
+    snprintf(base, sizeof(base), "%s\\cdraw", appData);
+#else
+  const char *xdg = getenv("XDG_DATA_HOME");
+  const char *home = getenv("HOME");
+  if (xdg && xdg[0] != '\0')
+    snprintf(base, sizeof(base), "%s/cdraw", xdg);
+  else if (home && home[0] != '\0')
+    snprintf(base, sizeof(base), "%s/.local/share/cdraw", home);
+#endif
+  if (base[0] == '\0') {
+    out[0] = '\0';
+    return false;
+  }
+
+  JoinPath(out, size, base, subdir);
+  return MakeDirs(out);
+}
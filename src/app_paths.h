@@ -7,5 +7,8 @@
 bool CdrawResolveRoot(char *out, size_t size);
 const char *CdrawAssetPath(char *out, size_t size, const char *relative);
 bool CdrawBackendPath(char *out, size_t size);
+// Per-user data directory for `subdir` (created if missing), e.g.
+// ~/.local/share/cdraw/autosave.
+bool CdrawDataDir(char *out, size_t size, const char *subdir);
 
 #endif
@@ -2,6 +2,7 @@
 #define CANVAS_H
 
 #include "raylib.h"
+#include <stddef.h>
 #include <stdint.h>
 
 #define DEFAULT_ZOOM 5.0f
@@ -23,6 +24,22 @@ typedef struct {
   float width;
 } Point;
 
+// What a stroke's points describe. Shapes keep only their control points and
+// are tessellated when drawn or exported.
+typedef enum {
+  STROKE_SHAPE_PATH = 0, // freehand polyline
+  STROKE_SHAPE_ARROW,    // points[0] = start, points[1] = tip
+  STROKE_SHAPE_RECT,     // points[0], points[1] = opposite corners
+  STROKE_SHAPE_CIRCLE,   // points[0] = center, points[1] = a point on the rim
+  STROKE_SHAPE_COUNT
+} StrokeShape;
+
+// Read-only point storage shared by strokes loaded from a mapped file.
+typedef struct PointStore PointStore;
+
+// Open chunked file whose strokes are still being streamed in.
+typedef struct LazyFile LazyFile;
+
 typedef struct {
   Point *points;
   int pointCount;
@@ -30,19 +47,72 @@ typedef struct {
   Color color;
   float thickness;
   bool usePressure;
+  StrokeShape shape;
+  PointStore *store; // set while `points` borrows from a mapped file
+  // Placeholder for a stroke of a chunked file that is not read yet: the
+  // 1-based chunk and the position within it (0 for ordinary strokes).
+  uint32_t lazyChunk;
+  uint32_t lazyIndex;
   Point *cachedPoints;
   int cachedCount;
   int cachedCapacity;
   uint32_t cacheVersion;
   uint32_t lastBuiltVersion;
   bool cacheDirty;
+  // Corners of the points' bounds, valid while boundsVersion is cacheVersion
+  // + 1 (0 when never measured); see StrokeGetBounds.
+  Vector2 boundsMin;
+  Vector2 boundsMax;
+  uint32_t boundsVersion;
 } Stroke;
 
+#define PEN_PREDICTED_MAX 6
+
+// Live pen ingestion state, reset at the start of each stroke.
+typedef struct {
+  double lastTime;  // capture timestamp of the last ingested sample
+  Vector2 filtered; // One-Euro filtered position
+  Vector2 velocity; // filtered velocity, world units per second
+  Vector2 walkFrom; // end of the filtered path already resampled
+  float carry;      // arc length walked since the last resampled point
+  Vector2 lastRaw;  // last unfiltered sample, used to end the stroke
+  float runLength;  // length folded into the last point by collinear merging
+  Vector2 accel;    // filtered acceleration, world units per second squared
+
+  // Extrapolated tail drawn after the live stroke; never committed.
+  Point predicted[PEN_PREDICTED_MAX];
+  int predictedCount;
+  // Points (before the tail) and width the live stroke's smoothed cache was
+  // last built from; 0 points for none.
+  int smoothedPoints;
+  float smoothedWidth;
+} PenState;
+
+// Edits since the last save, encoded for appending to the saved file.
+typedef struct {
+  uint8_t *ops;
+  size_t size;
+  size_t capacity;
+  size_t lastOp;     // offset of the newest op, for merging repeated edits
+  char *path;        // file the next save may append to; NULL forces a rewrite
+  uint64_t fileSize; // its size as last written
+  uint64_t baseSize; // bytes of it written by the last full rewrite
+  bool failed;       // an edit was not recorded; rewrite on the next save
+} CanvasJournal;
+
 typedef struct {
   Stroke *strokes;
   int strokeCount;
   int capacity;
-  int totalPoints;
+  int64_t totalPoints; // may pass 2^31; single strokes stay below it
+
+  // Extent of the committed strokes, as CanvasStrokeBounds reports it, kept
+  // up as they change. Edits that may shrink it, and loads, only mark it
+  // stale; the next query rebuilds it from the per-stroke bounds.
+  Vector2 boundsMin;
+  Vector2 boundsMax;
+  bool hasBounds;
+  bool boundsStale;
 
   // Redo Stack
   Stroke *redoStrokes;
@@ -56,6 +126,22 @@ typedef struct {
   Point startPoint; // Store start point explicitly for shapes
   bool showGrid;
   Stroke currentStroke;
+  PenState pen;
+
+  // Commit-time simplification tolerance in screen pixels (0 disables) and
+  // the point counts before/after for the last committed pen stroke.
+  float simplifyTolerance;
+  int lastCommitPointsIn;
+  int lastCommitPointsOut;
+
+  // Save in the compressed format (smaller, but loads are not zero-copy).
+  bool compressSaves;
+
+  // Set while strokes of a chunked file are still placeholders.
+  LazyFile *lazy;
+
+  CanvasJournal journal;
+  uint64_t editCount; // bumped by every edit the journal sees
 
   // Theme
   Color backgroundColor;
@@ -76,8 +162,113 @@ void AddStroke(Canvas *canvas, Stroke stroke);
 void Undo(Canvas *canvas);
 void Redo(Canvas *canvas);
 void ClearCanvas(Canvas *canvas);
-bool SaveCanvasToFile(const Canvas *canvas, const char *path);
+// Appends the edits since the last save when `path` is the file that save
+// wrote and its journal is still small; otherwise rewrites the whole file.
+bool SaveCanvasToFile(Canvas *canvas, const char *path);
+// Rewrites `path` in full, folding in any journal.
+bool CompactCanvasFile(Canvas *canvas, const char *path);
+// Full save that leaves the journal alone; usable on a snapshot from any
+// thread. Fails while chunks are still streaming in.
+bool WriteCanvasFile(const Canvas *canvas, const char *path);
+// WriteCanvasFile in the legacy CDRAW2 text format, for older builds and other
+// tools. Text has no shapes, so rectangles and circles become their outlines.
+bool WriteCanvasTextFile(const Canvas *canvas, const char *path);
 bool LoadCanvasFromFile(Canvas *canvas, const char *path);
-int GetTotalPoints(const Canvas *canvas);
+// Checks a saved file without opening it as a document: files with checksums
+// (v5, and chunked files since v5) by those alone, others by loading them.
+bool CanvasVerifyFile(const char *path, bool *checksummed, char *error,
+                      size_t errorSize);
+int64_t GetTotalPoints(const Canvas *canvas);
+
+// Loads fail on files with more strokes or points than this, rather than
+// trusting counts from a possibly corrupt file. Adjustable from prefs.
+typedef struct {
+  uint32_t maxStrokes;
+  uint64_t maxTotalPoints;
+} CanvasLoadLimits;
+CanvasLoadLimits CanvasGetLoadLimits(void);
+void CanvasSetLoadLimits(CanvasLoadLimits limits);
+
+// Chunked files open with only the chunks in the saved view loaded. The rest
+// stream in through CanvasStreamPending, chunks intersecting `view` first,
+// for at most `budgetSeconds` per call; it returns true while any remain.
+// Full rewrites load anything still pending first (CanvasEnsureLoaded).
+bool CanvasStreamPending(Canvas *canvas, Rectangle view, double budgetSeconds);
+bool CanvasEnsureLoaded(Canvas *canvas);
+// A chunk could not be read or failed its checksum. Its strokes stay empty
+// placeholders and the canvas stays lazy, so saves, snapshots and exports
+// refuse it; CanvasEnsureLoaded tries the chunk again.
+bool CanvasStreamFailed(const Canvas *canvas);
+
+// Point ownership (canvas_store.c). Strokes loaded from a mapped file borrow
+// their points; anything that modifies them must make them writable first.
+void StrokeFreePoints(Stroke *s);
+bool StrokeMakePointsWritable(Stroke *s);
+
+// Read-only copy of the committed strokes and view for saving off the main
+// thread. Point buffers are shared rather than copied: the live canvas copies
+// a buffer before editing it (StrokeMakePointsWritable). `withCaches` copies
+// the built render caches too, for exports that draw pressure strokes the way
+// the screen does, instead of smoothing them again; saves do without. Returns
+// NULL while chunks are still streaming in. Free from any thread.
+Canvas *CanvasSnapshotCreate(Canvas *canvas, bool withCaches);
+void CanvasSnapshotFree(Canvas *snapshot);
+
+// Loading on a worker thread (canvas_io.c). The loader pushes strokes to the
+// feed as it decodes them; the UI thread takes them in batches to show a
+// preview, and may cancel. Preview strokes share points with the loading
+// canvas, so freeing either side is safe from any thread.
+typedef struct CanvasLoadFeed CanvasLoadFeed;
+CanvasLoadFeed *CanvasLoadFeedCreate(void);
+void CanvasLoadFeedFree(CanvasLoadFeed *feed);
+void CanvasLoadFeedCancel(CanvasLoadFeed *feed);
+// Fraction of the file's strokes decoded so far.
+float CanvasLoadFeedProgress(CanvasLoadFeed *feed);
+// Appends the strokes decoded since the last call to `preview` without
+// journalling them, and applies the file's view once its header is read.
+int CanvasLoadFeedTake(CanvasLoadFeed *feed, Canvas *preview);
+// LoadCanvasFromFile reporting to `feed`; fails once the feed is cancelled.
+bool LoadCanvasFromFileFed(Canvas *canvas, const char *path, CanvasLoadFeed *feed);
+
+// Shape tessellation (canvas_shapes.c). `zoom` picks the circle segment
+// count; outlines of closed shapes repeat their first point at the end.
+float StrokeCircleRadius(const Stroke *s);
+int StrokeCircleSegments(float screenRadius);
+int StrokeOutlineCount(const Stroke *s, float zoom);
+int StrokeOutline(const Stroke *s, float zoom, Point *out);
+// Reads the cached bounds when they are current, else measures the points.
+bool StrokeGetBounds(const Stroke *s, Rectangle *out);
+// Bounds of the whole drawing, half of each stroke's thickness included;
+// false when there are no strokes. Constant time unless an edit or load left
+// them stale.
+bool CanvasStrokeBounds(Canvas *canvas, Rectangle *out);
+bool StrokeUpgradeLegacyArrow(Stroke *s);
+// Arrow geometry: where the shaft ends and the head triangle (tip first).
+// False when the arrow is too short to point anywhere.
+bool StrokeArrowHead(const Stroke *s, float thickness, Vector2 *shaftEnd,
+                     Vector2 head[3]);
+
+// Smoothed, tapered stroke geometry (canvas_smooth.c), shared by the renderer
+// and the exporters. StrokeSmoothedPoints rebuilds the stroke's cache when it
+// is stale and returns its length; StrokeSmoothInto writes the same points,
+// StrokeSmoothedCount of them, to a caller's buffer instead.
+int StrokeSmoothedPoints(Stroke *s, float baseWidth);
+int StrokeSmoothedCount(const Stroke *s);
+int StrokeSmoothInto(const Stroke *s, float baseWidth, Point *out);
+// The same cache for a stroke that grows at its end, when its first `keep`
+// points are unchanged since the cache was built: only samples that depend on
+// later points are redone. The result matches a full rebuild.
+int StrokeSmoothedPointsGrowing(Stroke *s, float baseWidth, int keep);
+// Closed outline of a variable-width polyline with round caps, for filling.
+int StrokeFillOutlineCount(int count);
+int StrokeFillOutline(const Point *pts, int count, Point *out);
+
+// Software rendering without a window or GL context (canvas_raster.c). Draws
+// what DrawCanvas would, less the stroke being drawn, through the canvas
+// camera into `width` x `height` 8-bit RGBA pixels, rows `stride` bytes
+// apart. (x, y) is the pixel of the view the buffer starts at, so large
+// images can be drawn a band at a time. `threads` <= 0 uses every core.
+bool CanvasRasterize(Canvas *canvas, int x, int y, int width, int height,
+                     uint8_t *rgba, size_t stride, int threads);
 
 #endif // CANVAS_H
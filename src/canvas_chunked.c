@@ -0,0 +1,599 @@
+#include "canvas_chunked.h"
+#include "canvas_format.h"
+#include "crc32c.h"
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Grows `bounds` by what `s` can paint, including its line width.
+static void ExpandChunkBounds(Rectangle *bounds, bool *any, const Stroke *s) {
+  Rectangle r;
+  if (!StrokeGetBounds(s, &r))
+    return;
+  float width = s->thickness;
+  for (int i = 0; i < s->pointCount; i++) {
+    if (s->points[i].width > width)
+      width = s->points[i].width;
+  }
+  float pad = width * 0.5f;
+  float minX = r.x - pad, minY = r.y - pad;
+  float maxX = r.x + r.width + pad, maxY = r.y + r.height + pad;
+  if (*any) {
+    minX = fminf(minX, bounds->x);
+    minY = fminf(minY, bounds->y);
+    maxX = fmaxf(maxX, bounds->x + bounds->width);
+    maxY = fmaxf(maxY, bounds->y + bounds->height);
+  }
+  *bounds = (Rectangle){minX, minY, maxX - minX, maxY - minY};
+  *any = true;
+}
+
+static void PackChunkEntry(const ChunkInfo *c, uint8_t *entry) {
+  memset(entry, 0, CHUNKED_ENTRY_SIZE);
+  PutU64(entry + 0, c->offset);
+  PutU64(entry + 8, c->size);
+  PutU32(entry + 16, c->firstStroke);
+  PutU32(entry + 20, c->strokeCount);
+  PutU32(entry + 24, c->pointCount);
+  PutU32(entry + 28, c->crc);
+  PutF32(entry + 32, c->bounds.x);
+  PutF32(entry + 36, c->bounds.y);
+  PutF32(entry + 40, c->bounds.width);
+  PutF32(entry + 44, c->bounds.height);
+}
+
+bool WriteChunkedCanvas(const Canvas *canvas, FILE *f) {
+  if (!canvas)
+    return false;
+  if (canvas->strokeCount < 0)
+    return false;
+
+  uint32_t strokeCount = (uint32_t)canvas->strokeCount;
+  uint8_t preamble[MAPPED_PREAMBLE_SIZE] = {0};
+  memcpy(preamble, kBinaryMagic, sizeof(kBinaryMagic));
+  PackHeader(canvas, kBinaryVersionChunked, strokeCount, preamble + 4);
+  PutU32(preamble + 8, kBinaryFlags | kBinaryFlagChunkChecksums);
+  if (fwrite(preamble, 1, sizeof(preamble), f) != sizeof(preamble))
+    return false;
+
+  ChunkInfo *chunks = NULL;
+  uint32_t chunkCount = 0;
+  uint32_t chunkCapacity = 0;
+  uint64_t offset = MAPPED_PREAMBLE_SIZE;
+  bool ok = true;
+
+  uint32_t i = 0;
+  while (ok && i < strokeCount) {
+    if (chunkCount >= chunkCapacity) {
+      uint32_t newCap = chunkCapacity == 0 ? 64 : chunkCapacity * 2;
+      ChunkInfo *next = (ChunkInfo *)realloc(chunks, sizeof(ChunkInfo) * newCap);
+      if (!next) {
+        ok = false;
+        break;
+      }
+      chunks = next;
+      chunkCapacity = newCap;
+    }
+
+    ChunkInfo c = {0};
+    c.offset = offset;
+    c.firstStroke = i;
+    bool any = false;
+    while (i < strokeCount && c.strokeCount < CHUNKED_MAX_STROKES) {
+      const Stroke *s = &canvas->strokes[i];
+      if (s->pointCount < 0) {
+        ok = false;
+        break;
+      }
+      uint32_t pointCount = (uint32_t)s->pointCount;
+      if (c.strokeCount > 0 && c.pointCount + pointCount > CHUNKED_MAX_POINTS)
+        break;
+
+      uint8_t record[BINARY_STROKE_SIZE];
+      PackStrokeRecord(s, record);
+      if (fwrite(record, 1, sizeof(record), f) != sizeof(record) ||
+          (pointCount > 0 && fwrite(s->points, sizeof(Point), pointCount, f) != pointCount)) {
+        ok = false;
+        break;
+      }
+      c.crc = Crc32c(c.crc, record, sizeof(record));
+      c.crc = Crc32c(c.crc, s->points, sizeof(Point) * (size_t)pointCount);
+      ExpandChunkBounds(&c.bounds, &any, s);
+      c.size += BINARY_STROKE_SIZE + (uint64_t)pointCount * sizeof(Point);
+      c.pointCount += pointCount;
+      c.strokeCount++;
+      i++;
+    }
+    offset += c.size;
+    chunks[chunkCount++] = c;
+  }
+
+  // The index offset is only known now; it is patched into the preamble
+  // after the index, whose checksum covers it.
+  PutU64(preamble + MAPPED_TABLE_OFFSET_AT, offset);
+  uint32_t indexCrc = Crc32c(0, preamble, sizeof(preamble));
+  for (uint32_t c = 0; ok && c < chunkCount; c++) {
+    uint8_t entry[CHUNKED_ENTRY_SIZE];
+    PackChunkEntry(&chunks[c], entry);
+    indexCrc = Crc32c(indexCrc, entry, sizeof(entry));
+  }
+
+  uint8_t prefix[CHUNKED_INDEX_PREFIX] = {0};
+  PutU32(prefix, chunkCount);
+  PutU32(prefix + 4, indexCrc);
+  if (ok && fwrite(prefix, 1, sizeof(prefix), f) != sizeof(prefix))
+    ok = false;
+  for (uint32_t c = 0; ok && c < chunkCount; c++) {
+    uint8_t entry[CHUNKED_ENTRY_SIZE];
+    PackChunkEntry(&chunks[c], entry);
+    if (fwrite(entry, 1, sizeof(entry), f) != sizeof(entry))
+      ok = false;
+  }
+  free(chunks);
+
+  if (ok && (fseek(f, MAPPED_TABLE_OFFSET_AT, SEEK_SET) != 0 ||
+             fwrite(preamble + MAPPED_TABLE_OFFSET_AT, 1, 8, f) != 8))
+    ok = false;
+  return ok;
+}
+
+struct LazyFile {
+  PointStore *store; // the whole file, mapped
+  uint32_t flags;
+  ChunkInfo *chunks;
+  uint32_t chunkCount;
+  uint32_t pendingCount;
+  uint32_t *batch; // chunk indices, one slot per chunk
+};
+
+// Chunks decode on up to this many threads, the caller's included.
+#define CHUNK_DECODE_MAX_THREADS 16
+
+static double NowSeconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static bool RectsOverlap(Rectangle a, Rectangle b) {
+  return a.x <= b.x + b.width && b.x <= a.x + a.width && a.y <= b.y + b.height &&
+         b.y <= a.y + a.height;
+}
+
+// World area shown by a saved camera. The window size is not saved, so this
+// assumes at least a 1920x1080 window; anything it misses streams in on the
+// first frames.
+static Rectangle SavedCameraView(const Camera2D *camera) {
+  float zoom = camera->zoom > 0.0f ? camera->zoom : 1.0f;
+  float w = fmaxf(fabsf(camera->offset.x) * 2.0f, 1920.0f) / zoom;
+  float h = fmaxf(fabsf(camera->offset.y) * 2.0f, 1080.0f) / zoom;
+  if (camera->rotation != 0.0f) {
+    float r = sqrtf(w * w + h * h);
+    return (Rectangle){camera->target.x - r, camera->target.y - r, r * 2.0f, r * 2.0f};
+  }
+  return (Rectangle){camera->target.x - fabsf(camera->offset.x) / zoom,
+                     camera->target.y - fabsf(camera->offset.y) / zoom, w, h};
+}
+
+// Next chunk to read: one intersecting `view` if any, otherwise the nearest.
+static int NextPendingChunk(const LazyFile *lf, Rectangle view, bool visibleOnly) {
+  float cx = view.x + view.width * 0.5f;
+  float cy = view.y + view.height * 0.5f;
+  int best = -1;
+  float bestDist = 0.0f;
+  for (uint32_t c = 0; c < lf->chunkCount; c++) {
+    const ChunkInfo *chunk = &lf->chunks[c];
+    // Failed chunks are retried only by CanvasEnsureLoaded, not every frame.
+    if (chunk->loaded || chunk->decoded || chunk->queued || chunk->failed)
+      continue;
+    if (RectsOverlap(view, chunk->bounds))
+      return (int)c;
+    if (visibleOnly)
+      continue;
+    float dx = chunk->bounds.x + chunk->bounds.width * 0.5f - cx;
+    float dy = chunk->bounds.y + chunk->bounds.height * 0.5f - cy;
+    float dist = dx * dx + dy * dy;
+    if (best < 0 || dist < bestDist) {
+      best = (int)c;
+      bestDist = dist;
+    }
+  }
+  return best;
+}
+
+bool ReadAt(int fd, uint8_t *out, uint64_t size, uint64_t offset) {
+  while (size > 0) {
+    ssize_t n = pread(fd, out, (size_t)size, (off_t)offset);
+    if (n <= 0)
+      return false;
+    out += n;
+    size -= (uint64_t)n;
+    offset += (uint64_t)n;
+  }
+  return true;
+}
+
+// Checks a chunk in the mapping and points its strokes straight at it, as
+// v5 loads do. Chunks are independent, so several check at once.
+static bool ReadChunk(const LazyFile *lf, ChunkInfo *chunk) {
+  const uint8_t *data = lf->store->base + chunk->offset;
+  if ((lf->flags & kBinaryFlagChunkChecksums) &&
+      Crc32c(0, data, (size_t)chunk->size) != chunk->crc) {
+    fprintf(stderr, "Load: chunk at stroke %u: checksum mismatch\n", chunk->firstStroke);
+    return false;
+  }
+
+  Stroke *strokes = (Stroke *)calloc(chunk->strokeCount, sizeof(Stroke));
+  if (!strokes)
+    return false;
+
+  // The index already tied size to the stroke and point counts, so only the
+  // per-stroke counts need checking against what is left.
+  const uint8_t *p = data;
+  uint64_t remaining = chunk->size;
+  for (uint32_t i = 0; i < chunk->strokeCount; i++) {
+    if (remaining < BINARY_STROKE_SIZE)
+      goto fail;
+    uint32_t pointCount = GetU32(p + 12);
+    uint64_t bytes = (uint64_t)pointCount * sizeof(Point);
+    if (remaining - BINARY_STROKE_SIZE < bytes)
+      goto fail;
+
+    Stroke s = UnpackStrokeRecord(p, lf->flags);
+    if (pointCount > 0) {
+      s.points = (Point *)(p + BINARY_STROKE_SIZE);
+      s.store = lf->store;
+      PointStoreRetain(lf->store);
+    }
+    strokes[i] = s;
+    p += BINARY_STROKE_SIZE + bytes;
+    remaining -= BINARY_STROKE_SIZE + bytes;
+  }
+  if (remaining != 0)
+    goto fail;
+
+  chunk->decoded = strokes;
+  return true;
+
+fail:
+  FreeLoadedStrokes(strokes, chunk->strokeCount);
+  return false;
+}
+
+typedef struct {
+  const LazyFile *lf;
+  uint32_t count;
+  uint32_t next; // claimed atomically by the workers
+} ChunkDecodeJob;
+
+static void *ChunkDecodeWorker(void *arg) {
+  ChunkDecodeJob *job = (ChunkDecodeJob *)arg;
+  for (;;) {
+    uint32_t i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+    if (i >= job->count)
+      break;
+    ChunkInfo *chunk = &job->lf->chunks[job->lf->batch[i]];
+    chunk->failed = !ReadChunk(job->lf, chunk);
+  }
+  return NULL;
+}
+
+static uint32_t ChunkDecodeThreads(void) {
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  if (cores < 1)
+    return 1;
+  return cores < CHUNK_DECODE_MAX_THREADS ? (uint32_t)cores : CHUNK_DECODE_MAX_THREADS;
+}
+
+// Decodes the first `count` chunks of lf->batch, each chunk's strokes into
+// its own array, so the workers share nothing but the job counter.
+// FillPlaceholders stitches them into the canvas afterwards, in file order.
+static void DecodeChunkBatch(LazyFile *lf, uint32_t count) {
+  ChunkDecodeJob job = {lf, count, 0};
+  pthread_t threads[CHUNK_DECODE_MAX_THREADS];
+  uint32_t want = ChunkDecodeThreads();
+  if (want > count)
+    want = count;
+  uint32_t started = 0;
+  // Fewer threads than asked for is fine; the caller works through the rest.
+  while (started + 1 < want &&
+         pthread_create(&threads[started], NULL, ChunkDecodeWorker, &job) == 0)
+    started++;
+  ChunkDecodeWorker(&job);
+  for (uint32_t t = 0; t < started; t++)
+    pthread_join(threads[t], NULL);
+}
+
+static bool FillPlaceholder(LazyFile *lf, Stroke *slot) {
+  if (slot->lazyChunk == 0 || slot->lazyChunk > lf->chunkCount)
+    return false;
+  ChunkInfo *chunk = &lf->chunks[slot->lazyChunk - 1];
+  if (!chunk->decoded || slot->lazyIndex >= chunk->strokeCount)
+    return false;
+  Stroke *src = &chunk->decoded[slot->lazyIndex];
+  *slot = *src;
+  src->points = NULL;
+  src->pointCount = 0;
+  src->store = NULL;
+  return true;
+}
+
+// Moves decoded strokes into their placeholders. Placeholders normally sit
+// where the file put them; after edits they are searched for, including on
+// the redo stack. Strokes whose placeholder was deleted are dropped.
+static void FillPlaceholders(Canvas *canvas) {
+  LazyFile *lf = canvas->lazy;
+  bool missed = false;
+  for (uint32_t c = 0; c < lf->chunkCount; c++) {
+    ChunkInfo *chunk = &lf->chunks[c];
+    if (!chunk->decoded)
+      continue;
+    for (uint32_t i = 0; i < chunk->strokeCount; i++) {
+      uint64_t at = (uint64_t)chunk->firstStroke + i;
+      Stroke *slot = at < (uint64_t)canvas->strokeCount ? &canvas->strokes[at] : NULL;
+      if (slot && slot->lazyChunk == c + 1 && slot->lazyIndex == i &&
+          FillPlaceholder(lf, slot)) {
+        canvas->totalPoints += slot->pointCount;
+        CanvasBoundsAdd(canvas, slot);
+      } else if (chunk->decoded[i].points)
+        missed = true;
+    }
+  }
+
+  if (missed) {
+    for (int i = 0; i < canvas->strokeCount; i++) {
+      if (FillPlaceholder(lf, &canvas->strokes[i])) {
+        canvas->totalPoints += canvas->strokes[i].pointCount;
+        CanvasBoundsAdd(canvas, &canvas->strokes[i]);
+      }
+    }
+    for (int i = 0; i < canvas->redoCount; i++)
+      FillPlaceholder(lf, &canvas->redoStrokes[i]);
+  }
+
+  for (uint32_t c = 0; c < lf->chunkCount; c++) {
+    ChunkInfo *chunk = &lf->chunks[c];
+    if (!chunk->decoded)
+      continue;
+    FreeLoadedStrokes(chunk->decoded, chunk->strokeCount);
+    chunk->decoded = NULL;
+    chunk->loaded = true;
+    lf->pendingCount--;
+  }
+}
+
+static bool StreamChunks(Canvas *canvas, Rectangle view, double budgetSeconds,
+                         bool visibleOnly) {
+  LazyFile *lf = canvas->lazy;
+  if (!lf)
+    return true;
+
+  double start = NowSeconds();
+  uint32_t threads = ChunkDecodeThreads();
+  bool ok = true;
+  for (;;) {
+    uint32_t count = 0;
+    if (isinf(budgetSeconds)) {
+      // Nothing is drawn until all of it is in, so order does not matter.
+      // Chunks that failed before are tried again.
+      for (uint32_t c = 0; c < lf->chunkCount; c++) {
+        const ChunkInfo *chunk = &lf->chunks[c];
+        if (!chunk->loaded && !chunk->decoded &&
+            (!visibleOnly || RectsOverlap(view, chunk->bounds)))
+          lf->batch[count++] = c;
+      }
+    } else {
+      // Nearest first, a chunk per thread between budget checks.
+      while (count < threads) {
+        int c = NextPendingChunk(lf, view, visibleOnly);
+        if (c < 0)
+          break;
+        lf->chunks[c].queued = true;
+        lf->batch[count++] = (uint32_t)c;
+      }
+    }
+    if (count == 0)
+      break;
+
+    DecodeChunkBatch(lf, count);
+    for (uint32_t i = 0; i < count; i++) {
+      ChunkInfo *chunk = &lf->chunks[lf->batch[i]];
+      chunk->queued = false;
+      // An unreadable chunk stays pending, so the canvas stays lazy and is
+      // never saved with its strokes empty.
+      if (chunk->failed)
+        ok = false;
+    }
+    if (!ok || isinf(budgetSeconds) || NowSeconds() - start >= budgetSeconds)
+      break;
+  }
+
+  FillPlaceholders(canvas);
+  if (lf->pendingCount == 0)
+    CanvasCloseLazy(canvas);
+  return ok;
+}
+
+bool CanvasStreamPending(Canvas *canvas, Rectangle view, double budgetSeconds) {
+  if (!canvas || !canvas->lazy)
+    return false;
+  StreamChunks(canvas, view, budgetSeconds, false);
+  return canvas->lazy != NULL;
+}
+
+bool CanvasStreamFailed(const Canvas *canvas) {
+  if (!canvas || !canvas->lazy)
+    return false;
+  for (uint32_t c = 0; c < canvas->lazy->chunkCount; c++) {
+    if (canvas->lazy->chunks[c].failed)
+      return true;
+  }
+  return false;
+}
+
+bool CanvasEnsureLoaded(Canvas *canvas) {
+  if (!canvas || !canvas->lazy)
+    return true;
+  Rectangle view = SavedCameraView(&canvas->camera);
+  bool ok = StreamChunks(canvas, view, INFINITY, false);
+  return ok && !canvas->lazy;
+}
+
+void CanvasCloseLazy(Canvas *canvas) {
+  if (!canvas || !canvas->lazy)
+    return;
+  LazyFile *lf = canvas->lazy;
+  for (uint32_t c = 0; c < lf->chunkCount; c++)
+    FreeLoadedStrokes(lf->chunks[c].decoded, lf->chunks[c].strokeCount);
+  free(lf->chunks);
+  free(lf->batch);
+  PointStoreRelease(lf->store);
+  free(lf);
+  canvas->lazy = NULL;
+}
+
+bool UnpackChunkEntry(const uint8_t *entry, ChunkInfo *c) {
+  memset(c, 0, sizeof(*c));
+  c->offset = GetU64(entry + 0);
+  c->size = GetU64(entry + 8);
+  c->firstStroke = GetU32(entry + 16);
+  c->strokeCount = GetU32(entry + 20);
+  c->pointCount = GetU32(entry + 24);
+  c->crc = GetU32(entry + 28);
+  c->bounds = (Rectangle){GetF32(entry + 32), GetF32(entry + 36), GetF32(entry + 40),
+                          GetF32(entry + 44)};
+  return c->strokeCount > 0 &&
+         c->size == (uint64_t)c->strokeCount * BINARY_STROKE_SIZE +
+                        (uint64_t)c->pointCount * sizeof(Point);
+}
+
+// Reads the index, fills the canvas with placeholders and loads the chunks in
+// the saved view. The rest stay on disk until CanvasStreamPending or
+// CanvasEnsureLoaded. Strokes borrow their points from a mapping of the file,
+// which saves keep valid by replacing files through rename.
+bool LoadCanvasChunked(Canvas *canvas, FILE *f, const uint8_t *header,
+                       uint64_t *baseEnd) {
+  uint32_t flags = GetU32(header + 4);
+  uint32_t strokeCount = GetU32(header + 8);
+  if (strokeCount > CanvasGetLoadLimits().maxStrokes)
+    return false;
+
+  uint8_t offsetBytes[8];
+  uint8_t prefix[CHUNKED_INDEX_PREFIX];
+  if (fread(offsetBytes, 1, sizeof(offsetBytes), f) != sizeof(offsetBytes))
+    return false;
+  uint64_t indexOffset = GetU64(offsetBytes);
+  if (indexOffset < MAPPED_PREAMBLE_SIZE || indexOffset > LONG_MAX ||
+      fseek(f, (long)indexOffset, SEEK_SET) != 0 ||
+      fread(prefix, 1, sizeof(prefix), f) != sizeof(prefix))
+    return false;
+  uint32_t chunkCount = GetU32(prefix);
+  if (chunkCount > strokeCount)
+    return false;
+
+  // A damaged index is rejected in one streaming pass, before anything is
+  // allocated. Chunks are checked as they are read.
+  if (flags & kBinaryFlagChunkChecksums) {
+    uint32_t indexCrc = Crc32c(0, kBinaryMagic, sizeof(kBinaryMagic));
+    indexCrc = Crc32c(indexCrc, header, BINARY_HEADER_SIZE);
+    indexCrc = Crc32c(indexCrc, offsetBytes, sizeof(offsetBytes));
+    for (uint32_t c = 0; c < chunkCount; c++) {
+      uint8_t entry[CHUNKED_ENTRY_SIZE];
+      if (fread(entry, 1, sizeof(entry), f) != sizeof(entry))
+        return false;
+      indexCrc = Crc32c(indexCrc, entry, sizeof(entry));
+    }
+    if (indexCrc != GetU32(prefix + 4)) {
+      fprintf(stderr, "Load: chunk index checksum mismatch\n");
+      return false;
+    }
+    if (fseek(f, (long)(indexOffset + CHUNKED_INDEX_PREFIX), SEEK_SET) != 0)
+      return false;
+  }
+
+  LazyFile *lf = (LazyFile *)calloc(1, sizeof(LazyFile));
+  if (!lf)
+    return false;
+  lf->flags = flags;
+  lf->chunkCount = chunkCount;
+  lf->pendingCount = chunkCount;
+  if (chunkCount > 0) {
+    lf->chunks = (ChunkInfo *)calloc(chunkCount, sizeof(ChunkInfo));
+    lf->batch = (uint32_t *)malloc(sizeof(uint32_t) * chunkCount);
+    if (!lf->chunks || !lf->batch) {
+      free(lf->chunks);
+      free(lf->batch);
+      free(lf);
+      return false;
+    }
+  }
+
+  uint32_t nextStroke = 0;
+  uint64_t totalPoints = 0;
+  for (uint32_t c = 0; c < chunkCount; c++) {
+    uint8_t entry[CHUNKED_ENTRY_SIZE];
+    ChunkInfo *chunk = &lf->chunks[c];
+    if (fread(entry, 1, sizeof(entry), f) != sizeof(entry))
+      goto fail;
+    if (!UnpackChunkEntry(entry, chunk) || chunk->firstStroke != nextStroke ||
+        chunk->strokeCount > strokeCount - nextStroke ||
+        chunk->offset < MAPPED_PREAMBLE_SIZE || chunk->offset > indexOffset ||
+        chunk->offset % sizeof(float) != 0 ||
+        chunk->size > indexOffset - chunk->offset ||
+        !PointsWithinLimits(totalPoints, chunk->pointCount))
+      goto fail;
+    nextStroke += chunk->strokeCount;
+    totalPoints += chunk->pointCount;
+  }
+  if (nextStroke != strokeCount)
+    goto fail;
+  *baseEnd = indexOffset + CHUNKED_INDEX_PREFIX + (uint64_t)chunkCount * CHUNKED_ENTRY_SIZE;
+
+  if (chunkCount > 0) {
+    lf->store = PointStoreMapFile(f);
+    if (!lf->store || lf->store->size < *baseEnd)
+      goto fail;
+  }
+
+  ClearCanvas(canvas);
+
+  Stroke *strokes = NULL;
+  if (strokeCount > 0) {
+    strokes = (Stroke *)calloc(strokeCount, sizeof(Stroke));
+    if (!strokes)
+      goto fail;
+  }
+  for (uint32_t c = 0; c < chunkCount; c++) {
+    const ChunkInfo *chunk = &lf->chunks[c];
+    for (uint32_t i = 0; i < chunk->strokeCount; i++) {
+      Stroke *s = &strokes[chunk->firstStroke + i];
+      s->lazyChunk = c + 1;
+      s->lazyIndex = i;
+      s->cacheVersion = 1;
+      s->cacheDirty = true;
+    }
+  }
+  PublishLoadedStrokes(canvas, header, strokes, strokeCount, 0);
+
+  if (chunkCount == 0) {
+    free(lf);
+    return true;
+  }
+  canvas->lazy = lf;
+  if (!StreamChunks(canvas, SavedCameraView(&canvas->camera), INFINITY, true)) {
+    ClearCanvas(canvas);
+    return false;
+  }
+  return true;
+
+fail:
+  PointStoreRelease(lf->store);
+  free(lf->chunks);
+  free(lf->batch);
+  free(lf);
+  return false;
+}
@@ -0,0 +1,37 @@
+#ifndef CANVAS_CHUNKED_H
+#define CANVAS_CHUNKED_H
+
+#include "canvas.h"
+#include <stdint.h>
+#include <stdio.h>
+
+// Large .cdraw files (v4): chunks of strokes listed in a trailing index.
+// Loads map the file, check the chunks in the saved view on several threads
+// and point their strokes into the mapping, and leave placeholders for the
+// rest to stream in (CanvasStreamPending).
+
+typedef struct {
+  uint64_t offset;
+  uint64_t size;
+  uint32_t firstStroke;
+  uint32_t strokeCount;
+  uint32_t pointCount;
+  uint32_t crc;
+  Rectangle bounds;
+  // Loader state.
+  Stroke *decoded;
+  bool queued; // picked for the batch being decoded
+  bool failed;
+  bool loaded;
+} ChunkInfo;
+
+bool WriteChunkedCanvas(const Canvas *canvas, FILE *f);
+bool LoadCanvasChunked(Canvas *canvas, FILE *f, const uint8_t *header,
+                       uint64_t *baseEnd);
+
+// False when the entry's size does not match its counts.
+bool UnpackChunkEntry(const uint8_t *entry, ChunkInfo *c);
+// pread all of `size` bytes, at offsets past what fseek takes too.
+bool ReadAt(int fd, uint8_t *out, uint64_t size, uint64_t offset);
+
+#endif // CANVAS_CHUNKED_H
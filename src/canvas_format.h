@@ -0,0 +1,142 @@
+#ifndef CANVAS_FORMAT_H
+#define CANVAS_FORMAT_H
+
+#include "canvas_internal.h"
+#include <stdint.h>
+#include <string.h>
+
+// Layout of .cdraw files and the helpers shared by their readers and writers:
+// v1, v2, v5 and text in canvas_io.c, v3 in canvas_packed.c, v4 in
+// canvas_chunked.c, journal frames in canvas_journal.c and checksums in
+// canvas_verify.c.
+
+static const char kBinaryMagic[4] = {'C', 'D', 'R', 'B'};
+// v1 stores each stroke record followed by its points. v2 puts the records
+// in a table and the points in 16-byte aligned blocks so a mapped file can be
+// used in place.
+static const uint32_t kBinaryVersionRecords = 1;
+static const uint32_t kBinaryVersionMapped = 2;
+// v3 packs v1-style stroke records with delta-coded points into LZ blocks.
+static const uint32_t kBinaryVersionPacked = 3;
+// v4 groups v1 records and points into chunks listed in a trailing index,
+// so large boards open with only what is on screen.
+static const uint32_t kBinaryVersionChunked = 4;
+// v5 is v2 with CRC32C checksums. Opening checks the header and stroke table
+// before anything is allocated; --verify checks the point blocks as well.
+// Uncompressed small boards save as v5.
+static const uint32_t kBinaryVersionChecked = 5;
+// Set when stroke records carry a shape byte; older files baked shapes into
+// points and had their arrows recognised by layout.
+static const uint32_t kBinaryFlagShapes = 1u << 0;
+// v4 only: the index and each chunk carry a CRC32C in pad bytes that older
+// readers skip.
+static const uint32_t kBinaryFlagChunkChecksums = 1u << 1;
+static const uint32_t kBinaryFlags = kBinaryFlagShapes;
+
+// Points are moved to and from disk as whole arrays, so the in-memory layout
+// must match the on-disk x, y, width float triple.
+typedef char PointLayoutCheck[(sizeof(Point) == 3 * sizeof(float)) ? 1 : -1];
+
+// Header after the magic: version, flags, strokeCount, six camera floats,
+// three colors, showGrid and three pad bytes.
+#define BINARY_HEADER_SIZE 52
+// Per-stroke record before its points: color, thickness, usePressure, three
+// pad bytes (the first holds the shape), pointCount.
+#define BINARY_STROKE_SIZE 16
+#define BINARY_STDIO_BUFFER (1 << 20)
+
+// v2: the header is followed by the u64 offset of the stroke table. Table
+// entries are a v1 stroke record with a u64 point block offset appended; each
+// block is a 16-byte prefix (u32 pointCount, zero pad) and then the points.
+#define MAPPED_TABLE_OFFSET_AT (4 + BINARY_HEADER_SIZE)
+#define MAPPED_PREAMBLE_SIZE (MAPPED_TABLE_OFFSET_AT + 8)
+#define MAPPED_ENTRY_SIZE (BINARY_STROKE_SIZE + 8)
+#define MAPPED_BLOCK_PREFIX 16
+#define MAPPED_ALIGN 16
+
+// v5: the v2 table offset is followed by the u32 CRC32C of the table and the
+// u32 CRC32C of the preamble up to it. Point block prefixes hold the CRC32C
+// of their points after the count.
+#define CHECKED_TABLE_CRC_AT (MAPPED_TABLE_OFFSET_AT + 8)
+#define CHECKED_PREAMBLE_CRC_AT (CHECKED_TABLE_CRC_AT + 4)
+#define CHECKED_PREAMBLE_SIZE (CHECKED_PREAMBLE_CRC_AT + 4)
+
+// v3: the header is followed by blocks of [u32 rawSize][u32 packedSize][data]
+// until every stroke is decoded; packedSize == rawSize means stored as is.
+// Records may span blocks. Points are zig-zag varint deltas of coordinates
+// quantized to 1/PACKED_SCALE world units.
+#define PACKED_BLOCK_SIZE (256 * 1024)
+#define PACKED_SCALE 1024.0
+#define PACKED_MAX_VARINT 10
+// Stroke record pad byte flag: one width for the whole stroke, not per point.
+#define PACKED_UNIFORM_WIDTH 0x01u
+
+// v4: like v2, the header is followed by a u64 index offset. Chunks of up to
+// CHUNKED_MAX_STROKES strokes and CHUNKED_MAX_POINTS points (unless a single
+// stroke is larger) hold v1 records with their points. The index is a u32
+// chunk count, four pad bytes, then per chunk: u64 offset, u64 size, u32
+// firstStroke, strokeCount and pointCount, four pad bytes and the f32 world
+// bounds x, y, width, height of everything the chunk draws. With
+// kBinaryFlagChunkChecksums, the index pad holds the CRC32C of the preamble
+// and the entries, and each entry's pad the CRC32C of its chunk.
+#define CHUNKED_INDEX_PREFIX 8
+#define CHUNKED_ENTRY_SIZE 48
+#define CHUNKED_MAX_STROKES 1024
+#define CHUNKED_MAX_POINTS (64 * 1024)
+
+static inline void PutU32(uint8_t *p, uint32_t value) { memcpy(p, &value, sizeof(value)); }
+
+static inline void PutF32(uint8_t *p, float value) { memcpy(p, &value, sizeof(value)); }
+
+static inline void PutColor(uint8_t *p, Color c) {
+  p[0] = c.r;
+  p[1] = c.g;
+  p[2] = c.b;
+  p[3] = c.a;
+}
+
+static inline void PutU64(uint8_t *p, uint64_t value) { memcpy(p, &value, sizeof(value)); }
+
+static inline uint32_t GetU32(const uint8_t *p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static inline float GetF32(const uint8_t *p) {
+  float value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static inline uint64_t GetU64(const uint8_t *p) {
+  uint64_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static inline Color GetColor(const uint8_t *p) { return (Color){p[0], p[1], p[2], p[3]}; }
+
+static inline uint64_t AlignUp(uint64_t value) {
+  return (value + (MAPPED_ALIGN - 1)) & ~(uint64_t)(MAPPED_ALIGN - 1);
+}
+
+// Headers, stroke records and loaded stroke arrays (canvas_io.c).
+void PackHeader(const Canvas *canvas, uint32_t version, uint32_t strokeCount,
+                uint8_t *header);
+void ApplyHeader(Canvas *canvas, const uint8_t *header);
+void PackStrokeRecord(const Stroke *s, uint8_t *record);
+// Fills everything but the points from a stroke record.
+Stroke UnpackStrokeRecord(const uint8_t *record, uint32_t flags);
+
+// `pointCount` more points still fit, in one stroke and in the canvas.
+bool PointsWithinLimits(uint64_t totalPoints, uint64_t pointCount);
+// Called with each stroke as it lands in the loading canvas. Returns false
+// when the load should stop: cancelled, or out of memory.
+bool FeedStroke(CanvasLoadFeed *feed, Stroke *s);
+void FreeLoadedStrokes(Stroke *strokes, uint32_t count);
+// Hands a freshly loaded stroke array to a cleared canvas.
+void PublishLoadedStrokes(Canvas *canvas, const uint8_t *header, Stroke *strokes,
+                          uint32_t strokeCount, uint64_t totalPoints);
+
+#endif // CANVAS_FORMAT_H
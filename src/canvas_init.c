@@ -1,4 +1,4 @@
-#include "canvas.h"
+#include "canvas_internal.h"
 #include <stdlib.h>
 
 void InitCanvas(Canvas *canvas, int screenWidth, int screenHeight) {
@@ -6,6 +6,10 @@ void InitCanvas(Canvas *canvas, int screenWidth, int screenHeight) {
   canvas->capacity = 0;
   canvas->strokes = NULL;
   canvas->totalPoints = 0;
+  canvas->boundsMin = (Vector2){0.0f, 0.0f};
+  canvas->boundsMax = (Vector2){0.0f, 0.0f};
+  canvas->hasBounds = false;
+  canvas->boundsStale = false;
 
   canvas->redoCount = 0;
   canvas->redoCapacity = 0;
@@ -22,12 +26,23 @@ void InitCanvas(Canvas *canvas, int screenWidth, int screenHeight) {
   canvas->currentStroke.pointCount = 0;
   canvas->currentStroke.capacity = 0;
   canvas->currentStroke.usePressure = false;
+  canvas->currentStroke.shape = STROKE_SHAPE_PATH;
+  canvas->currentStroke.store = NULL;
   canvas->currentStroke.cachedPoints = NULL;
   canvas->currentStroke.cachedCount = 0;
   canvas->currentStroke.cachedCapacity = 0;
   canvas->currentStroke.cacheVersion = 0;
   canvas->currentStroke.lastBuiltVersion = 0;
   canvas->currentStroke.cacheDirty = false;
+  canvas->currentStroke.boundsVersion = 0;
+  canvas->pen = (PenState){0};
+  canvas->simplifyTolerance = 0.35f;
+  canvas->lastCommitPointsIn = 0;
+  canvas->lastCommitPointsOut = 0;
+  canvas->compressSaves = false;
+  canvas->lazy = NULL;
+  canvas->journal = (CanvasJournal){0};
+  canvas->editCount = 0;
 
   canvas->backgroundColor = (Color){20, 20, 20, 255};
   canvas->gridColor = (Color){50, 50, 50, 255};
@@ -39,14 +54,16 @@ void InitCanvas(Canvas *canvas, int screenWidth, int screenHeight) {
 }
 
 void FreeCanvas(Canvas *canvas) {
+  CanvasCloseLazy(canvas);
+  JournalFree(canvas);
   for (int i = 0; i < canvas->strokeCount; i++) {
-    free(canvas->strokes[i].points);
+    StrokeFreePoints(&canvas->strokes[i]);
     free(canvas->strokes[i].cachedPoints);
   }
   free(canvas->strokes);
 
   for (int i = 0; i < canvas->redoCount; i++) {
-    free(canvas->redoStrokes[i].points);
+    StrokeFreePoints(&canvas->redoStrokes[i]);
     free(canvas->redoStrokes[i].cachedPoints);
   }
   free(canvas->redoStrokes);
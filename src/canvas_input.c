@@ -32,6 +32,15 @@ void UpdateCanvasState(Canvas *canvas, bool inputCaptured, int activeTool) {
     canvas->camera.target = Vector2Add(canvas->camera.target, delta);
   }
 
+  if (canvas->lazy) {
+    Vector2 tl = GetScreenToWorld2D((Vector2){0, 0}, canvas->camera);
+    Vector2 br = GetScreenToWorld2D(
+        (Vector2){(float)GetScreenWidth(), (float)GetScreenHeight()}, canvas->camera);
+    Rectangle view = {fminf(tl.x, br.x), fminf(tl.y, br.y), fabsf(br.x - tl.x),
+                      fabsf(br.y - tl.y)};
+    CanvasStreamPending(canvas, view, 0.004);
+  }
+
   CanvasInputHandleEditTools(canvas, inputCaptured, isPanning, activeTool);
   CanvasInputHandleDrawTools(canvas, inputCaptured, isPanning, activeTool);
 }
@@ -1,4 +1,5 @@
 #include "canvas_internal.h"
+#include "input_capture.h"
 #include "raymath.h"
 #include <math.h>
 #include <stdio.h>
@@ -32,50 +33,231 @@ static float PenWidthFromSpeed(float base, float speed) {
   return maxW + (minW - maxW) * t;
 }
 
-static void CreateCircleStroke(Stroke *s, Point start, Point end) {
-  Vector2 c = {start.x, start.y};
-  float dx = end.x - start.x;
-  float dy = end.y - start.y;
-  float radius = sqrtf(dx * dx + dy * dy);
+static InputSample gSamples[INPUT_CAPTURE_CAPACITY];
 
-  const int segments = 64;
-  for (int i = 0; i < segments; i++) {
-    float a = (float)i / (float)segments * PI * 2.0f;
-    AddPoint(s, (Point){c.x + cosf(a) * radius, c.y + sinf(a) * radius});
+// One-Euro filter tuning. Cutoffs are in Hz; beta scales the cutoff with the
+// on-screen pen speed in pixels per second.
+static const float kEuroMinCutoff = 3.0f;
+static const float kEuroBeta = 0.02f;
+static const float kEuroDerivCutoff = 1.0f;
+
+static float EuroAlpha(float cutoff, float dt) {
+  float tau = 1.0f / (2.0f * PI * cutoff);
+  return 1.0f / (1.0f + tau / dt);
+}
+
+// Shortest frame interval assumed when deciding a prediction is stale.
+static const float kPenPredictMinFrame = 1.0f / 60.0f;
+
+static float PenSpacing(const Stroke *s) { return fmaxf(0.75f, s->thickness * 0.2f); }
+
+static void PenReset(Canvas *canvas, Vector2 start, double time) {
+  PenState *pen = &canvas->pen;
+  pen->lastTime = time;
+  pen->filtered = start;
+  pen->velocity = (Vector2){0.0f, 0.0f};
+  pen->walkFrom = start;
+  pen->carry = 0.0f;
+  pen->lastRaw = start;
+  pen->runLength = 0.0f;
+  pen->accel = (Vector2){0.0f, 0.0f};
+  pen->predictedCount = 0;
+  pen->smoothedPoints = 0;
+}
+
+// Stores a resampled point, folding it into the previous one when the three
+// most recent points are collinear and their widths agree.
+static void PenStorePoint(Canvas *canvas, Point p) {
+  Stroke *s = &canvas->currentStroke;
+  PenState *pen = &canvas->pen;
+  float spacing = PenSpacing(s);
+  if (s->pointCount >= 3) {
+    Point a = s->points[s->pointCount - 2];
+    Point b = s->points[s->pointCount - 1];
+    Vector2 ac = {p.x - a.x, p.y - a.y};
+    float acLen = sqrtf(ac.x * ac.x + ac.y * ac.y);
+    float runLength = pen->runLength + Vector2Distance((Vector2){b.x, b.y},
+                                                       (Vector2){p.x, p.y});
+    if (acLen > 0.0001f && runLength <= spacing * 8.0f) {
+      float dev = fabsf((b.x - a.x) * ac.y - (b.y - a.y) * ac.x) / acLen;
+      float t = ((b.x - a.x) * ac.x + (b.y - a.y) * ac.y) / (acLen * acLen);
+      float widthAt = a.width + (p.width - a.width) * ClampFloat(t, 0.0f, 1.0f);
+      if (t > 0.0f && t < 1.0f && dev <= fmaxf(0.02f, spacing * 0.05f) &&
+          fabsf(b.width - widthAt) <= fmaxf(0.05f, s->thickness * 0.02f)) {
+        s->points[s->pointCount - 1] = p;
+        s->cacheDirty = true;
+        s->cacheVersion++;
+        pen->runLength = runLength;
+        return;
+      }
+    }
+  }
+  AddPoint(s, p);
+  pen->runLength = 0.0f;
+  if (s->pointCount == 2)
+    s->points[0].width = (s->points[0].width + p.width) * 0.5f;
+}
+
+// Ingests one raw pen sample: One-Euro filtering against jitter, then
+// resampling the filtered path to a fixed arc-length spacing.
+static void PenIngestSample(Canvas *canvas, Vector2 raw, double time) {
+  PenState *pen = &canvas->pen;
+  Stroke *s = &canvas->currentStroke;
+  float dt = (float)(time - pen->lastTime);
+  if (dt <= 0.0f)
+    dt = 0.0001f;
+  pen->lastTime = time;
+  pen->lastRaw = raw;
+
+  Vector2 rawVel = Vector2Scale(Vector2Subtract(raw, pen->filtered), 1.0f / dt);
+  Vector2 prevVel = pen->velocity;
+  pen->velocity = Vector2Lerp(pen->velocity, rawVel,
+                              EuroAlpha(kEuroDerivCutoff, dt));
+  Vector2 rawAccel = Vector2Scale(Vector2Subtract(pen->velocity, prevVel), 1.0f / dt);
+  pen->accel = Vector2Lerp(pen->accel, rawAccel, EuroAlpha(kEuroDerivCutoff, dt));
+  float speed = Vector2Length(pen->velocity);
+  float screenSpeed = speed * canvas->camera.zoom;
+  float cutoff = kEuroMinCutoff + kEuroBeta * screenSpeed;
+  pen->filtered = Vector2Lerp(pen->filtered, raw, EuroAlpha(cutoff, dt));
+
+  float spacing = PenSpacing(s);
+  float width = PenWidthFromSpeed(s->thickness, speed);
+  Vector2 from = pen->walkFrom;
+  Vector2 to = pen->filtered;
+  float segLen = Vector2Distance(from, to);
+  float walked = 0.0f;
+  while (pen->carry + (segLen - walked) >= spacing) {
+    walked += spacing - pen->carry;
+    pen->carry = 0.0f;
+    Vector2 q = Vector2Lerp(from, to, walked / segLen);
+    PenStorePoint(canvas, (Point){q.x, q.y, width});
   }
+  pen->carry += segLen - walked;
+  pen->walkFrom = to;
+}
 
-  // Close the loop exactly (avoid float drift between 0 and 2*PI).
-  if (s->pointCount > 0)
-    AddPoint(s, s->points[0]);
+// Ends the stroke exactly where the pen was lifted; the filter lags a little
+// behind the raw position at low speed.
+static void PenFinish(Canvas *canvas) {
+  Stroke *s = &canvas->currentStroke;
+  if (s->pointCount < 1)
+    return;
+  Point last = s->points[s->pointCount - 1];
+  Vector2 end = canvas->pen.lastRaw;
+  if (Vector2Distance((Vector2){last.x, last.y}, end) < PenSpacing(s) * 0.25f)
+    return;
+  float width = (s->pointCount > 1) ? last.width : s->thickness;
+  PenStorePoint(canvas, (Point){end.x, end.y, width});
 }
 
-static void CreateArrowStroke(Stroke *s, Point start, Point end, float thickness) {
-  Vector2 a = {start.x, start.y};
-  Vector2 b = {end.x, end.y};
-  Vector2 ab = Vector2Subtract(b, a);
-  float len = Vector2Length(ab);
+// Extrapolates the pen from its filtered velocity and acceleration to where
+// it will be when this frame is shown, covering the filter lag, the time
+// since the last sample and one frame of presentation delay.
+static void PenPredict(Canvas *canvas) {
+  PenState *pen = &canvas->pen;
+  Stroke *s = &canvas->currentStroke;
+  pen->predictedCount = 0;
+  if (s->pointCount < 2)
+    return;
+
+  // A pen held still sends no samples, so the last velocity goes stale; past
+  // about a frame without one (with slack for jitter) there is nothing to
+  // extrapolate.
+  float idle = (float)(InputCaptureNow() - pen->lastTime);
+  float frame = GetFrameTime();
+  if (idle > fmaxf(frame, kPenPredictMinFrame) * 1.5f)
+    return;
 
-  AddPoint(s, start);
-  if (len <= 0.0001f) {
-    AddPoint(s, end);
+  float zoom = fmaxf(canvas->camera.zoom, 0.001f);
+  float horizon = ClampFloat(idle + frame, 0.0f, 0.05f);
+  float speed = Vector2Length(pen->velocity);
+  if (speed * zoom < 30.0f || horizon <= 0.0f)
     return;
+
+  // Stop where braking would reverse the motion instead of swinging back.
+  float along = Vector2DotProduct(pen->accel, pen->velocity) / speed;
+  if (along < 0.0f)
+    horizon = fminf(horizon, speed / -along);
+  float maxReach = 48.0f / zoom;
+
+  float width = s->points[s->pointCount - 1].width;
+  Vector2 base = pen->filtered;
+  pen->predicted[pen->predictedCount++] = (Point){base.x, base.y, width};
+  int steps = PEN_PREDICTED_MAX - 1;
+  for (int i = 1; i <= steps; i++) {
+    float t = horizon * (float)i / (float)steps;
+    Vector2 offset = Vector2Add(Vector2Scale(pen->velocity, t),
+                                Vector2Scale(pen->accel, 0.5f * t * t));
+    float reach = Vector2Length(offset);
+    if (reach > maxReach)
+      offset = Vector2Scale(offset, maxReach / reach);
+    Vector2 q = Vector2Add(base, offset);
+    pen->predicted[pen->predictedCount++] = (Point){q.x, q.y, width};
+    if (reach > maxReach)
+      break;
   }
 
-  Vector2 dir = Vector2Scale(ab, 1.0f / len);
-  Vector2 perp = (Vector2){-dir.y, dir.x};
+  // Reserve room so the renderer can append the tail without allocating.
+  int needed = s->pointCount + pen->predictedCount;
+  if (s->capacity < needed) {
+    int newCap = s->capacity;
+    while (newCap < needed)
+      newCap *= 2;
+    Point *next = (Point *)realloc(s->points, sizeof(Point) * (size_t)newCap);
+    if (!next) {
+      pen->predictedCount = 0;
+      return;
+    }
+    s->points = next;
+    s->capacity = newCap;
+  }
+}
 
-  float headLen = fmaxf(16.0f, thickness * 4.0f);
-  headLen = fminf(headLen, len * 0.5f);
-  float headW = fmaxf(thickness * 3.0f, headLen * 1.10f);
+static void AddPenSamples(Canvas *canvas, const InputSample *samples, int count,
+                          bool requireDown) {
+  for (int i = 0; i < count; i++) {
+    if (requireDown && !samples[i].down)
+      continue;
+    Vector2 m = GetScreenToWorld2D((Vector2){samples[i].x, samples[i].y},
+                                   canvas->camera);
+    PenIngestSample(canvas, m, samples[i].time);
+  }
+}
 
-  Vector2 base = Vector2Subtract(b, Vector2Scale(dir, headLen));
-  Vector2 left = Vector2Add(base, Vector2Scale(perp, headW * 0.5f));
-  Vector2 right = Vector2Subtract(base, Vector2Scale(perp, headW * 0.5f));
+// Drops points the outline does not need before the stroke is committed and
+// trims the buffer to fit.
+static void SimplifyCurrentStroke(Canvas *canvas) {
+  Stroke *s = &canvas->currentStroke;
+  int before = s->pointCount;
+  float zoom = fmaxf(canvas->camera.zoom, 0.001f);
+  s->pointCount =
+      SimplifyStrokePoints(s->points, s->pointCount, canvas->simplifyTolerance / zoom);
+  if (s->pointCount < s->capacity) {
+    Point *fit = (Point *)realloc(s->points, sizeof(Point) * (size_t)s->pointCount);
+    if (fit) {
+      s->points = fit;
+      s->capacity = s->pointCount;
+    }
+  }
+  if (s->pointCount != before) {
+    s->cacheDirty = true;
+    s->cacheVersion++;
+  }
+  canvas->lastCommitPointsIn = before;
+  canvas->lastCommitPointsOut = s->pointCount;
+}
 
-  AddPoint(s, end);
-  AddPoint(s, (Point){left.x, left.y});
-  AddPoint(s, (Point){right.x, right.y});
-  AddPoint(s, end);
+static StrokeShape ToolShape(int activeTool) {
+  switch (activeTool) {
+  case TOOL_LINE:
+    return STROKE_SHAPE_ARROW;
+  case TOOL_RECT:
+    return STROKE_SHAPE_RECT;
+  case TOOL_CIRCLE:
+    return STROKE_SHAPE_CIRCLE;
+  default:
+    return STROKE_SHAPE_PATH;
+  }
 }
 
 void CanvasInputHandleDrawTools(Canvas *canvas, bool inputCaptured, bool isPanning,
@@ -86,15 +268,34 @@ void CanvasInputHandleDrawTools(Canvas *canvas, bool inputCaptured, bool isPanni
   bool drawingInput =
       drawTool && IsMouseButtonDown(MOUSE_BUTTON_LEFT) && !isPanning && !inputCaptured;
 
+  Vector2 mouse = GetMousePosition();
+  double polled = InputCaptureNow();
+  InputCapturePoll(mouse.x, mouse.y, IsMouseButtonDown(MOUSE_BUTTON_LEFT));
+  int sampleCount = InputCaptureDrain(gSamples, INPUT_CAPTURE_CAPACITY);
+
   if (drawingInput) {
-    Vector2 m = GetScreenToWorld2D(GetMousePosition(), canvas->camera);
+    Vector2 m = GetScreenToWorld2D(mouse, canvas->camera);
     Point p = {m.x, m.y};
     if (!canvas->isDrawing) {
+      // The stroke starts at the first sample taken with the button down, on
+      // that sample's own clock; samples before it belong to the hover
+      // motion. Without one yet, it starts where and when this frame polled.
+      int first = 0;
+      while (first < sampleCount && !gSamples[first].down)
+        first++;
+      double startTime = polled;
+      if (first < sampleCount) {
+        m = GetScreenToWorld2D((Vector2){gSamples[first].x, gSamples[first].y},
+                               canvas->camera);
+        p = (Point){m.x, m.y};
+        startTime = gSamples[first].time;
+      }
       canvas->isDrawing = true;
       canvas->currentStroke.pointCount = 0;
       canvas->currentStroke.capacity = 0;
       canvas->currentStroke.points = NULL;
       canvas->currentStroke.usePressure = (activeTool == TOOL_PEN);
+      canvas->currentStroke.shape = ToolShape(activeTool);
       canvas->currentStroke.cachedPoints = NULL;
       canvas->currentStroke.cachedCount = 0;
       canvas->currentStroke.cachedCapacity = 0;
@@ -107,6 +308,9 @@ void CanvasInputHandleDrawTools(Canvas *canvas, bool inputCaptured, bool isPanni
           canvas->currentStroke.usePressure ? canvas->currentStroke.thickness : 0.0f;
       canvas->startPoint = (Point){p.x, p.y, startWidth};
       AddPoint(&canvas->currentStroke, (Point){p.x, p.y, startWidth});
+      PenReset(canvas, m, startTime);
+      if (activeTool == TOOL_PEN && first < sampleCount)
+        AddPenSamples(canvas, gSamples + first + 1, sampleCount - first - 1, true);
       fprintf(stderr, "Start Drawing. Tool: %d at %.1f, %.1f\n", activeTool, p.x,
               p.y);
       return;
@@ -114,6 +318,7 @@ void CanvasInputHandleDrawTools(Canvas *canvas, bool inputCaptured, bool isPanni
 
     Stroke *s = &canvas->currentStroke;
     if (activeTool == TOOL_PEN && shift) {
+      canvas->pen.predictedCount = 0;
       s->pointCount = 0;
       Point start = canvas->startPoint;
       float width = canvas->currentStroke.thickness;
@@ -122,45 +327,32 @@ void CanvasInputHandleDrawTools(Canvas *canvas, bool inputCaptured, bool isPanni
       return;
     }
     if (activeTool == TOOL_PEN) {
-      Point last = s->points[s->pointCount - 1];
-      float dx = p.x - last.x;
-      float dy = p.y - last.y;
-      float base = canvas->currentStroke.thickness;
-      float distSq = dx * dx + dy * dy;
-      float minDist = fmaxf(0.75f, base * 0.2f);
-      if (distSq > minDist * minDist) {
-        float dist = sqrtf(distSq);
-        float dt = fmaxf(GetFrameTime(), 0.0001f);
-        float speed = dist / dt;
-        float width = PenWidthFromSpeed(base, speed);
-        AddPoint(s, (Point){p.x, p.y, width});
-        if (s->pointCount == 2)
-          s->points[0].width = (s->points[0].width + width) * 0.5f;
-      }
+      AddPenSamples(canvas, gSamples, sampleCount, false);
+      PenPredict(canvas);
       return;
     }
 
+    // Shape tools keep just their two control points; see StrokeShape.
     s->pointCount = 0;
-    Point start = canvas->startPoint;
-    if (activeTool == TOOL_LINE) {
-      CreateArrowStroke(s, start, p, canvas->currentStroke.thickness);
-    } else if (activeTool == TOOL_RECT) {
-      AddPoint(s, start);
-      AddPoint(s, (Point){p.x, start.y});
-      AddPoint(s, (Point){p.x, p.y});
-      AddPoint(s, (Point){start.x, p.y});
-      AddPoint(s, start);
-    } else if (activeTool == TOOL_CIRCLE) {
-      CreateCircleStroke(s, start, p);
-    }
+    AddPoint(s, canvas->startPoint);
+    AddPoint(s, p);
     return;
   }
 
   if (!canvas->isDrawing)
     return;
 
+  // Motion between the last frame and the release still belongs to the stroke.
+  if (activeTool == TOOL_PEN && canvas->currentStroke.usePressure && !shift) {
+    AddPenSamples(canvas, gSamples, sampleCount, true);
+    PenFinish(canvas);
+  }
+
   canvas->isDrawing = false;
+  canvas->pen.predictedCount = 0;
   if (canvas->currentStroke.pointCount > 1) {
+    if (canvas->currentStroke.usePressure)
+      SimplifyCurrentStroke(canvas);
     AddStroke(canvas, canvas->currentStroke);
     fprintf(stderr, "Finished Stroke. Points: %d\n", canvas->currentStroke.pointCount);
     canvas->currentStroke.points = NULL;
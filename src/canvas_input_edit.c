@@ -3,6 +3,7 @@
 #include <float.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 static float DistPointSegSq(Vector2 p, Vector2 a, Vector2 b) {
   Vector2 ab = Vector2Subtract(b, a);
@@ -15,15 +16,15 @@ static float DistPointSegSq(Vector2 p, Vector2 a, Vector2 b) {
   return Vector2DistanceSqr(p, proj);
 }
 
-static float StrokeMinDistSq(const Stroke *s, Vector2 p) {
-  if (s->pointCount == 0)
+static float PointsMinDistSq(const Point *points, int count, Vector2 p) {
+  if (count == 0)
     return FLT_MAX;
-  if (s->pointCount == 1)
-    return Vector2DistanceSqr(p, (Vector2){s->points[0].x, s->points[0].y});
+  if (count == 1)
+    return Vector2DistanceSqr(p, (Vector2){points[0].x, points[0].y});
   float best = FLT_MAX;
-  for (int i = 0; i < s->pointCount - 1; i++) {
-    Vector2 a = {s->points[i].x, s->points[i].y};
-    Vector2 b = {s->points[i + 1].x, s->points[i + 1].y};
+  for (int i = 0; i < count - 1; i++) {
+    Vector2 a = {points[i].x, points[i].y};
+    Vector2 b = {points[i + 1].x, points[i + 1].y};
     float d2 = DistPointSegSq(p, a, b);
     if (d2 < best)
       best = d2;
@@ -31,6 +32,21 @@ static float StrokeMinDistSq(const Stroke *s, Vector2 p) {
   return best;
 }
 
+static float StrokeMinDistSq(const Stroke *s, Vector2 p) {
+  if (s->shape == STROKE_SHAPE_CIRCLE && s->pointCount >= 2) {
+    Vector2 c = {s->points[0].x, s->points[0].y};
+    float d = Vector2Distance(p, c) - StrokeCircleRadius(s);
+    return d * d;
+  }
+  if (s->shape == STROKE_SHAPE_RECT && s->pointCount >= 2) {
+    Point outline[5];
+    int count = StrokeOutline(s, 1.0f, outline);
+    return PointsMinDistSq(outline, count, p);
+  }
+  // Paths, and arrows through their shaft.
+  return PointsMinDistSq(s->points, s->pointCount, p);
+}
+
 static int FindStrokeHit(const Canvas *canvas, Vector2 p, float radiusWorld) {
   float bestD2 = radiusWorld * radiusWorld;
   int bestIdx = -1;
@@ -48,28 +64,346 @@ static int FindStrokeHit(const Canvas *canvas, Vector2 p, float radiusWorld) {
   return bestIdx;
 }
 
-static void TranslateStroke(Stroke *s, Vector2 delta) {
-  for (int i = 0; i < s->pointCount; i++) {
-    s->points[i].x += delta.x;
-    s->points[i].y += delta.y;
-  }
+// Replaces a rectangle or circle with its outline at the current zoom so the
+// eraser can cut it like any other closed path.
+static bool BakeStrokeShape(Canvas *canvas, Stroke *s) {
+  int count = StrokeOutlineCount(s, canvas->camera.zoom);
+  Point *outline = (Point *)malloc(sizeof(Point) * (size_t)count);
+  if (!outline)
+    return false;
+  count = StrokeOutline(s, canvas->camera.zoom, outline);
+  CanvasBoundsRemove(canvas, s);
+  canvas->totalPoints += count - s->pointCount;
+  StrokeFreePoints(s);
+  s->points = outline;
+  s->pointCount = count;
+  s->capacity = count;
+  s->shape = STROKE_SHAPE_PATH;
   s->cacheDirty = true;
   s->cacheVersion++;
+  CanvasBoundsAdd(canvas, s);
+  JournalRecordReplace(canvas, (int)(s - canvas->strokes), s);
+  return true;
+}
+
+// Parametric span [t0, t1] of segment a-b that lies inside the eraser disc.
+static bool SegmentDiscSpan(Vector2 a, Vector2 b, Vector2 c, float r, float *t0,
+                            float *t1) {
+  Vector2 d = Vector2Subtract(b, a);
+  Vector2 f = Vector2Subtract(a, c);
+  float qa = Vector2DotProduct(d, d);
+  float qc = Vector2DotProduct(f, f) - r * r;
+  if (qa <= 0.000001f) {
+    if (qc > 0.0f)
+      return false;
+    *t0 = 0.0f;
+    *t1 = 1.0f;
+    return true;
+  }
+  float qb = 2.0f * Vector2DotProduct(f, d);
+  float disc = qb * qb - 4.0f * qa * qc;
+  if (disc < 0.0f)
+    return false;
+  float sq = sqrtf(disc);
+  float lo = (-qb - sq) / (2.0f * qa);
+  float hi = (-qb + sq) / (2.0f * qa);
+  if (hi < 0.0f || lo > 1.0f)
+    return false;
+  *t0 = Clamp(lo, 0.0f, 1.0f);
+  *t1 = Clamp(hi, 0.0f, 1.0f);
+  return true;
+}
+
+static Point LerpPoint(Point a, Point b, float t) {
+  return (Point){a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t,
+                 a.width + (b.width - a.width) * t};
+}
+
+// A surviving run of a stroke: original points [first, last] plus optional
+// clipped endpoints where the run meets the eraser boundary.
+typedef struct {
+  int first;
+  int last;
+  bool hasStart;
+  bool hasEnd;
+  Point start;
+  Point end;
+} StrokePiece;
+
+static int PieceCount(const StrokePiece *piece) {
+  int count = (piece->last >= piece->first) ? piece->last - piece->first + 1 : 0;
+  return count + (piece->hasStart ? 1 : 0) + (piece->hasEnd ? 1 : 0);
+}
+
+static void WritePiece(Point *dst, const Point *src, const StrokePiece *piece) {
+  int n = 0;
+  if (piece->hasStart)
+    n++;
+  if (piece->last >= piece->first)
+    memmove(dst + n, src + piece->first,
+            sizeof(Point) * (size_t)(piece->last - piece->first + 1));
+  if (piece->hasStart)
+    dst[0] = piece->start;
+  if (piece->last >= piece->first)
+    n += piece->last - piece->first + 1;
+  if (piece->hasEnd)
+    dst[n] = piece->end;
 }
 
-static void RemoveStrokeAtIndex(Canvas *canvas, int index) {
-  if (index < 0 || index >= canvas->strokeCount)
+static bool PushPiece(StrokePiece **pieces, int *count, int *cap,
+                      StrokePiece *stackBuf, StrokePiece piece) {
+  if (PieceCount(&piece) < 2)
+    return true;
+  if (*count >= *cap) {
+    int newCap = *cap * 2;
+    StrokePiece *next = (StrokePiece *)malloc(sizeof(StrokePiece) * (size_t)newCap);
+    if (!next)
+      return false;
+    memcpy(next, *pieces, sizeof(StrokePiece) * (size_t)*count);
+    if (*pieces != stackBuf)
+      free(*pieces);
+    *pieces = next;
+    *cap = newCap;
+  }
+  (*pieces)[(*count)++] = piece;
+  return true;
+}
+
+static Stroke PieceStroke(const Stroke *src, Point *points, int count) {
+  Stroke s = *src;
+  s.points = points;
+  s.store = NULL;
+  s.pointCount = count;
+  s.capacity = count;
+  s.cachedPoints = NULL;
+  s.cachedCount = 0;
+  s.cachedCapacity = 0;
+  s.cacheVersion = 1;
+  s.lastBuiltVersion = 0;
+  s.cacheDirty = true;
+  s.boundsVersion = 0;
+  return s;
+}
+
+// The cached bounds of stroke `s` grown by half its thickness plus `extra`.
+static bool StrokeReach(const Stroke *s, float extra, Rectangle *out) {
+  Rectangle r;
+  if (!StrokeGetBounds(s, &r))
+    return false;
+  float pad = s->thickness * 0.5f + extra;
+  *out = (Rectangle){r.x - pad, r.y - pad, r.width + pad * 2.0f,
+                     r.height + pad * 2.0f};
+  return true;
+}
+
+// Whether stroke `s` can reach into `area`. Uses the cached bounds, so
+// strokes far from the eraser cost no point walk.
+static bool StrokeMayTouch(const Stroke *s, Rectangle area) {
+  Rectangle r;
+  return StrokeReach(s, 0.0f, &r) && CheckCollisionRecs(r, area);
+}
+
+// Parametric span [t0, t1] of segment a-b inside `area` (slab clipping).
+static bool SegmentRectSpan(Vector2 a, Vector2 b, Rectangle area, float *t0,
+                            float *t1) {
+  float lo = 0.0f, hi = 1.0f;
+  float from[2] = {a.x, a.y};
+  float d[2] = {b.x - a.x, b.y - a.y};
+  float min[2] = {area.x, area.y};
+  float max[2] = {area.x + area.width, area.y + area.height};
+  for (int k = 0; k < 2; k++) {
+    if (fabsf(d[k]) < 1e-12f) {
+      if (from[k] < min[k] || from[k] > max[k])
+        return false;
+      continue;
+    }
+    float ta = (min[k] - from[k]) / d[k];
+    float tb = (max[k] - from[k]) / d[k];
+    lo = fmaxf(lo, fminf(ta, tb));
+    hi = fminf(hi, fmaxf(ta, tb));
+  }
+  if (lo > hi)
+    return false;
+  *t0 = lo;
+  *t1 = hi;
+  return true;
+}
+
+static Rectangle DiscBounds(Vector2 center, float radius) {
+  return (Rectangle){center.x - radius, center.y - radius, radius * 2.0f,
+                     radius * 2.0f};
+}
+
+// Cuts the parts of stroke `index` that fall inside the eraser disc and
+// replaces it with the surviving pieces. One piece keeps the original point
+// and cache buffers; only the additional pieces allocate.
+static void EraseStrokeSpan(Canvas *canvas, int index, Vector2 center,
+                            float radius) {
+  Stroke *s = &canvas->strokes[index];
+  if (!StrokeMayTouch(s, DiscBounds(center, radius)))
+    return;
+  if (s->shape != STROKE_SHAPE_PATH) {
+    if (StrokeMinDistSq(s, center) > radius * radius)
+      return;
+    // Arrows are removed whole; other shapes are cut along their outline.
+    if (s->shape == STROKE_SHAPE_ARROW || !BakeStrokeShape(canvas, s)) {
+      CanvasRemoveStroke(canvas, index);
+      return;
+    }
+  }
+
+  int n = s->pointCount;
+  if (n <= 0)
+    return;
+  if (n == 1) {
+    Vector2 p = {s->points[0].x, s->points[0].y};
+    if (Vector2DistanceSqr(p, center) <= radius * radius)
+      CanvasRemoveStroke(canvas, index);
     return;
-  canvas->totalPoints -= canvas->strokes[index].pointCount;
-  free(canvas->strokes[index].points);
-  free(canvas->strokes[index].cachedPoints);
-  for (int i = index; i < canvas->strokeCount - 1; i++)
-    canvas->strokes[i] = canvas->strokes[i + 1];
-  canvas->strokeCount--;
-  if (canvas->selectedStrokeIndex == index)
-    canvas->selectedStrokeIndex = -1;
-  else if (canvas->selectedStrokeIndex > index)
-    canvas->selectedStrokeIndex--;
+  }
+
+  int firstHit = -1;
+  for (int i = 0; i < n - 1; i++) {
+    float t0, t1;
+    if (SegmentDiscSpan((Vector2){s->points[i].x, s->points[i].y},
+                        (Vector2){s->points[i + 1].x, s->points[i + 1].y},
+                        center, radius, &t0, &t1)) {
+      firstHit = i;
+      break;
+    }
+  }
+  if (firstHit < 0 || !StrokeMakePointsWritable(s))
+    return;
+
+  StrokePiece stackPieces[16];
+  StrokePiece *pieces = stackPieces;
+  int pieceCount = 0;
+  int pieceCap = (int)(sizeof(stackPieces) / sizeof(stackPieces[0]));
+  Stroke *outs = NULL;
+
+  StrokePiece cur = {0, firstHit, false, false, {0}, {0}};
+  bool open = true;
+  for (int i = firstHit; i < n - 1; i++) {
+    Point pa = s->points[i];
+    Point pb = s->points[i + 1];
+    float t0, t1;
+    if (!SegmentDiscSpan((Vector2){pa.x, pa.y}, (Vector2){pb.x, pb.y}, center,
+                         radius, &t0, &t1)) {
+      if (!open)
+        cur = (StrokePiece){i, i, false, false, {0}, {0}};
+      open = true;
+      cur.last = i + 1;
+      continue;
+    }
+
+    if (open) {
+      // Close the running piece where the segment enters the disc.
+      cur.last = i;
+      if (t0 > 0.0f) {
+        cur.hasEnd = true;
+        cur.end = LerpPoint(pa, pb, t0);
+      }
+      if (!PushPiece(&pieces, &pieceCount, &pieceCap, stackPieces, cur))
+        goto done;
+      open = false;
+    }
+
+    if (t1 < 1.0f) {
+      // Resume where the segment leaves the disc.
+      cur = (StrokePiece){i + 1, i + 1, true, false, LerpPoint(pa, pb, t1), {0}};
+      open = true;
+    }
+  }
+  if (open && !PushPiece(&pieces, &pieceCount, &pieceCap, stackPieces, cur))
+    goto done;
+
+  if (pieceCount == 0) {
+    CanvasRemoveStroke(canvas, index);
+    goto done;
+  }
+
+  Point *joined = NULL;
+  int joinedCount = 0;
+  Point head0 = s->points[0];
+  Point tailN = s->points[n - 1];
+  float seamDx = head0.x - tailN.x;
+  float seamDy = head0.y - tailN.y;
+  if (pieceCount > 1 && n > 3 && seamDx * seamDx + seamDy * seamDy <= 0.0001f &&
+      pieces[0].first == 0 && !pieces[0].hasStart &&
+      pieces[pieceCount - 1].last == n - 1 && !pieces[pieceCount - 1].hasEnd) {
+    // Closed shape cut in several places: the runs on both sides of the seam
+    // are one piece.
+    StrokePiece tail = pieces[pieceCount - 1];
+    StrokePiece headRest = pieces[0];
+    headRest.first = 1;
+    int tailCount = PieceCount(&tail);
+    joinedCount = tailCount + PieceCount(&headRest);
+    joined = (Point *)malloc(sizeof(Point) * (size_t)joinedCount);
+    if (joined) {
+      WritePiece(joined, s->points, &tail);
+      WritePiece(joined + tailCount, s->points, &headRest);
+      for (int i = 0; i + 1 < pieceCount - 1; i++)
+        pieces[i] = pieces[i + 1];
+      pieceCount -= 2;
+    }
+  }
+
+  // Every allocation happens before the stroke changes: when one fails the
+  // erase is abandoned and the stroke stays whole.
+  int outCount = pieceCount + (joined ? 1 : 0);
+  outs = (Stroke *)malloc(sizeof(Stroke) * (size_t)outCount);
+  if (!outs || !CanvasReserveStrokes(canvas, outCount - 1)) {
+    free(joined);
+    goto done;
+  }
+  s = &canvas->strokes[index];
+
+  // Copy out every piece but the first before the first one is compacted
+  // into the original buffer, which may overwrite their source points.
+  int built = 0;
+  if (joined)
+    outs[built++] = PieceStroke(s, joined, joinedCount);
+  for (int i = 1; i < pieceCount; i++) {
+    int count = PieceCount(&pieces[i]);
+    Point *buf = (Point *)malloc(sizeof(Point) * (size_t)count);
+    if (!buf) {
+      for (int j = 0; j < built; j++)
+        free(outs[j].points);
+      goto done;
+    }
+    WritePiece(buf, s->points, &pieces[i]);
+    outs[built++] = PieceStroke(s, buf, count);
+  }
+
+  Stroke reused = *s;
+  if (pieceCount > 0) {
+    WritePiece(reused.points, reused.points, &pieces[0]);
+    reused.pointCount = PieceCount(&pieces[0]);
+    reused.cacheDirty = true;
+    reused.cacheVersion++;
+  } else {
+    StrokeFreePoints(&reused);
+    free(reused.cachedPoints);
+    reused = outs[--built];
+  }
+
+  CanvasBoundsRemove(canvas, s);
+  canvas->totalPoints += reused.pointCount - s->pointCount;
+  *s = reused;
+  CanvasBoundsAdd(canvas, s);
+  JournalRecordReplace(canvas, index, s);
+  for (int i = 0; i < built; i++) {
+    if (!CanvasInsertStroke(canvas, index + 1 + i, outs[i])) {
+      for (int j = i; j < built; j++)
+        free(outs[j].points);
+      break;
+    }
+  }
+
+done:
+  free(outs);
+  if (pieces != stackPieces)
+    free(pieces);
 }
 
 void CanvasInputHandleEditTools(Canvas *canvas, bool inputCaptured, bool isPanning,
@@ -89,14 +423,14 @@ void CanvasInputHandleEditTools(Canvas *canvas, bool inputCaptured, bool isPanni
     if (!isPanning && canvas->isDraggingSelection && canvas->selectedStrokeIndex >= 0 &&
         IsMouseButtonDown(MOUSE_BUTTON_LEFT)) {
       Vector2 delta = Vector2Subtract(mouseWorld, canvas->lastMouseWorld);
-      TranslateStroke(&canvas->strokes[canvas->selectedStrokeIndex], delta);
+      CanvasTranslateStroke(canvas, canvas->selectedStrokeIndex, delta);
       canvas->lastMouseWorld = mouseWorld;
     }
 
     if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT))
       canvas->isDraggingSelection = false;
     if (canvas->selectedStrokeIndex >= 0 && IsKeyPressed(KEY_DELETE))
-      RemoveStrokeAtIndex(canvas, canvas->selectedStrokeIndex);
+      CanvasRemoveStroke(canvas, canvas->selectedStrokeIndex);
   }
 
   if (!inputCaptured && activeTool == TOOL_ERASER && !isPanning &&
@@ -105,10 +439,43 @@ void CanvasInputHandleEditTools(Canvas *canvas, bool inputCaptured, bool isPanni
         GetScreenToWorld2D(GetMousePosition(), canvas->camera);
     float radiusWorld = (8.0f + canvas->currentStroke.thickness) /
                         fmaxf(canvas->camera.zoom, 0.001f);
+    if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+      canvas->lastMouseWorld = mouseWorld;
+
+    // Step along the drag so fast motion leaves no gaps between frames.
+    // Each stroke is stepped, one radius apart, only over the part of the
+    // drag that can reach it, so a long drag costs steps near strokes rather
+    // than along its whole length. Cutting a stroke only touches it and the
+    // pieces inserted right after it, so those are followed through the
+    // steps by the index range [i, end).
+    Vector2 from = canvas->lastMouseWorld;
+    float travel = Vector2Distance(from, mouseWorld);
+    Rectangle swept = {fminf(from.x, mouseWorld.x) - radiusWorld,
+                       fminf(from.y, mouseWorld.y) - radiusWorld,
+                       fabsf(mouseWorld.x - from.x) + radiusWorld * 2.0f,
+                       fabsf(mouseWorld.y - from.y) + radiusWorld * 2.0f};
+    // Rebuilding a stale canvas extent caches every stroke's bounds too.
+    Rectangle extent;
+    (void)CanvasStrokeBounds(canvas, &extent);
     for (int i = canvas->strokeCount - 1; i >= 0; i--) {
-      float d2 = StrokeMinDistSq(&canvas->strokes[i], mouseWorld);
-      if (d2 <= radiusWorld * radiusWorld)
-        RemoveStrokeAtIndex(canvas, i);
+      Rectangle reach;
+      float t0, t1;
+      if (!StrokeMayTouch(&canvas->strokes[i], swept) ||
+          !StrokeReach(&canvas->strokes[i], radiusWorld, &reach) ||
+          !SegmentRectSpan(from, mouseWorld, reach, &t0, &t1))
+        continue;
+      int steps = (int)ceilf(travel * (t1 - t0) / radiusWorld);
+      int end = i + 1;
+      for (int step = 0; step <= steps && end > i; step++) {
+        float t = steps > 0 ? t0 + (t1 - t0) * (float)step / (float)steps : t1;
+        Vector2 center = Vector2Lerp(from, mouseWorld, t);
+        for (int j = end - 1; j >= i; j--) {
+          int before = canvas->strokeCount;
+          EraseStrokeSpan(canvas, j, center, radiusWorld);
+          end += canvas->strokeCount - before;
+        }
+      }
     }
+    canvas->lastMouseWorld = mouseWorld;
   }
 }
@@ -2,10 +2,71 @@
 #define CANVAS_INTERNAL_H
 
 #include "canvas.h"
+#include <stdio.h>
 
 void CanvasInputHandleDrawTools(Canvas *canvas, bool inputCaptured, bool isPanning,
                                 int activeTool);
 void CanvasInputHandleEditTools(Canvas *canvas, bool inputCaptured, bool isPanning,
                                 int activeTool);
 
+// Douglas-Peucker over position and width; compacts `points` in place and
+// returns the new count. `tolerance` is the allowed outline error.
+int SimplifyStrokePoints(Point *points, int count, float tolerance);
+
+// Hand-drawn look shared by the GL and CPU renderers (canvas_sketch.c): a
+// per-stroke noise seed and each point's jittered position `dist` along the
+// path.
+uint32_t StrokeSeed(const Stroke *s);
+Vector2 JitterPoint(const Point *points, int pointCount, bool closed, int i,
+                    float dist, float amplitude, float wavelength, uint32_t seed);
+// Points to draw for a path; a closed path drops its repeated last point.
+int StrokeLoopCount(const Stroke *s, bool *closed);
+
+// Stroke edits by index (canvas_ops.c); the canvas takes ownership of
+// inserted strokes. Each edit is recorded in the save journal.
+void CanvasTranslateStroke(Canvas *canvas, int index, Vector2 delta);
+void CanvasRemoveStroke(Canvas *canvas, int index);
+bool CanvasInsertStroke(Canvas *canvas, int index, Stroke stroke);
+// Grows the stroke array so `extra` more strokes insert without failing.
+bool CanvasReserveStrokes(Canvas *canvas, int extra);
+
+// Canvas bounds upkeep (canvas_shapes.c). A stroke is added with its final
+// points, caching its bounds, and removed before those bounds are
+// remeasured; removing one that reaches an edge marks the canvas stale.
+void CanvasBoundsAdd(Canvas *canvas, Stroke *s);
+void CanvasBoundsRemove(Canvas *canvas, const Stroke *s);
+void CanvasBoundsReset(Canvas *canvas, bool stale);
+
+// Save journal (canvas_journal.c). Edits are recorded only while the canvas
+// has a file to append them to; `index` is where the edit applied.
+void JournalRecordAppend(Canvas *canvas, const Stroke *s);
+void JournalRecordInsert(Canvas *canvas, int index, const Stroke *s);
+void JournalRecordReplace(Canvas *canvas, int index, const Stroke *s);
+void JournalRecordRemove(Canvas *canvas, int index);
+void JournalRecordTranslate(Canvas *canvas, int index, Vector2 delta);
+void JournalRecordClear(Canvas *canvas);
+void JournalFree(Canvas *canvas);
+
+struct PointStore {
+  uint8_t *base;
+  size_t size;
+  bool mapped; // false when the file had to be read into memory
+  int refs;    // one per borrowing stroke, plus the loader while it runs
+};
+
+// Stops streaming a chunked file (canvas_chunked.c); unloaded placeholders
+// stay empty.
+void CanvasCloseLazy(Canvas *canvas);
+
+// Maps the whole of `f` read-only; the caller owns the returned reference.
+PointStore *PointStoreMapFile(FILE *f);
+// Takes ownership of a malloc'd buffer so strokes can share it.
+PointStore *PointStoreAdopt(void *data, size_t size);
+void PointStoreRetain(PointStore *store);
+// Fills `copy` with a stroke sharing the points of `s` (turning owned points
+// into a store first). With `withCache`, the copy also gets a copy of a built
+// render cache; otherwise it has none.
+bool StrokeShare(Stroke *s, Stroke *copy, bool withCache);
+void PointStoreRelease(PointStore *store);
+
 #endif
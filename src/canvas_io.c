@@ -1,244 +1,513 @@
-#include "canvas.h"
+#include "canvas_chunked.h"
+#include "canvas_format.h"
+#include "canvas_journal.h"
+#include "canvas_packed.h"
+#include "canvas_verify.h"
+#include "crc32c.h"
+#include "text_reader.h"
 #include <limits.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-
-static const char kBinaryMagic[4] = {'C', 'D', 'R', 'B'};
-static const uint32_t kBinaryVersion = 1;
-static const uint32_t kBinaryFlags = 0;
-static const uint32_t kMaxStrokes = 1000000;
-static const uint64_t kMaxTotalPoints = 10000000;
-
-static bool WriteBytes(FILE *f, const void *data, size_t size) {
-  return fwrite(data, 1, size, f) == size;
-}
-
-static bool ReadBytes(FILE *f, void *data, size_t size) {
-  return fread(data, 1, size, f) == size;
+#include <sys/stat.h>
+
+// Loads refuse files past these (CanvasSetLoadLimits), so a corrupt count
+// fails instead of allocating. Totals may pass 2^31; a single stroke may not.
+static CanvasLoadLimits gLoadLimits = {8000000, 1ull << 32};
+// Uncompressed saves of boards this large are chunked: opening them as v2
+// means touching every stroke record before the first frame. Chunks are
+// mapped like v5 point blocks, so large boards still open zero-copy.
+static const int64_t kChunkedSaveThreshold = 2000000;
+
+void PackHeader(const Canvas *canvas, uint32_t version, uint32_t strokeCount,
+                uint8_t *header) {
+  memset(header, 0, BINARY_HEADER_SIZE);
+  PutU32(header + 0, version);
+  PutU32(header + 4, kBinaryFlags);
+  PutU32(header + 8, strokeCount);
+  PutF32(header + 12, canvas->camera.target.x);
+  PutF32(header + 16, canvas->camera.target.y);
+  PutF32(header + 20, canvas->camera.offset.x);
+  PutF32(header + 24, canvas->camera.offset.y);
+  PutF32(header + 28, canvas->camera.zoom);
+  PutF32(header + 32, canvas->camera.rotation);
+  PutColor(header + 36, canvas->backgroundColor);
+  PutColor(header + 40, canvas->gridColor);
+  PutColor(header + 44, canvas->selectionColor);
+  header[48] = canvas->showGrid ? 1u : 0u;
 }
 
-static bool WriteU8(FILE *f, uint8_t value) {
-  return WriteBytes(f, &value, sizeof(value));
+void ApplyHeader(Canvas *canvas, const uint8_t *header) {
+  canvas->camera.target = (Vector2){GetF32(header + 12), GetF32(header + 16)};
+  canvas->camera.offset = (Vector2){GetF32(header + 20), GetF32(header + 24)};
+  canvas->camera.zoom = GetF32(header + 28);
+  canvas->camera.rotation = GetF32(header + 32);
+  canvas->backgroundColor = GetColor(header + 36);
+  canvas->gridColor = GetColor(header + 40);
+  canvas->selectionColor = GetColor(header + 44);
+  canvas->showGrid = (header[48] != 0);
 }
 
-static bool WriteU32(FILE *f, uint32_t value) {
-  return WriteBytes(f, &value, sizeof(value));
+void PackStrokeRecord(const Stroke *s, uint8_t *record) {
+  memset(record, 0, BINARY_STROKE_SIZE);
+  PutColor(record + 0, s->color);
+  PutF32(record + 4, s->thickness);
+  record[8] = s->usePressure ? 1u : 0u;
+  // The first stroke pad byte holds the shape; older files leave it 0 (path).
+  record[9] = (uint8_t)s->shape;
+  PutU32(record + 12, (uint32_t)s->pointCount);
 }
 
-static bool WriteF32(FILE *f, float value) {
-  return WriteBytes(f, &value, sizeof(value));
+Stroke UnpackStrokeRecord(const uint8_t *record, uint32_t flags) {
+  Stroke s = {0};
+  uint32_t pointCount = GetU32(record + 12);
+  s.color = GetColor(record + 0);
+  s.thickness = GetF32(record + 4);
+  s.usePressure = (record[8] != 0);
+  if ((flags & kBinaryFlagShapes) && record[9] < STROKE_SHAPE_COUNT && pointCount >= 2)
+    s.shape = (StrokeShape)record[9];
+  s.cachedPoints = NULL;
+  s.cachedCount = 0;
+  s.cachedCapacity = 0;
+  s.cacheVersion = 1;
+  s.lastBuiltVersion = 0;
+  s.cacheDirty = true;
+  s.pointCount = (int)pointCount;
+  s.capacity = (int)pointCount;
+  return s;
 }
 
-static bool ReadU8(FILE *f, uint8_t *value) {
-  return ReadBytes(f, value, sizeof(*value));
-}
-
-static bool ReadU32(FILE *f, uint32_t *value) {
-  return ReadBytes(f, value, sizeof(*value));
-}
-
-static bool ReadF32(FILE *f, float *value) {
-  return ReadBytes(f, value, sizeof(*value));
+static bool WritePadding(FILE *f, uint64_t *offset) {
+  static const uint8_t zeros[MAPPED_ALIGN] = {0};
+  size_t pad = (size_t)(AlignUp(*offset) - *offset);
+  if (pad > 0 && fwrite(zeros, 1, pad, f) != pad)
+    return false;
+  *offset += pad;
+  return true;
 }
 
 static bool WriteBinaryCanvas(const Canvas *canvas, FILE *f) {
   if (!canvas)
     return false;
-  if (canvas->strokeCount < 0 || canvas->strokeCount > (int)kMaxStrokes)
+  if (canvas->strokeCount < 0)
     return false;
 
   uint32_t strokeCount = (uint32_t)canvas->strokeCount;
+  for (uint32_t i = 0; i < strokeCount; i++) {
+    if (canvas->strokes[i].pointCount < 0)
+      return false;
+  }
 
-  if (!WriteBytes(f, kBinaryMagic, sizeof(kBinaryMagic)))
-    return false;
-  if (!WriteU32(f, kBinaryVersion))
-    return false;
-  if (!WriteU32(f, kBinaryFlags))
-    return false;
-  if (!WriteU32(f, strokeCount))
-    return false;
-
-  if (!WriteF32(f, canvas->camera.target.x) ||
-      !WriteF32(f, canvas->camera.target.y) ||
-      !WriteF32(f, canvas->camera.offset.x) ||
-      !WriteF32(f, canvas->camera.offset.y) ||
-      !WriteF32(f, canvas->camera.zoom) ||
-      !WriteF32(f, canvas->camera.rotation))
-    return false;
-
-  if (!WriteU8(f, canvas->backgroundColor.r) ||
-      !WriteU8(f, canvas->backgroundColor.g) ||
-      !WriteU8(f, canvas->backgroundColor.b) ||
-      !WriteU8(f, canvas->backgroundColor.a))
-    return false;
-  if (!WriteU8(f, canvas->gridColor.r) || !WriteU8(f, canvas->gridColor.g) ||
-      !WriteU8(f, canvas->gridColor.b) || !WriteU8(f, canvas->gridColor.a))
-    return false;
-  if (!WriteU8(f, canvas->selectionColor.r) ||
-      !WriteU8(f, canvas->selectionColor.g) ||
-      !WriteU8(f, canvas->selectionColor.b) ||
-      !WriteU8(f, canvas->selectionColor.a))
-    return false;
-
-  uint8_t showGrid = canvas->showGrid ? 1u : 0u;
-  if (!WriteU8(f, showGrid))
-    return false;
-  uint8_t pad[3] = {0, 0, 0};
-  if (!WriteBytes(f, pad, sizeof(pad)))
+  uint8_t preamble[CHECKED_PREAMBLE_SIZE] = {0};
+  memcpy(preamble, kBinaryMagic, sizeof(kBinaryMagic));
+  PackHeader(canvas, kBinaryVersionChecked, strokeCount, preamble + 4);
+  PutU64(preamble + MAPPED_TABLE_OFFSET_AT, CHECKED_PREAMBLE_SIZE);
+  if (fwrite(preamble, 1, sizeof(preamble), f) != sizeof(preamble))
     return false;
 
+  // Block offsets are known up front, so the table goes out in one pass.
+  uint64_t blockOffset =
+      AlignUp(CHECKED_PREAMBLE_SIZE + (uint64_t)strokeCount * MAPPED_ENTRY_SIZE);
+  uint32_t tableCrc = 0;
   for (uint32_t i = 0; i < strokeCount; i++) {
     const Stroke *s = &canvas->strokes[i];
-    if (s->pointCount < 0)
-      return false;
-    if ((uint64_t)s->pointCount > kMaxTotalPoints)
+    uint8_t entry[MAPPED_ENTRY_SIZE];
+    PackStrokeRecord(s, entry);
+    PutU64(entry + BINARY_STROKE_SIZE, blockOffset);
+    if (fwrite(entry, 1, sizeof(entry), f) != sizeof(entry))
       return false;
+    tableCrc = Crc32c(tableCrc, entry, sizeof(entry));
+    blockOffset = AlignUp(blockOffset + MAPPED_BLOCK_PREFIX +
+                          (uint64_t)s->pointCount * sizeof(Point));
+  }
+
+  uint64_t offset = CHECKED_PREAMBLE_SIZE + (uint64_t)strokeCount * MAPPED_ENTRY_SIZE;
+  for (uint32_t i = 0; i < strokeCount; i++) {
+    const Stroke *s = &canvas->strokes[i];
     uint32_t pointCount = (uint32_t)s->pointCount;
-    if (!WriteU8(f, s->color.r) || !WriteU8(f, s->color.g) ||
-        !WriteU8(f, s->color.b) || !WriteU8(f, s->color.a))
+    if (!WritePadding(f, &offset))
       return false;
-    if (!WriteF32(f, s->thickness))
+    uint8_t prefix[MAPPED_BLOCK_PREFIX] = {0};
+    PutU32(prefix, pointCount);
+    PutU32(prefix + 4, Crc32c(0, s->points, sizeof(Point) * (size_t)pointCount));
+    if (fwrite(prefix, 1, sizeof(prefix), f) != sizeof(prefix))
       return false;
-    uint8_t usePressure = s->usePressure ? 1u : 0u;
-    if (!WriteU8(f, usePressure))
+    if (pointCount > 0 &&
+        fwrite(s->points, sizeof(Point), pointCount, f) != pointCount)
       return false;
-    if (!WriteBytes(f, pad, sizeof(pad)))
-      return false;
-    if (!WriteU32(f, pointCount))
-      return false;
-    for (uint32_t p = 0; p < pointCount; p++) {
-      if (!WriteF32(f, s->points[p].x) || !WriteF32(f, s->points[p].y) ||
-          !WriteF32(f, s->points[p].width))
-        return false;
+    offset += MAPPED_BLOCK_PREFIX + (uint64_t)pointCount * sizeof(Point);
+  }
+  if (!WritePadding(f, &offset))
+    return false;
+
+  PutU32(preamble + CHECKED_TABLE_CRC_AT, tableCrc);
+  PutU32(preamble + CHECKED_PREAMBLE_CRC_AT, Crc32c(0, preamble, CHECKED_PREAMBLE_CRC_AT));
+  return fseek(f, 0, SEEK_SET) == 0 &&
+         fwrite(preamble, 1, sizeof(preamble), f) == sizeof(preamble);
+}
+
+// CDRAW2 text (see LoadCanvasFromText). Text predates shapes: rectangles and
+// circles go out as their outlines, arrows in the baked [start, tip, left,
+// right, tip] form that loads back as an arrow. Circles are tessellated finely
+// enough to stay round at kTextOutlineZoom.
+static const float kTextOutlineZoom = 16.0f;
+
+static bool WriteTextCanvas(const Canvas *canvas, FILE *f) {
+  if (!canvas || canvas->strokeCount < 0)
+    return false;
+  if (fprintf(f, "CDRAW2\nstrokes %d\n", canvas->strokeCount) < 0)
+    return false;
+
+  Point *outline = NULL;
+  int outlineCapacity = 0;
+  bool ok = true;
+  for (int i = 0; ok && i < canvas->strokeCount; i++) {
+    const Stroke *s = &canvas->strokes[i];
+    const Point *points = s->points;
+    int count = s->pointCount;
+    Point arrow[5];
+    Vector2 shaftEnd, head[3];
+    if (s->shape == STROKE_SHAPE_ARROW &&
+        StrokeArrowHead(s, s->thickness, &shaftEnd, head)) {
+      Point tip = {head[0].x, head[0].y, 0.0f};
+      arrow[0] = (Point){s->points[0].x, s->points[0].y, 0.0f};
+      arrow[1] = tip;
+      arrow[2] = (Point){head[1].x, head[1].y, 0.0f};
+      arrow[3] = (Point){head[2].x, head[2].y, 0.0f};
+      arrow[4] = tip;
+      points = arrow;
+      count = 5;
+    } else if (s->shape == STROKE_SHAPE_RECT || s->shape == STROKE_SHAPE_CIRCLE) {
+      count = StrokeOutlineCount(s, kTextOutlineZoom);
+      if (count > outlineCapacity) {
+        Point *grown = (Point *)realloc(outline, sizeof(Point) * (size_t)count);
+        if (!grown) {
+          ok = false;
+          break;
+        }
+        outline = grown;
+        outlineCapacity = count;
+      }
+      count = StrokeOutline(s, kTextOutlineZoom, outline);
+      points = outline;
+    }
+
+    if (fprintf(f, "stroke %u %u %u %u %.9g %d %d\n", s->color.r, s->color.g,
+                s->color.b, s->color.a, s->thickness, count,
+                s->usePressure ? 1 : 0) < 0)
+      ok = false;
+    for (int p = 0; ok && p < count; p++) {
+      if (fprintf(f, "%.9g %.9g %.9g\n", points[p].x, points[p].y,
+                  points[p].width) < 0)
+        ok = false;
     }
   }
+  free(outline);
+  return ok;
+}
 
-  return true;
+CanvasLoadLimits CanvasGetLoadLimits(void) { return gLoadLimits; }
+
+void CanvasSetLoadLimits(CanvasLoadLimits limits) {
+  if (limits.maxStrokes > INT_MAX)
+    limits.maxStrokes = INT_MAX;
+  gLoadLimits = limits;
+}
+
+bool PointsWithinLimits(uint64_t totalPoints, uint64_t pointCount) {
+  return pointCount <= INT_MAX && totalPoints + pointCount <= gLoadLimits.maxTotalPoints;
+}
+
+// Strokes collect in `batch` on the loading thread and move to `ready` under
+// the lock every FEED_BATCH_STROKES strokes or FEED_BATCH_POINTS points.
+#define FEED_BATCH_STROKES 1024
+#define FEED_BATCH_POINTS (256 * 1024)
+
+struct CanvasLoadFeed {
+  pthread_mutex_t lock;
+  Stroke *ready;
+  int readyCount;
+  int readyCapacity;
+  uint8_t header[BINARY_HEADER_SIZE];
+  bool hasHeader;
+  bool headerTaken;
+
+  // Loading thread only.
+  Stroke *batch;
+  int batchCount;
+  int batchCapacity;
+  uint64_t batchPoints;
+
+  uint32_t expected; // strokes in the file, once known
+  uint32_t decoded;
+  int cancelled;
+};
+
+CanvasLoadFeed *CanvasLoadFeedCreate(void) {
+  CanvasLoadFeed *feed = (CanvasLoadFeed *)calloc(1, sizeof(CanvasLoadFeed));
+  if (!feed)
+    return NULL;
+  if (pthread_mutex_init(&feed->lock, NULL) != 0) {
+    free(feed);
+    return NULL;
+  }
+  return feed;
+}
+
+static void FreeStrokeCopies(Stroke *strokes, int count) {
+  for (int i = 0; i < count; i++)
+    StrokeFreePoints(&strokes[i]);
+  free(strokes);
+}
+
+void CanvasLoadFeedFree(CanvasLoadFeed *feed) {
+  if (!feed)
+    return;
+  FreeStrokeCopies(feed->ready, feed->readyCount);
+  FreeStrokeCopies(feed->batch, feed->batchCount);
+  pthread_mutex_destroy(&feed->lock);
+  free(feed);
+}
+
+void CanvasLoadFeedCancel(CanvasLoadFeed *feed) {
+  if (feed)
+    __atomic_store_n(&feed->cancelled, 1, __ATOMIC_RELAXED);
+}
+
+static bool FeedCancelled(CanvasLoadFeed *feed) {
+  return feed && __atomic_load_n(&feed->cancelled, __ATOMIC_RELAXED) != 0;
+}
+
+float CanvasLoadFeedProgress(CanvasLoadFeed *feed) {
+  if (!feed)
+    return 0.0f;
+  uint32_t expected = __atomic_load_n(&feed->expected, __ATOMIC_RELAXED);
+  uint32_t decoded = __atomic_load_n(&feed->decoded, __ATOMIC_RELAXED);
+  if (expected == 0)
+    return 0.0f;
+  return decoded >= expected ? 1.0f : (float)decoded / (float)expected;
+}
+
+static void FeedBegin(CanvasLoadFeed *feed, const uint8_t *header, uint32_t strokeCount) {
+  if (!feed)
+    return;
+  if (header) {
+    pthread_mutex_lock(&feed->lock);
+    memcpy(feed->header, header, BINARY_HEADER_SIZE);
+    feed->hasHeader = true;
+    pthread_mutex_unlock(&feed->lock);
+  }
+  __atomic_store_n(&feed->expected, strokeCount, __ATOMIC_RELAXED);
 }
 
-static bool LoadCanvasFromText(Canvas *canvas, FILE *f) {
-  char header[32] = {0};
-  bool isV1 = false;
-  if (!fgets(header, (int)sizeof(header), f))
+static bool FeedFlush(CanvasLoadFeed *feed) {
+  if (!feed || feed->batchCount == 0)
+    return true;
+  bool ok = true;
+  pthread_mutex_lock(&feed->lock);
+  if (feed->readyCount + feed->batchCount > feed->readyCapacity) {
+    int newCap = feed->readyCapacity == 0 ? 64 : feed->readyCapacity;
+    while (newCap < feed->readyCount + feed->batchCount)
+      newCap *= 2;
+    Stroke *grown = (Stroke *)realloc(feed->ready, sizeof(Stroke) * (size_t)newCap);
+    if (grown) {
+      feed->ready = grown;
+      feed->readyCapacity = newCap;
+    } else {
+      ok = false;
+    }
+  }
+  if (ok) {
+    memcpy(feed->ready + feed->readyCount, feed->batch,
+           sizeof(Stroke) * (size_t)feed->batchCount);
+    feed->readyCount += feed->batchCount;
+    feed->batchCount = 0;
+    feed->batchPoints = 0;
+  }
+  pthread_mutex_unlock(&feed->lock);
+  return ok;
+}
+
+bool FeedStroke(CanvasLoadFeed *feed, Stroke *s) {
+  if (!feed)
+    return true;
+  if (FeedCancelled(feed))
     return false;
-  if (strncmp(header, "CDRAW2", 5) != 0) {
-    if (strncmp(header, "CDRAW1", 5) == 0)
-      isV1 = true;
-    else
+  if (feed->batchCount >= feed->batchCapacity) {
+    int newCap = feed->batchCapacity == 0 ? 64 : feed->batchCapacity * 2;
+    Stroke *grown = (Stroke *)realloc(feed->batch, sizeof(Stroke) * (size_t)newCap);
+    if (!grown)
       return false;
+    feed->batch = grown;
+    feed->batchCapacity = newCap;
   }
+  if (!StrokeShare(s, &feed->batch[feed->batchCount], false))
+    return false;
+  feed->batchCount++;
+  feed->batchPoints += (uint64_t)s->pointCount;
+  __atomic_add_fetch(&feed->decoded, 1, __ATOMIC_RELAXED);
+  if (feed->batchCount >= FEED_BATCH_STROKES || feed->batchPoints >= FEED_BATCH_POINTS)
+    return FeedFlush(feed);
+  return true;
+}
 
+int CanvasLoadFeedTake(CanvasLoadFeed *feed, Canvas *preview) {
+  if (!feed || !preview)
+    return 0;
+  pthread_mutex_lock(&feed->lock);
+  if (feed->hasHeader && !feed->headerTaken) {
+    ApplyHeader(preview, feed->header);
+    feed->headerTaken = true;
+  }
+  int taken = 0;
+  int needed = preview->strokeCount + feed->readyCount;
+  if (feed->readyCount > 0 && needed > preview->capacity) {
+    int newCap = preview->capacity == 0 ? 64 : preview->capacity;
+    while (newCap < needed)
+      newCap *= 2;
+    Stroke *grown = (Stroke *)realloc(preview->strokes, sizeof(Stroke) * (size_t)newCap);
+    if (grown) {
+      preview->strokes = grown;
+      preview->capacity = newCap;
+    }
+  }
+  if (needed <= preview->capacity) {
+    for (int i = 0; i < feed->readyCount; i++) {
+      preview->strokes[preview->strokeCount++] = feed->ready[i];
+      preview->totalPoints += feed->ready[i].pointCount;
+    }
+    CanvasBoundsReset(preview, true);
+    taken = feed->readyCount;
+    feed->readyCount = 0;
+  }
+  pthread_mutex_unlock(&feed->lock);
+  return taken;
+}
+
+static bool TextLoadFailed(Canvas *canvas, const TextReader *r, const char *what,
+                           int stroke) {
+  if (stroke >= 0)
+    fprintf(stderr, "Text load: line %d: stroke %d: %s\n", r->line, stroke, what);
+  else
+    fprintf(stderr, "Text load: line %d: %s\n", r->line, what);
   ClearCanvas(canvas);
+  return false;
+}
 
-  char tok[32] = {0};
-  int strokeCount = 0;
-  if (fscanf(f, "%31s %d", tok, &strokeCount) != 2 || strcmp(tok, "strokes") != 0 ||
-      strokeCount < 0)
+static bool LoadCanvasFromTextReader(Canvas *canvas, TextReader *r,
+                                     CanvasLoadFeed *feed) {
+  size_t len = 0;
+  const char *magic = TextReaderNext(r, &len);
+  if (!magic || len < 6 || memcmp(magic, "CDRAW", 5) != 0 ||
+      (magic[5] != '1' && magic[5] != '2'))
     return false;
+  bool isV1 = magic[5] == '1';
+
+  ClearCanvas(canvas);
+
+  int64_t strokeCount = 0;
+  if (!TextReaderKeyword(r, "strokes") ||
+      !TextReaderInt(r, 0, gLoadLimits.maxStrokes, &strokeCount))
+    return TextLoadFailed(canvas, r, "expected \"strokes\" and a count", -1);
+  FeedBegin(feed, NULL, (uint32_t)strokeCount);
 
-  for (int i = 0; i < strokeCount; i++) {
-    unsigned int r, g, b, a;
+  for (int i = 0; i < (int)strokeCount; i++) {
+    int64_t rgba[4];
     float thickness;
-    int pointCount;
-    int usePressure = 0;
-    if (isV1) {
-      if (fscanf(f, "%31s %u %u %u %u %f %d", tok, &r, &g, &b, &a, &thickness,
-                 &pointCount) != 7 ||
-          strcmp(tok, "stroke") != 0 || pointCount < 0) {
-        ClearCanvas(canvas);
-        return false;
-      }
-    } else if (fscanf(f, "%31s %u %u %u %u %f %d %d", tok, &r, &g, &b, &a,
-                      &thickness, &pointCount, &usePressure) != 8 ||
-               strcmp(tok, "stroke") != 0 || pointCount < 0) {
-      ClearCanvas(canvas);
-      return false;
-    }
+    int64_t pointCount;
+    int64_t usePressure = 0;
+    if (!TextReaderKeyword(r, "stroke"))
+      return TextLoadFailed(canvas, r, "expected \"stroke\"", i);
+    bool ok = true;
+    for (int c = 0; c < 4 && ok; c++)
+      ok = TextReaderInt(r, 0, UINT32_MAX, &rgba[c]);
+    ok = ok && TextReaderFloat(r, &thickness) && TextReaderInt(r, 0, INT_MAX, &pointCount);
+    if (ok && !isV1)
+      ok = TextReaderInt(r, INT_MIN, INT_MAX, &usePressure);
+    if (!ok)
+      return TextLoadFailed(canvas, r, "bad color, thickness or point count", i);
+    if (!PointsWithinLimits((uint64_t)canvas->totalPoints, (uint64_t)pointCount))
+      return TextLoadFailed(canvas, r, "too many points", i);
 
     Stroke s = {0};
-    s.color = (Color){(unsigned char)r, (unsigned char)g, (unsigned char)b,
-                      (unsigned char)a};
+    s.color = (Color){(unsigned char)rgba[0], (unsigned char)rgba[1],
+                      (unsigned char)rgba[2], (unsigned char)rgba[3]};
     s.thickness = thickness;
     s.usePressure = (usePressure != 0) && !isV1;
-    s.cachedPoints = NULL;
-    s.cachedCount = 0;
-    s.cachedCapacity = 0;
     s.cacheVersion = 1;
-    s.lastBuiltVersion = 0;
     s.cacheDirty = true;
-    s.pointCount = pointCount;
-    s.capacity = pointCount;
+    s.pointCount = (int)pointCount;
+    s.capacity = (int)pointCount;
     if (pointCount > 0) {
-      if ((size_t)pointCount > SIZE_MAX / sizeof(Point)) {
-        ClearCanvas(canvas);
-        return false;
-      }
+      if ((uint64_t)pointCount > SIZE_MAX / sizeof(Point))
+        return TextLoadFailed(canvas, r, "too many points", i);
       s.points = (Point *)malloc(sizeof(Point) * (size_t)pointCount);
-      if (!s.points) {
-        ClearCanvas(canvas);
-        return false;
-      }
-      for (int p = 0; p < pointCount; p++) {
+      if (!s.points)
+        return TextLoadFailed(canvas, r, "out of memory", i);
+      for (int p = 0; p < (int)pointCount; p++) {
         float x, y, w = 0.0f;
-        if (isV1) {
-          if (fscanf(f, "%f %f", &x, &y) != 2) {
-            free(s.points);
-            ClearCanvas(canvas);
-            return false;
-          }
-        } else if (fscanf(f, "%f %f %f", &x, &y, &w) != 3) {
+        if (!TextReaderFloat(r, &x) || !TextReaderFloat(r, &y) ||
+            (!isV1 && !TextReaderFloat(r, &w))) {
           free(s.points);
-          ClearCanvas(canvas);
-          return false;
+          char what[48];
+          snprintf(what, sizeof(what), "bad point %d", p);
+          return TextLoadFailed(canvas, r, what, i);
         }
         s.points[p] = (Point){x, y, w};
       }
     }
+    StrokeUpgradeLegacyArrow(&s);
     AddStroke(canvas, s);
+    if (!FeedStroke(feed, &canvas->strokes[canvas->strokeCount - 1])) {
+      ClearCanvas(canvas);
+      return false;
+    }
   }
 
   return true;
 }
 
-static bool LoadCanvasFromBinary(Canvas *canvas, FILE *f) {
-  uint32_t version = 0;
-  uint32_t flags = 0;
-  uint32_t strokeCount = 0;
-  float targetX = 0.0f, targetY = 0.0f;
-  float offsetX = 0.0f, offsetY = 0.0f;
-  float zoom = 1.0f, rotation = 0.0f;
-  uint8_t bg[4] = {0, 0, 0, 255};
-  uint8_t grid[4] = {0, 0, 0, 255};
-  uint8_t selection[4] = {0, 0, 0, 255};
-  uint8_t showGrid = 1u;
-  uint8_t pad[3] = {0, 0, 0};
-
-  if (!ReadU32(f, &version) || !ReadU32(f, &flags) || !ReadU32(f, &strokeCount))
-    return false;
-  (void)flags;
-  if (version != kBinaryVersion)
-    return false;
-  if (strokeCount > kMaxStrokes)
+// CDRAW1 and CDRAW2 text, from before the binary format: "strokes N", then
+// per stroke "stroke r g b a thickness pointCount [usePressure]" and its
+// points as "x y [width]". Any whitespace separates the fields.
+static bool LoadCanvasFromText(Canvas *canvas, FILE *f, CanvasLoadFeed *feed) {
+  TextReader r;
+  if (!TextReaderInit(&r, f))
     return false;
+  bool ok = LoadCanvasFromTextReader(canvas, &r, feed);
+  TextReaderFree(&r);
+  return ok;
+}
 
-  if (!ReadF32(f, &targetX) || !ReadF32(f, &targetY) || !ReadF32(f, &offsetX) ||
-      !ReadF32(f, &offsetY) || !ReadF32(f, &zoom) || !ReadF32(f, &rotation))
-    return false;
+void FreeLoadedStrokes(Stroke *strokes, uint32_t count) {
+  if (!strokes)
+    return;
+  for (uint32_t i = 0; i < count; i++)
+    StrokeFreePoints(&strokes[i]);
+  free(strokes);
+}
 
-  if (!ReadU8(f, &bg[0]) || !ReadU8(f, &bg[1]) || !ReadU8(f, &bg[2]) ||
-      !ReadU8(f, &bg[3]))
-    return false;
-  if (!ReadU8(f, &grid[0]) || !ReadU8(f, &grid[1]) || !ReadU8(f, &grid[2]) ||
-      !ReadU8(f, &grid[3]))
-    return false;
-  if (!ReadU8(f, &selection[0]) || !ReadU8(f, &selection[1]) ||
-      !ReadU8(f, &selection[2]) || !ReadU8(f, &selection[3]))
-    return false;
-  if (!ReadU8(f, &showGrid))
-    return false;
-  if (!ReadBytes(f, pad, sizeof(pad)))
+void PublishLoadedStrokes(Canvas *canvas, const uint8_t *header,
+                          Stroke *strokes, uint32_t strokeCount,
+                          uint64_t totalPoints) {
+  ApplyHeader(canvas, header);
+  // ClearCanvas already released the old strokes; only the array is left.
+  free(canvas->strokes);
+  canvas->strokes = strokes;
+  canvas->strokeCount = (int)strokeCount;
+  canvas->capacity = (int)strokeCount;
+  canvas->totalPoints = (int64_t)totalPoints;
+  // Measured when first asked for, so mapped points stay untouched till then.
+  CanvasBoundsReset(canvas, true);
+}
+
+static bool LoadCanvasFromRecords(Canvas *canvas, FILE *f, const uint8_t *header,
+                                  uint64_t *baseEnd, CanvasLoadFeed *feed) {
+  uint32_t flags = GetU32(header + 4);
+  uint32_t strokeCount = GetU32(header + 8);
+  if (strokeCount > gLoadLimits.maxStrokes)
     return false;
 
   ClearCanvas(canvas);
@@ -252,100 +521,221 @@ static bool LoadCanvasFromBinary(Canvas *canvas, FILE *f) {
 
   uint64_t totalPoints = 0;
   for (uint32_t i = 0; i < strokeCount; i++) {
-    uint8_t color[4] = {0, 0, 0, 255};
-    float thickness = 0.0f;
-    uint8_t usePressure = 0u;
-    uint32_t pointCount = 0;
-
-    if (!ReadU8(f, &color[0]) || !ReadU8(f, &color[1]) || !ReadU8(f, &color[2]) ||
-        !ReadU8(f, &color[3]))
-      goto fail;
-    if (!ReadF32(f, &thickness))
-      goto fail;
-    if (!ReadU8(f, &usePressure))
+    uint8_t record[BINARY_STROKE_SIZE];
+    if (fread(record, 1, sizeof(record), f) != sizeof(record))
       goto fail;
-    if (!ReadBytes(f, pad, sizeof(pad)))
-      goto fail;
-    if (!ReadU32(f, &pointCount))
+    uint32_t pointCount = GetU32(record + 12);
+    if (!PointsWithinLimits(totalPoints, pointCount))
       goto fail;
 
-    if (pointCount > kMaxTotalPoints || totalPoints + pointCount > kMaxTotalPoints)
-      goto fail;
-    if (pointCount > 0 && (size_t)pointCount > SIZE_MAX / sizeof(Point))
-      goto fail;
-
-    Stroke s = {0};
-    s.color = (Color){color[0], color[1], color[2], color[3]};
-    s.thickness = thickness;
-    s.usePressure = (usePressure != 0);
-    s.cachedPoints = NULL;
-    s.cachedCount = 0;
-    s.cachedCapacity = 0;
-    s.cacheVersion = 1;
-    s.lastBuiltVersion = 0;
-    s.cacheDirty = true;
-    s.pointCount = (int)pointCount;
-    s.capacity = (int)pointCount;
+    Stroke s = UnpackStrokeRecord(record, flags);
     if (pointCount > 0) {
       s.points = (Point *)malloc(sizeof(Point) * (size_t)pointCount);
       if (!s.points)
         goto fail;
-      for (uint32_t p = 0; p < pointCount; p++) {
-        float x = 0.0f, y = 0.0f, w = 0.0f;
-        if (!ReadF32(f, &x) || !ReadF32(f, &y) || !ReadF32(f, &w)) {
-          free(s.points);
-          goto fail;
-        }
-        s.points[p] = (Point){x, y, w};
+      if (fread(s.points, sizeof(Point), pointCount, f) != pointCount) {
+        free(s.points);
+        goto fail;
       }
     }
+    if (!(flags & kBinaryFlagShapes))
+      StrokeUpgradeLegacyArrow(&s);
 
     strokes[i] = s;
-    totalPoints += pointCount;
+    totalPoints += (uint64_t)s.pointCount;
+    if (!FeedStroke(feed, &strokes[i]))
+      goto fail;
   }
 
-  if (totalPoints > INT_MAX)
-    goto fail;
+  *baseEnd = (uint64_t)ftell(f);
+  PublishLoadedStrokes(canvas, header, strokes, strokeCount, totalPoints);
+  return true;
 
-  canvas->camera.target = (Vector2){targetX, targetY};
-  canvas->camera.offset = (Vector2){offsetX, offsetY};
-  canvas->camera.zoom = zoom;
-  canvas->camera.rotation = rotation;
-  canvas->backgroundColor = (Color){bg[0], bg[1], bg[2], bg[3]};
-  canvas->gridColor = (Color){grid[0], grid[1], grid[2], grid[3]};
-  canvas->selectionColor = (Color){selection[0], selection[1], selection[2], selection[3]};
-  canvas->showGrid = (showGrid != 0);
+fail:
+  FreeLoadedStrokes(strokes, strokeCount);
+  ClearCanvas(canvas);
+  return false;
+}
 
-  canvas->strokes = strokes;
-  canvas->strokeCount = (int)strokeCount;
-  canvas->capacity = (int)strokeCount;
-  canvas->totalPoints = (int)totalPoints;
+// Points stay in the mapped file; each stroke holds a store reference until
+// it is edited (StrokeMakePointsWritable) or freed. v5 files have their
+// header and stroke table checked first. Point blocks are checked only by
+// CanvasVerifyFile, since that reads the whole file and opening would no
+// longer be just a mapping.
+static bool LoadCanvasMapped(Canvas *canvas, FILE *f, const uint8_t *header,
+                             uint64_t *baseEnd, CanvasLoadFeed *feed) {
+  uint32_t flags = GetU32(header + 4);
+  uint32_t strokeCount = GetU32(header + 8);
+  if (strokeCount > gLoadLimits.maxStrokes)
+    return false;
+
+  PointStore *store = PointStoreMapFile(f);
+  if (!store)
+    return false;
+  const uint8_t *base = store->base;
+  uint64_t size = store->size;
+  uint64_t preambleSize = MAPPED_PREAMBLE_SIZE;
+  if (GetU32(header + 0) == kBinaryVersionChecked) {
+    char error[96];
+    uint64_t checkedEnd = 0;
+    if (!VerifyChecked(base, size, false, &checkedEnd, error, sizeof(error))) {
+      fprintf(stderr, "Load: %s\n", error);
+      PointStoreRelease(store);
+      return false;
+    }
+    preambleSize = CHECKED_PREAMBLE_SIZE;
+  }
+  uint64_t tableOffset = size >= preambleSize ? GetU64(base + MAPPED_TABLE_OFFSET_AT) : 0;
+  if (tableOffset < preambleSize || tableOffset > size ||
+      (size - tableOffset) / MAPPED_ENTRY_SIZE < strokeCount) {
+    PointStoreRelease(store);
+    return false;
+  }
 
+  ClearCanvas(canvas);
+
+  Stroke *strokes = NULL;
+  if (strokeCount > 0) {
+    strokes = (Stroke *)calloc(strokeCount, sizeof(Stroke));
+    if (!strokes) {
+      PointStoreRelease(store);
+      return false;
+    }
+  }
+
+  uint64_t totalPoints = 0;
+  uint64_t end = tableOffset + (uint64_t)strokeCount * MAPPED_ENTRY_SIZE;
+  for (uint32_t i = 0; i < strokeCount; i++) {
+    const uint8_t *entry = base + tableOffset + (uint64_t)i * MAPPED_ENTRY_SIZE;
+    uint32_t pointCount = GetU32(entry + 12);
+    uint64_t blockOffset = GetU64(entry + BINARY_STROKE_SIZE);
+    if (!PointsWithinLimits(totalPoints, pointCount))
+      goto fail;
+    if ((blockOffset % MAPPED_ALIGN) != 0 || blockOffset > size ||
+        size - blockOffset < MAPPED_BLOCK_PREFIX ||
+        (size - blockOffset - MAPPED_BLOCK_PREFIX) / sizeof(Point) < pointCount ||
+        GetU32(base + blockOffset) != pointCount)
+      goto fail;
+
+    uint64_t blockEnd = blockOffset + MAPPED_BLOCK_PREFIX + (uint64_t)pointCount * sizeof(Point);
+    if (blockEnd > end)
+      end = blockEnd;
+
+    Stroke s = UnpackStrokeRecord(entry, flags);
+    if (pointCount > 0) {
+      s.points = (Point *)(store->base + blockOffset + MAPPED_BLOCK_PREFIX);
+      s.store = store;
+      PointStoreRetain(store);
+    }
+    strokes[i] = s;
+    totalPoints += (uint64_t)s.pointCount;
+    if (!FeedStroke(feed, &strokes[i]))
+      goto fail;
+  }
+
+  *baseEnd = AlignUp(end);
+  PublishLoadedStrokes(canvas, header, strokes, strokeCount, totalPoints);
+  PointStoreRelease(store);
   return true;
 
 fail:
-  if (strokes) {
-    for (uint32_t i = 0; i < strokeCount; i++)
-      free(strokes[i].points);
-    free(strokes);
-  }
+  FreeLoadedStrokes(strokes, strokeCount);
+  PointStoreRelease(store);
   ClearCanvas(canvas);
   return false;
 }
 
-bool SaveCanvasToFile(const Canvas *canvas, const char *path) {
-  FILE *f = fopen(path, "wb");
+static bool LoadCanvasFromBinary(Canvas *canvas, FILE *f, uint64_t *baseEnd,
+                                 CanvasLoadFeed *feed) {
+  uint8_t header[BINARY_HEADER_SIZE];
+  if (fread(header, 1, sizeof(header), f) != sizeof(header))
+    return false;
+
+  uint32_t version = GetU32(header + 0);
+  FeedBegin(feed, header, GetU32(header + 8));
+  if (version == kBinaryVersionRecords)
+    return LoadCanvasFromRecords(canvas, f, header, baseEnd, feed);
+  if (version == kBinaryVersionMapped || version == kBinaryVersionChecked)
+    return LoadCanvasMapped(canvas, f, header, baseEnd, feed);
+  if (version == kBinaryVersionPacked)
+    return LoadCanvasPacked(canvas, f, header, baseEnd, feed);
+  // Chunked files open quickly anyway; their strokes stream in afterwards.
+  if (version == kBinaryVersionChunked)
+    return LoadCanvasChunked(canvas, f, header, baseEnd);
+  return false;
+}
+
+// Full saves go to a temporary file that replaces `path` on success. Besides
+// not leaving a torn file behind, this keeps any mapping of the old file
+// (which may back strokes of an open document) valid, since its inode is
+// untouched. Journal appends only ever grow the file, which is safe too.
+static bool ReplaceCanvasFile(const Canvas *canvas, const char *path,
+                              bool (*write)(const Canvas *, FILE *)) {
+  char tmpPath[4096];
+  // Placeholders of a file still streaming in would be saved empty.
+  if (!canvas || canvas->lazy || !path ||
+      snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path) >= (int)sizeof(tmpPath))
+    return false;
+
+  FILE *f = fopen(tmpPath, "wb");
   if (!f)
     return false;
-  bool ok = WriteBinaryCanvas(canvas, f);
-  fclose(f);
+  setvbuf(f, NULL, _IOFBF, BINARY_STDIO_BUFFER);
+  bool ok = write(canvas, f);
+  if (fclose(f) != 0)
+    ok = false;
+  if (ok && rename(tmpPath, path) != 0)
+    ok = false;
+  if (!ok)
+    remove(tmpPath);
   return ok;
 }
 
-bool LoadCanvasFromFile(Canvas *canvas, const char *path) {
+bool WriteCanvasFile(const Canvas *canvas, const char *path) {
+  if (!canvas)
+    return false;
+  if (canvas->compressSaves)
+    return ReplaceCanvasFile(canvas, path, WritePackedCanvas);
+  if (canvas->totalPoints >= kChunkedSaveThreshold)
+    return ReplaceCanvasFile(canvas, path, WriteChunkedCanvas);
+  return ReplaceCanvasFile(canvas, path, WriteBinaryCanvas);
+}
+
+bool WriteCanvasTextFile(const Canvas *canvas, const char *path) {
+  return ReplaceCanvasFile(canvas, path, WriteTextCanvas);
+}
+
+static bool RewriteCanvasFile(Canvas *canvas, const char *path) {
+  if (!CanvasEnsureLoaded(canvas) || !WriteCanvasFile(canvas, path))
+    return false;
+
+  struct stat st;
+  if (stat(path, &st) == 0)
+    JournalRestart(canvas, path, (uint64_t)st.st_size, (uint64_t)st.st_size);
+  else
+    JournalFree(canvas);
+  return true;
+}
+
+bool SaveCanvasToFile(Canvas *canvas, const char *path) {
+  if (!canvas || !path)
+    return false;
+  if (JournalCanAppend(canvas, path) && AppendJournalFrame(canvas, path))
+    return true;
+  return RewriteCanvasFile(canvas, path);
+}
+
+bool CompactCanvasFile(Canvas *canvas, const char *path) {
+  if (!canvas || !path)
+    return false;
+  return RewriteCanvasFile(canvas, path);
+}
+
+bool LoadCanvasFromFileFed(Canvas *canvas, const char *path, CanvasLoadFeed *feed) {
   FILE *f = fopen(path, "rb");
   if (!f)
     return false;
+  setvbuf(f, NULL, _IOFBF, BINARY_STDIO_BUFFER);
 
   char magic[4] = {0};
   if (fread(magic, 1, sizeof(magic), f) != sizeof(magic)) {
@@ -353,14 +743,33 @@ bool LoadCanvasFromFile(Canvas *canvas, const char *path) {
     return false;
   }
 
+  // Whatever happens, the canvas no longer matches the file it was saved to.
+  JournalFree(canvas);
+
   bool ok = false;
   if (memcmp(magic, kBinaryMagic, sizeof(kBinaryMagic)) == 0) {
-    ok = LoadCanvasFromBinary(canvas, f);
+    uint64_t baseEnd = 0;
+    ok = LoadCanvasFromBinary(canvas, f, &baseEnd, feed) && FeedFlush(feed);
+    // Journal edits may touch strokes of a chunked file that are still
+    // placeholders, which streaming would later overwrite with the saved
+    // points. With frames after the save, every chunk is read first.
+    struct stat st;
+    if (ok && canvas->lazy && fstat(fileno(f), &st) == 0 &&
+        (uint64_t)st.st_size > baseEnd)
+      ok = CanvasEnsureLoaded(canvas);
+    if (ok) {
+      uint64_t end = ReplayJournal(canvas, f, baseEnd);
+      JournalRestart(canvas, path, baseEnd, end);
+    }
   } else {
     rewind(f);
-    ok = LoadCanvasFromText(canvas, f);
+    ok = LoadCanvasFromText(canvas, f, feed) && FeedFlush(feed);
   }
 
   fclose(f);
   return ok;
 }
+
+bool LoadCanvasFromFile(Canvas *canvas, const char *path) {
+  return LoadCanvasFromFileFed(canvas, path, NULL);
+}
@@ -0,0 +1,364 @@
+#include "canvas_journal.h"
+#include "canvas_format.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+// Journal frames follow a full save: "CDRJ", u32 payload size, u32 FNV-1a
+// of the payload, then the payload: a packed header (camera, colors and the
+// stroke count after the frame) and the edits since the previous save. Each
+// edit is a u8 kind and a u32 stroke index, then a stroke record with its
+// points (append, insert, replace) or two f32 deltas (translate).
+static const char kJournalMagic[4] = {'C', 'D', 'R', 'J'};
+#define JOURNAL_FRAME_PREFIX 12
+#define JOURNAL_OP_PREFIX 5
+enum {
+  JOURNAL_APPEND = 1,
+  JOURNAL_INSERT,
+  JOURNAL_REPLACE,
+  JOURNAL_REMOVE,
+  JOURNAL_TRANSLATE,
+  JOURNAL_CLEAR
+};
+// Saves rewrite the file once its journal would pass half the full save (or
+// this size for small files), so loads stay close to the cost of the base.
+static const uint64_t kJournalMinCompact = 4u << 20;
+
+static uint32_t Fnv1a(uint32_t hash, const uint8_t *data, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static uint8_t *JournalBeginOp(Canvas *canvas, uint8_t kind, int index, size_t extra) {
+  CanvasJournal *j = &canvas->journal;
+  if (!j->path || j->failed)
+    return NULL;
+  size_t need = j->size + JOURNAL_OP_PREFIX + extra;
+  if (need > j->capacity) {
+    size_t newCap = j->capacity == 0 ? 4096 : j->capacity;
+    while (newCap < need)
+      newCap *= 2;
+    uint8_t *next = (uint8_t *)realloc(j->ops, newCap);
+    if (!next) {
+      j->failed = true;
+      return NULL;
+    }
+    j->ops = next;
+    j->capacity = newCap;
+  }
+  uint8_t *op = j->ops + j->size;
+  j->lastOp = j->size;
+  j->size = need;
+  op[0] = kind;
+  PutU32(op + 1, (uint32_t)index);
+  return op + JOURNAL_OP_PREFIX;
+}
+
+// True when the newest op is `kind` on `index`.
+static bool JournalLastOpIs(const CanvasJournal *j, uint8_t kind, int index) {
+  return j->size > 0 && j->ops[j->lastOp] == kind &&
+         GetU32(j->ops + j->lastOp + 1) == (uint32_t)index;
+}
+
+static void JournalRecordStroke(Canvas *canvas, uint8_t kind, int index,
+                                const Stroke *s) {
+  if (!canvas->journal.path)
+    return;
+  size_t pointCount = s->pointCount > 0 ? (size_t)s->pointCount : 0;
+  uint8_t *p = JournalBeginOp(canvas, kind, index,
+                              BINARY_STROKE_SIZE + pointCount * sizeof(Point));
+  if (!p)
+    return;
+  PackStrokeRecord(s, p);
+  if (pointCount > 0)
+    memcpy(p + BINARY_STROKE_SIZE, s->points, pointCount * sizeof(Point));
+}
+
+void JournalRecordAppend(Canvas *canvas, const Stroke *s) {
+  canvas->editCount++;
+  JournalRecordStroke(canvas, JOURNAL_APPEND, canvas->strokeCount - 1, s);
+}
+
+void JournalRecordInsert(Canvas *canvas, int index, const Stroke *s) {
+  canvas->editCount++;
+  JournalRecordStroke(canvas, JOURNAL_INSERT, index, s);
+}
+
+void JournalRecordReplace(Canvas *canvas, int index, const Stroke *s) {
+  canvas->editCount++;
+  // The eraser replaces the same stroke on every frame it touches it.
+  CanvasJournal *j = &canvas->journal;
+  if (JournalLastOpIs(j, JOURNAL_REPLACE, index))
+    j->size = j->lastOp;
+  JournalRecordStroke(canvas, JOURNAL_REPLACE, index, s);
+}
+
+void JournalRecordRemove(Canvas *canvas, int index) {
+  canvas->editCount++;
+  JournalBeginOp(canvas, JOURNAL_REMOVE, index, 0);
+}
+
+// Drags record one op per frame: summing their deltas would not round the
+// same way as moving the points frame by frame.
+void JournalRecordTranslate(Canvas *canvas, int index, Vector2 delta) {
+  canvas->editCount++;
+  uint8_t *p = JournalBeginOp(canvas, JOURNAL_TRANSLATE, index, 8);
+  if (!p)
+    return;
+  PutF32(p, delta.x);
+  PutF32(p + 4, delta.y);
+}
+
+void JournalRecordClear(Canvas *canvas) {
+  canvas->editCount++;
+  // Nothing recorded before a clear matters any more.
+  canvas->journal.size = 0;
+  JournalBeginOp(canvas, JOURNAL_CLEAR, 0, 0);
+}
+
+void JournalFree(Canvas *canvas) {
+  CanvasJournal *j = &canvas->journal;
+  free(j->ops);
+  free(j->path);
+  *j = (CanvasJournal){0};
+}
+
+void JournalRestart(Canvas *canvas, const char *path, uint64_t baseSize,
+                    uint64_t fileSize) {
+  CanvasJournal *j = &canvas->journal;
+  size_t len = strlen(path);
+  char *copy = (char *)malloc(len + 1);
+  if (copy)
+    memcpy(copy, path, len + 1);
+  free(j->path);
+  j->path = copy;
+  j->size = 0;
+  j->baseSize = baseSize;
+  j->fileSize = fileSize;
+  j->failed = false;
+}
+
+bool JournalCanAppend(const Canvas *canvas, const char *path) {
+  const CanvasJournal *j = &canvas->journal;
+  if (!j->path || j->failed || strcmp(j->path, path) != 0)
+    return false;
+  if (j->size > UINT32_MAX - BINARY_HEADER_SIZE)
+    return false;
+  // Something else wrote to the file since (or our last append was torn).
+  struct stat st;
+  if (stat(path, &st) != 0 || (uint64_t)st.st_size != j->fileSize)
+    return false;
+  uint64_t journalBytes = j->fileSize - j->baseSize + JOURNAL_FRAME_PREFIX +
+                          BINARY_HEADER_SIZE + j->size;
+  uint64_t limit = j->baseSize / 2;
+  if (limit < kJournalMinCompact)
+    limit = kJournalMinCompact;
+  return journalBytes <= limit;
+}
+
+bool AppendJournalFrame(Canvas *canvas, const char *path) {
+  CanvasJournal *j = &canvas->journal;
+  uint8_t prefix[JOURNAL_FRAME_PREFIX + BINARY_HEADER_SIZE];
+  uint8_t *header = prefix + JOURNAL_FRAME_PREFIX;
+  PackHeader(canvas, 0, (uint32_t)canvas->strokeCount, header);
+  uint32_t hash = Fnv1a(2166136261u, header, BINARY_HEADER_SIZE);
+  hash = Fnv1a(hash, j->ops, j->size);
+  memcpy(prefix, kJournalMagic, sizeof(kJournalMagic));
+  PutU32(prefix + 4, (uint32_t)(BINARY_HEADER_SIZE + j->size));
+  PutU32(prefix + 8, hash);
+
+  FILE *f = fopen(path, "ab");
+  if (!f)
+    return false;
+  bool ok = fwrite(prefix, 1, sizeof(prefix), f) == sizeof(prefix) &&
+            (j->size == 0 || fwrite(j->ops, 1, j->size, f) == j->size);
+  if (fclose(f) != 0)
+    ok = false;
+  if (!ok)
+    return false;
+  j->fileSize += sizeof(prefix) + j->size;
+  j->size = 0;
+  return true;
+}
+
+// One edit of a journal frame, still pointing into the payload.
+typedef struct {
+  uint8_t kind;
+  uint32_t index;
+  const uint8_t *data; // stroke record and points, or the two f32 deltas
+  uint32_t pointCount;
+} JournalOp;
+
+// Splits the next edit off the payload; false when it is cut short or of an
+// unknown kind.
+static bool JournalNextOp(const uint8_t **p, size_t *remaining, JournalOp *op) {
+  if (*remaining < JOURNAL_OP_PREFIX)
+    return false;
+  *op = (JournalOp){(*p)[0], GetU32(*p + 1), *p + JOURNAL_OP_PREFIX, 0};
+  size_t rest = *remaining - JOURNAL_OP_PREFIX;
+  size_t bytes = 0;
+  switch (op->kind) {
+  case JOURNAL_APPEND:
+  case JOURNAL_INSERT:
+  case JOURNAL_REPLACE:
+    if (rest < BINARY_STROKE_SIZE)
+      return false;
+    op->pointCount = GetU32(op->data + 12);
+    if ((rest - BINARY_STROKE_SIZE) / sizeof(Point) < op->pointCount)
+      return false;
+    bytes = BINARY_STROKE_SIZE + (size_t)op->pointCount * sizeof(Point);
+    break;
+  case JOURNAL_TRANSLATE:
+    bytes = 8;
+    if (rest < bytes)
+      return false;
+    break;
+  case JOURNAL_REMOVE:
+  case JOURNAL_CLEAR:
+    break;
+  default:
+    return false;
+  }
+  *p += JOURNAL_OP_PREFIX + bytes;
+  *remaining = rest - bytes;
+  return true;
+}
+
+// Checks a whole frame against `strokeCount` without touching the canvas:
+// every edit well formed, every index in range when it applies, and the
+// stroke count it ends with the one in its header.
+static bool ValidateJournalFrame(const uint8_t *payload, size_t size,
+                                 int strokeCount) {
+  const uint8_t *p = payload + BINARY_HEADER_SIZE;
+  size_t remaining = size - BINARY_HEADER_SIZE;
+  uint64_t count = (uint64_t)strokeCount;
+  while (remaining > 0) {
+    JournalOp op;
+    if (!JournalNextOp(&p, &remaining, &op))
+      return false;
+    switch (op.kind) {
+    case JOURNAL_APPEND:
+      count++;
+      break;
+    case JOURNAL_INSERT:
+      if (op.index > count)
+        return false;
+      count++;
+      break;
+    case JOURNAL_REMOVE:
+      if (op.index >= count)
+        return false;
+      count--;
+      break;
+    case JOURNAL_CLEAR:
+      count = 0;
+      break;
+    default:
+      if (op.index >= count)
+        return false;
+      break;
+    }
+    if (count > (uint64_t)INT_MAX)
+      return false;
+  }
+  return GetU32(payload + 8) == count;
+}
+
+// A frame applies whole or not at all: it is validated first, so only running
+// out of memory can stop it partway.
+static bool ApplyJournalFrame(Canvas *canvas, const uint8_t *payload, size_t size) {
+  if (!ValidateJournalFrame(payload, size, canvas->strokeCount))
+    return false;
+
+  const uint8_t *p = payload + BINARY_HEADER_SIZE;
+  size_t remaining = size - BINARY_HEADER_SIZE;
+  JournalOp op;
+  while (remaining > 0 && JournalNextOp(&p, &remaining, &op)) {
+    if (op.kind == JOURNAL_APPEND || op.kind == JOURNAL_INSERT ||
+        op.kind == JOURNAL_REPLACE) {
+      Stroke s = UnpackStrokeRecord(op.data, kBinaryFlagShapes);
+      if (op.pointCount > 0) {
+        size_t bytes = (size_t)op.pointCount * sizeof(Point);
+        s.points = (Point *)malloc(bytes);
+        if (!s.points)
+          return false;
+        memcpy(s.points, op.data + BINARY_STROKE_SIZE, bytes);
+      }
+
+      if (op.kind == JOURNAL_APPEND) {
+        AddStroke(canvas, s);
+      } else if (op.kind == JOURNAL_INSERT) {
+        if (!CanvasInsertStroke(canvas, (int)op.index, s)) {
+          free(s.points);
+          return false;
+        }
+      } else {
+        Stroke *dst = &canvas->strokes[op.index];
+        canvas->totalPoints += s.pointCount - dst->pointCount;
+        CanvasBoundsRemove(canvas, dst);
+        StrokeFreePoints(dst);
+        free(dst->cachedPoints);
+        *dst = s;
+        CanvasBoundsAdd(canvas, dst);
+      }
+    } else if (op.kind == JOURNAL_REMOVE) {
+      CanvasRemoveStroke(canvas, (int)op.index);
+    } else if (op.kind == JOURNAL_TRANSLATE) {
+      CanvasTranslateStroke(canvas, (int)op.index,
+                            (Vector2){GetF32(op.data), GetF32(op.data + 4)});
+    } else {
+      ClearCanvas(canvas);
+    }
+  }
+
+  ApplyHeader(canvas, payload);
+  return true;
+}
+
+bool JournalReadFrame(FILE *f, uint64_t *offset, uint64_t fileSize,
+                      uint8_t **payload, size_t *capacity, uint32_t *size) {
+  uint8_t prefix[JOURNAL_FRAME_PREFIX];
+  if (*offset > LONG_MAX || *offset > fileSize ||
+      fileSize - *offset < JOURNAL_FRAME_PREFIX ||
+      fseek(f, (long)*offset, SEEK_SET) != 0 ||
+      fread(prefix, 1, sizeof(prefix), f) != sizeof(prefix) ||
+      memcmp(prefix, kJournalMagic, sizeof(kJournalMagic)) != 0)
+    return false;
+  uint32_t frameSize = GetU32(prefix + 4);
+  if (frameSize < BINARY_HEADER_SIZE ||
+      frameSize > fileSize - *offset - JOURNAL_FRAME_PREFIX)
+    return false;
+  if (frameSize > *capacity) {
+    uint8_t *next = (uint8_t *)realloc(*payload, frameSize);
+    if (!next)
+      return false;
+    *payload = next;
+    *capacity = frameSize;
+  }
+  if (fread(*payload, 1, frameSize, f) != frameSize ||
+      Fnv1a(2166136261u, *payload, frameSize) != GetU32(prefix + 8))
+    return false;
+  *offset += JOURNAL_FRAME_PREFIX + (uint64_t)frameSize;
+  *size = frameSize;
+  return true;
+}
+
+uint64_t ReplayJournal(Canvas *canvas, FILE *f, uint64_t offset) {
+  struct stat st;
+  if (fstat(fileno(f), &st) != 0)
+    return offset;
+  uint8_t *payload = NULL;
+  size_t payloadCapacity = 0;
+  uint64_t next = offset;
+  uint32_t size = 0;
+  while (JournalReadFrame(f, &next, (uint64_t)st.st_size, &payload,
+                          &payloadCapacity, &size) &&
+         ApplyJournalFrame(canvas, payload, size))
+    offset = next;
+  free(payload);
+  return offset;
+}
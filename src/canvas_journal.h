@@ -0,0 +1,29 @@
+#ifndef CANVAS_JOURNAL_H
+#define CANVAS_JOURNAL_H
+
+#include "canvas.h"
+#include <stdint.h>
+#include <stdio.h>
+
+// Save journal frames appended after a full save; the edits are recorded
+// through the Journal* calls in canvas_internal.h.
+
+// Starts a new journal against `path`, which holds `baseSize` bytes of full
+// save followed by journal frames up to `fileSize`.
+void JournalRestart(Canvas *canvas, const char *path, uint64_t baseSize,
+                    uint64_t fileSize);
+// Whether the edits since the last save can go to `path` as one more frame
+// rather than a full rewrite.
+bool JournalCanAppend(const Canvas *canvas, const char *path);
+bool AppendJournalFrame(Canvas *canvas, const char *path);
+// Applies the journal frames after a full save at `offset` and returns where
+// the last intact one ends. A torn or corrupt frame (a crash mid-append) and
+// anything after it is ignored.
+uint64_t ReplayJournal(Canvas *canvas, FILE *f, uint64_t offset);
+// Reads the frame at `*offset`, in a file of `fileSize` bytes, into
+// `*payload` (grown as needed) and moves `*offset` past it. False when no
+// intact frame starts there.
+bool JournalReadFrame(FILE *f, uint64_t *offset, uint64_t fileSize,
+                      uint8_t **payload, size_t *capacity, uint32_t *size);
+
+#endif // CANVAS_JOURNAL_H
@@ -1,10 +1,10 @@
-#include "canvas.h"
+#include "canvas_internal.h"
 #include <stdio.h>
 #include <stdlib.h>
 
 static void ClearRedo(Canvas *canvas) {
   for (int i = 0; i < canvas->redoCount; i++) {
-    free(canvas->redoStrokes[i].points);
+    StrokeFreePoints(&canvas->redoStrokes[i]);
     free(canvas->redoStrokes[i].cachedPoints);
   }
   canvas->redoCount = 0;
@@ -20,6 +20,90 @@ void AddStroke(Canvas *canvas, Stroke stroke) {
   }
   canvas->strokes[canvas->strokeCount++] = stroke;
   canvas->totalPoints += stroke.pointCount;
+  CanvasBoundsAdd(canvas, &canvas->strokes[canvas->strokeCount - 1]);
+  JournalRecordAppend(canvas, &stroke);
+}
+
+void CanvasTranslateStroke(Canvas *canvas, int index, Vector2 delta) {
+  if (index < 0 || index >= canvas->strokeCount)
+    return;
+  Stroke *s = &canvas->strokes[index];
+  if (!StrokeMakePointsWritable(s))
+    return;
+  CanvasBoundsRemove(canvas, s);
+  // Moving the corners matches remeasuring, except for a circle's radius.
+  bool shiftBounds = s->boundsVersion == s->cacheVersion + 1u &&
+                     s->shape != STROKE_SHAPE_CIRCLE;
+  for (int i = 0; i < s->pointCount; i++) {
+    s->points[i].x += delta.x;
+    s->points[i].y += delta.y;
+  }
+  s->cacheDirty = true;
+  s->cacheVersion++;
+  if (shiftBounds) {
+    s->boundsMin.x += delta.x;
+    s->boundsMin.y += delta.y;
+    s->boundsMax.x += delta.x;
+    s->boundsMax.y += delta.y;
+    s->boundsVersion = s->cacheVersion + 1u;
+  }
+  CanvasBoundsAdd(canvas, s);
+  JournalRecordTranslate(canvas, index, delta);
+}
+
+void CanvasRemoveStroke(Canvas *canvas, int index) {
+  if (index < 0 || index >= canvas->strokeCount)
+    return;
+  canvas->totalPoints -= canvas->strokes[index].pointCount;
+  CanvasBoundsRemove(canvas, &canvas->strokes[index]);
+  StrokeFreePoints(&canvas->strokes[index]);
+  free(canvas->strokes[index].cachedPoints);
+  for (int i = index; i < canvas->strokeCount - 1; i++)
+    canvas->strokes[i] = canvas->strokes[i + 1];
+  canvas->strokeCount--;
+  if (canvas->selectedStrokeIndex == index)
+    canvas->selectedStrokeIndex = -1;
+  else if (canvas->selectedStrokeIndex > index)
+    canvas->selectedStrokeIndex--;
+  JournalRecordRemove(canvas, index);
+}
+
+bool CanvasReserveStrokes(Canvas *canvas, int extra) {
+  if (canvas->strokeCount + extra <= canvas->capacity)
+    return true;
+  int newCap = (canvas->capacity == 0) ? 64 : canvas->capacity * 2;
+  while (newCap < canvas->strokeCount + extra)
+    newCap *= 2;
+  Stroke *next = (Stroke *)realloc(canvas->strokes, sizeof(Stroke) * (size_t)newCap);
+  if (!next)
+    return false;
+  canvas->strokes = next;
+  canvas->capacity = newCap;
+  return true;
+}
+
+bool CanvasInsertStroke(Canvas *canvas, int index, Stroke stroke) {
+  if (index < 0 || index > canvas->strokeCount)
+    return false;
+  if (canvas->strokeCount >= canvas->capacity) {
+    int newCap = (canvas->capacity == 0) ? 64 : canvas->capacity * 2;
+    Stroke *next =
+        (Stroke *)realloc(canvas->strokes, sizeof(Stroke) * (size_t)newCap);
+    if (!next)
+      return false;
+    canvas->strokes = next;
+    canvas->capacity = newCap;
+  }
+  for (int i = canvas->strokeCount; i > index; i--)
+    canvas->strokes[i] = canvas->strokes[i - 1];
+  canvas->strokes[index] = stroke;
+  canvas->strokeCount++;
+  canvas->totalPoints += stroke.pointCount;
+  CanvasBoundsAdd(canvas, &canvas->strokes[index]);
+  if (canvas->selectedStrokeIndex >= index)
+    canvas->selectedStrokeIndex++;
+  JournalRecordInsert(canvas, index, &stroke);
+  return true;
 }
 
 void Undo(Canvas *canvas) {
@@ -27,6 +111,7 @@ void Undo(Canvas *canvas) {
     return;
   Stroke s = canvas->strokes[--canvas->strokeCount];
   canvas->totalPoints -= s.pointCount;
+  CanvasBoundsRemove(canvas, &s);
   if (canvas->redoCount >= canvas->redoCapacity) {
     int newCap = (canvas->redoCapacity == 0) ? 64 : canvas->redoCapacity * 2;
     canvas->redoStrokes =
@@ -36,6 +121,7 @@ void Undo(Canvas *canvas) {
   canvas->redoStrokes[canvas->redoCount++] = s;
   if (canvas->selectedStrokeIndex >= canvas->strokeCount)
     canvas->selectedStrokeIndex = -1;
+  JournalRecordRemove(canvas, canvas->strokeCount);
   fprintf(stderr, "Action Undone. Strokes: %d\n", canvas->strokeCount);
 }
 
@@ -51,16 +137,20 @@ void Redo(Canvas *canvas) {
   }
   canvas->strokes[canvas->strokeCount++] = s;
   canvas->totalPoints += s.pointCount;
+  CanvasBoundsAdd(canvas, &canvas->strokes[canvas->strokeCount - 1]);
+  JournalRecordAppend(canvas, &s);
   fprintf(stderr, "Action Redone. Strokes: %d\n", canvas->strokeCount);
 }
 
 void ClearCanvas(Canvas *canvas) {
+  CanvasCloseLazy(canvas);
   for (int i = 0; i < canvas->strokeCount; i++) {
-    free(canvas->strokes[i].points);
+    StrokeFreePoints(&canvas->strokes[i]);
     free(canvas->strokes[i].cachedPoints);
   }
   canvas->strokeCount = 0;
   canvas->totalPoints = 0;
+  CanvasBoundsReset(canvas, false);
   ClearRedo(canvas);
 
   canvas->selectedStrokeIndex = -1;
@@ -72,19 +162,20 @@ void ClearCanvas(Canvas *canvas) {
   canvas->currentStroke.pointCount = 0;
   canvas->currentStroke.capacity = 0;
   canvas->currentStroke.usePressure = false;
+  canvas->currentStroke.shape = STROKE_SHAPE_PATH;
   canvas->currentStroke.cachedPoints = NULL;
   canvas->currentStroke.cachedCount = 0;
   canvas->currentStroke.cachedCapacity = 0;
   canvas->currentStroke.cacheVersion = 0;
   canvas->currentStroke.lastBuiltVersion = 0;
   canvas->currentStroke.cacheDirty = false;
+  canvas->currentStroke.boundsVersion = 0;
   canvas->isDrawing = false;
-
-  fprintf(stderr, "Canvas Cleared.\n");
+  JournalRecordClear(canvas);
 }
 
-int GetTotalPoints(const Canvas *canvas) {
-  int total = canvas->totalPoints;
+int64_t GetTotalPoints(const Canvas *canvas) {
+  int64_t total = canvas->totalPoints;
   if (canvas->isDrawing)
     total += canvas->currentStroke.pointCount;
   return total;
@@ -0,0 +1,307 @@
+#include "canvas_packed.h"
+#include "canvas_format.h"
+#include "lz_block.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  FILE *f;
+  uint8_t *raw;
+  size_t len;
+  uint8_t *packed;
+  size_t packedCap;
+  bool ok;
+} PackedWriter;
+
+static uint64_t ZigZag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+
+static int64_t UnZigZag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+static int64_t Quantize(float v) {
+  if (!isfinite(v))
+    return 0;
+  double q = (double)v * PACKED_SCALE;
+  // Keep deltas between any two values inside int64.
+  if (q > 4.0e18)
+    q = 4.0e18;
+  if (q < -4.0e18)
+    q = -4.0e18;
+  return (int64_t)llround(q);
+}
+
+static float Dequantize(int64_t q) { return (float)((double)q / PACKED_SCALE); }
+
+static void PackedFlush(PackedWriter *w) {
+  if (!w->ok || w->len == 0)
+    return;
+  size_t packedSize = LzCompressBlock(w->raw, w->len, w->packed, w->packedCap);
+  const uint8_t *data = w->packed;
+  if (packedSize == 0 || packedSize >= w->len) {
+    packedSize = w->len;
+    data = w->raw;
+  }
+  uint8_t sizes[8];
+  PutU32(sizes, (uint32_t)w->len);
+  PutU32(sizes + 4, (uint32_t)packedSize);
+  if (fwrite(sizes, 1, sizeof(sizes), w->f) != sizeof(sizes) ||
+      fwrite(data, 1, packedSize, w->f) != packedSize)
+    w->ok = false;
+  w->len = 0;
+}
+
+static void PackedReserve(PackedWriter *w, size_t bytes) {
+  if (w->len + bytes > PACKED_BLOCK_SIZE)
+    PackedFlush(w);
+}
+
+static void PackedPutBytes(PackedWriter *w, const uint8_t *data, size_t size) {
+  while (size > 0) {
+    if (w->len == PACKED_BLOCK_SIZE)
+      PackedFlush(w);
+    size_t n = PACKED_BLOCK_SIZE - w->len;
+    if (n > size)
+      n = size;
+    memcpy(w->raw + w->len, data, n);
+    w->len += n;
+    data += n;
+    size -= n;
+  }
+}
+
+// Callers reserve PACKED_MAX_VARINT bytes per value first.
+static void PackedPutVarint(PackedWriter *w, uint64_t v) {
+  uint8_t *p = w->raw + w->len;
+  while (v >= 0x80) {
+    *p++ = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  *p++ = (uint8_t)v;
+  w->len = (size_t)(p - w->raw);
+}
+
+static bool StrokeHasUniformWidth(const Stroke *s) {
+  for (int i = 1; i < s->pointCount; i++) {
+    if (s->points[i].width != s->points[0].width)
+      return false;
+  }
+  return true;
+}
+
+bool WritePackedCanvas(const Canvas *canvas, FILE *f) {
+  if (!canvas)
+    return false;
+  if (canvas->strokeCount < 0)
+    return false;
+
+  uint32_t strokeCount = (uint32_t)canvas->strokeCount;
+  uint8_t preamble[4 + BINARY_HEADER_SIZE];
+  memcpy(preamble, kBinaryMagic, sizeof(kBinaryMagic));
+  PackHeader(canvas, kBinaryVersionPacked, strokeCount, preamble + 4);
+  if (fwrite(preamble, 1, sizeof(preamble), f) != sizeof(preamble))
+    return false;
+
+  PackedWriter w = {f, NULL, 0, NULL, LzBlockBound(PACKED_BLOCK_SIZE), true};
+  w.raw = (uint8_t *)malloc(PACKED_BLOCK_SIZE);
+  w.packed = (uint8_t *)malloc(w.packedCap);
+  if (!w.raw || !w.packed) {
+    free(w.raw);
+    free(w.packed);
+    return false;
+  }
+
+  for (uint32_t i = 0; i < strokeCount && w.ok; i++) {
+    const Stroke *s = &canvas->strokes[i];
+    if (s->pointCount < 0) {
+      w.ok = false;
+      break;
+    }
+    bool uniform = StrokeHasUniformWidth(s);
+    uint8_t record[BINARY_STROKE_SIZE];
+    PackStrokeRecord(s, record);
+    record[10] = uniform ? PACKED_UNIFORM_WIDTH : 0u;
+    PackedPutBytes(&w, record, sizeof(record));
+    if (s->pointCount == 0)
+      continue;
+
+    int64_t px = 0, py = 0, pw = 0;
+    if (uniform) {
+      PackedReserve(&w, PACKED_MAX_VARINT);
+      pw = Quantize(s->points[0].width);
+      PackedPutVarint(&w, ZigZag(pw));
+    }
+    for (int p = 0; p < s->pointCount; p++) {
+      PackedReserve(&w, PACKED_MAX_VARINT * 3);
+      int64_t x = Quantize(s->points[p].x);
+      int64_t y = Quantize(s->points[p].y);
+      PackedPutVarint(&w, ZigZag(x - px));
+      PackedPutVarint(&w, ZigZag(y - py));
+      if (!uniform) {
+        int64_t wq = Quantize(s->points[p].width);
+        PackedPutVarint(&w, ZigZag(wq - pw));
+        pw = wq;
+      }
+      px = x;
+      py = y;
+    }
+  }
+  PackedFlush(&w);
+
+  free(w.raw);
+  free(w.packed);
+  return w.ok;
+}
+
+typedef struct {
+  FILE *f;
+  uint8_t *raw;
+  size_t len;
+  size_t pos;
+  uint8_t *packed;
+  size_t packedCap;
+} PackedReader;
+
+static bool PackedRefill(PackedReader *r) {
+  uint8_t sizes[8];
+  if (fread(sizes, 1, sizeof(sizes), r->f) != sizeof(sizes))
+    return false;
+  uint32_t rawSize = GetU32(sizes);
+  uint32_t packedSize = GetU32(sizes + 4);
+  if (rawSize == 0 || rawSize > PACKED_BLOCK_SIZE || packedSize > r->packedCap)
+    return false;
+  if (packedSize == rawSize) {
+    if (fread(r->raw, 1, rawSize, r->f) != rawSize)
+      return false;
+  } else if (fread(r->packed, 1, packedSize, r->f) != packedSize ||
+             !LzDecompressBlock(r->packed, packedSize, r->raw, rawSize)) {
+    return false;
+  }
+  r->len = rawSize;
+  r->pos = 0;
+  return true;
+}
+
+static bool PackedGetBytes(PackedReader *r, uint8_t *out, size_t size) {
+  while (size > 0) {
+    if (r->pos == r->len && !PackedRefill(r))
+      return false;
+    size_t n = r->len - r->pos;
+    if (n > size)
+      n = size;
+    memcpy(out, r->raw + r->pos, n);
+    r->pos += n;
+    out += n;
+    size -= n;
+  }
+  return true;
+}
+
+static bool PackedGetVarint(PackedReader *r, uint64_t *out) {
+  uint64_t v = 0;
+  if (r->len - r->pos >= PACKED_MAX_VARINT) {
+    // Fast path: the whole value is in the current block.
+    const uint8_t *p = r->raw + r->pos;
+    for (int shift = 0; shift < 7 * PACKED_MAX_VARINT; shift += 7) {
+      uint8_t b = *p++;
+      v |= (uint64_t)(b & 0x7F) << shift;
+      if (b < 0x80) {
+        r->pos = (size_t)(p - r->raw);
+        *out = v;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  for (int shift = 0; shift < 7 * PACKED_MAX_VARINT; shift += 7) {
+    if (r->pos == r->len && !PackedRefill(r))
+      return false;
+    uint8_t b = r->raw[r->pos++];
+    v |= (uint64_t)(b & 0x7F) << shift;
+    if (b < 0x80) {
+      *out = v;
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool PackedGetDelta(PackedReader *r, int64_t *value) {
+  uint64_t v;
+  if (!PackedGetVarint(r, &v))
+    return false;
+  *value += UnZigZag(v);
+  return true;
+}
+
+// Blocks are decoded one at a time, so memory use does not depend on the file
+// size beyond the strokes themselves.
+bool LoadCanvasPacked(Canvas *canvas, FILE *f, const uint8_t *header,
+                      uint64_t *baseEnd, CanvasLoadFeed *feed) {
+  uint32_t flags = GetU32(header + 4);
+  uint32_t strokeCount = GetU32(header + 8);
+  if (strokeCount > CanvasGetLoadLimits().maxStrokes)
+    return false;
+
+  PackedReader r = {f, NULL, 0, 0, NULL, LzBlockBound(PACKED_BLOCK_SIZE)};
+  r.raw = (uint8_t *)malloc(PACKED_BLOCK_SIZE);
+  r.packed = (uint8_t *)malloc(r.packedCap);
+  Stroke *strokes = NULL;
+  if (!r.raw || !r.packed)
+    goto fail;
+
+  ClearCanvas(canvas);
+
+  if (strokeCount > 0) {
+    strokes = (Stroke *)calloc(strokeCount, sizeof(Stroke));
+    if (!strokes)
+      goto fail;
+  }
+
+  uint64_t totalPoints = 0;
+  for (uint32_t i = 0; i < strokeCount; i++) {
+    uint8_t record[BINARY_STROKE_SIZE];
+    if (!PackedGetBytes(&r, record, sizeof(record)))
+      goto fail;
+    uint32_t pointCount = GetU32(record + 12);
+    if (!PointsWithinLimits(totalPoints, pointCount))
+      goto fail;
+
+    Stroke s = UnpackStrokeRecord(record, flags);
+    bool uniform = (record[10] & PACKED_UNIFORM_WIDTH) != 0;
+    if (pointCount > 0) {
+      s.points = (Point *)malloc(sizeof(Point) * (size_t)pointCount);
+      if (!s.points)
+        goto fail;
+      strokes[i] = s;
+
+      int64_t x = 0, y = 0, w = 0;
+      if (uniform && !PackedGetDelta(&r, &w))
+        goto fail;
+      for (uint32_t p = 0; p < pointCount; p++) {
+        if (!PackedGetDelta(&r, &x) || !PackedGetDelta(&r, &y) ||
+            (!uniform && !PackedGetDelta(&r, &w)))
+          goto fail;
+        s.points[p] = (Point){Dequantize(x), Dequantize(y), Dequantize(w)};
+      }
+    }
+
+    strokes[i] = s;
+    totalPoints += pointCount;
+    if (!FeedStroke(feed, &strokes[i]))
+      goto fail;
+  }
+
+  *baseEnd = (uint64_t)ftell(f);
+  free(r.raw);
+  free(r.packed);
+  PublishLoadedStrokes(canvas, header, strokes, strokeCount, totalPoints);
+  return true;
+
+fail:
+  free(r.raw);
+  free(r.packed);
+  FreeLoadedStrokes(strokes, strokeCount);
+  ClearCanvas(canvas);
+  return false;
+}
@@ -0,0 +1,15 @@
+#ifndef CANVAS_PACKED_H
+#define CANVAS_PACKED_H
+
+#include "canvas.h"
+#include <stdint.h>
+#include <stdio.h>
+
+// Compressed .cdraw files (v3): stroke records and delta-coded points in LZ
+// blocks. `header` is the one after the magic; loads set `baseEnd` to where a
+// journal may follow.
+bool WritePackedCanvas(const Canvas *canvas, FILE *f);
+bool LoadCanvasPacked(Canvas *canvas, FILE *f, const uint8_t *header,
+                      uint64_t *baseEnd, CanvasLoadFeed *feed);
+
+#endif // CANVAS_PACKED_H
@@ -0,0 +1,731 @@
+#include "canvas_internal.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Software renderer: the same geometry DrawCanvas hands to GL, as capsules
+// and convex polygons in output pixels. Each stroke's coverage is the
+// largest of its primitives', computed eight pixels at a time, then blended
+// in one pass per stroke. The image is split into tiles rendered on every
+// core; each primitive is binned to the tiles it touches, in drawing order.
+
+#define RASTER_TILE 64
+#define RASTER_LANES 8
+#define RASTER_CHUNKS (RASTER_TILE / RASTER_LANES)
+#define RASTER_MAX_THREADS 16
+
+// Eight floats. The x86-64 build has an AVX2 copy of the tile loop chosen at
+// run time; elsewhere the compiler maps the vectors onto what the target has.
+typedef float RasterVec __attribute__((vector_size(RASTER_LANES * sizeof(float))));
+typedef int32_t RasterVecI __attribute__((vector_size(RASTER_LANES * sizeof(int32_t))));
+
+#define RASTER_INLINE static inline __attribute__((always_inline))
+
+// `corners` 0 is a capsule: the segment (x[0], y[0])-(x[1], y[1]) widened by
+// a radius running from x[2] to x[3] along it, round at both ends (a dot
+// when they meet). Otherwise a convex polygon of that many corners, in
+// either winding.
+typedef struct {
+  int shape;
+  int corners;
+  float x[4];
+  float y[4];
+} RasterPrim;
+
+typedef struct {
+  float minX, minY, maxX, maxY;
+} RasterBox;
+
+typedef struct {
+  float r, g, b, a;
+} RasterColor;
+
+typedef struct {
+  RasterPrim *prims;
+  int primCount;
+  int primCapacity;
+  RasterColor *shapes;
+  int shapeCount;
+  int shapeCapacity;
+  Point *scratch;
+  int scratchCapacity;
+
+  // World to output pixels: the camera's rotation and zoom, then its offset
+  // less the buffer's place in the view.
+  Camera2D camera;
+  float cosR, sinR;
+  float originX, originY;
+  int width, height;
+  bool failed;
+} RasterBuilder;
+
+typedef struct {
+  const RasterBuilder *b;
+  RasterColor background;
+  int tilesX, tilesY;
+  size_t *binStart; // tilesX * tilesY + 1 offsets into `bins`
+  int *bins;        // primitive indices, in drawing order per tile
+  uint8_t *rgba;
+  size_t stride;
+  int next; // claimed atomically by the workers
+  bool failed;
+} RasterJob;
+
+typedef struct {
+  RasterVec color[4][RASTER_TILE * RASTER_CHUNKS]; // r, g, b, a planes
+  RasterVec cover[RASTER_TILE * RASTER_CHUNKS];
+} RasterTile;
+
+// Plain comparisons; fminf and friends are library calls without -ffast-math.
+static inline float MinF(float a, float b) { return a < b ? a : b; }
+static inline float MaxF(float a, float b) { return a > b ? a : b; }
+
+static bool EnsureCapacity(void **items, int *capacity, int needed, size_t size) {
+  if (*capacity >= needed)
+    return true;
+  int newCap = (*capacity == 0) ? 64 : *capacity;
+  while (newCap < needed) {
+    if (newCap > INT32_MAX / 2)
+      return false;
+    newCap *= 2;
+  }
+  void *next = realloc(*items, size * (size_t)newCap);
+  if (!next)
+    return false;
+  *items = next;
+  *capacity = newCap;
+  return true;
+}
+
+RASTER_INLINE RasterBox PrimBox(const RasterPrim *p) {
+  RasterBox box;
+  if (p->corners == 0) {
+    float r = MaxF(p->x[2], p->x[3]);
+    box.minX = MinF(p->x[0], p->x[1]) - r;
+    box.maxX = MaxF(p->x[0], p->x[1]) + r;
+    box.minY = MinF(p->y[0], p->y[1]) - r;
+    box.maxY = MaxF(p->y[0], p->y[1]) + r;
+    return box;
+  }
+  box.minX = box.maxX = p->x[0];
+  box.minY = box.maxY = p->y[0];
+  for (int i = 1; i < p->corners; i++) {
+    box.minX = MinF(box.minX, p->x[i]);
+    box.maxX = MaxF(box.maxX, p->x[i]);
+    box.minY = MinF(box.minY, p->y[i]);
+    box.maxY = MaxF(box.maxY, p->y[i]);
+  }
+  return box;
+}
+
+static RasterColor ColorToRaster(Color c) {
+  return (RasterColor){c.r / 255.0f, c.g / 255.0f, c.b / 255.0f, c.a / 255.0f};
+}
+
+static void BeginShape(RasterBuilder *b, Color color) {
+  if (!EnsureCapacity((void **)&b->shapes, &b->shapeCapacity, b->shapeCount + 1,
+                      sizeof(RasterColor))) {
+    b->failed = true;
+    return;
+  }
+  b->shapes[b->shapeCount++] = ColorToRaster(color);
+}
+
+static Vector2 ToPixels(const RasterBuilder *b, Vector2 p) {
+  float dx = (p.x - b->camera.target.x) * b->camera.zoom;
+  float dy = (p.y - b->camera.target.y) * b->camera.zoom;
+  return (Vector2){dx * b->cosR - dy * b->sinR + b->camera.offset.x - b->originX,
+                   dx * b->sinR + dy * b->cosR + b->camera.offset.y - b->originY};
+}
+
+// Primitives entirely outside the buffer are dropped here.
+static void PushPrim(RasterBuilder *b, const RasterPrim *p) {
+  RasterBox box = PrimBox(p);
+  if (!(box.maxX > -1.0f && box.maxY > -1.0f && box.minX < (float)b->width + 1.0f &&
+        box.minY < (float)b->height + 1.0f))
+    return;
+  if (!EnsureCapacity((void **)&b->prims, &b->primCapacity, b->primCount + 1,
+                      sizeof(RasterPrim))) {
+    b->failed = true;
+    return;
+  }
+  RasterPrim *out = &b->prims[b->primCount++];
+  *out = *p;
+  out->shape = b->shapeCount - 1;
+}
+
+// DrawLineEx plus DrawCircleV at both ends; the widths may differ, as the
+// trapezoids of a pressure stroke do.
+static void PushCapsule(RasterBuilder *b, Vector2 a, Vector2 c, float widthA,
+                        float widthC) {
+  Vector2 pa = ToPixels(b, a);
+  Vector2 pc = ToPixels(b, c);
+  RasterPrim p = {0};
+  p.x[0] = pa.x;
+  p.y[0] = pa.y;
+  p.x[1] = pc.x;
+  p.y[1] = pc.y;
+  p.x[2] = widthA * 0.5f * b->camera.zoom;
+  p.x[3] = widthC * 0.5f * b->camera.zoom;
+  PushPrim(b, &p);
+}
+
+static void PushPolygon(RasterBuilder *b, const Vector2 *pts, int count) {
+  RasterPrim p = {0};
+  p.corners = count;
+  for (int i = 0; i < count; i++) {
+    Vector2 q = ToPixels(b, pts[i]);
+    p.x[i] = q.x;
+    p.y[i] = q.y;
+  }
+  PushPrim(b, &p);
+}
+
+// DrawLineEx alone: a flat-ended bar.
+static void PushBar(RasterBuilder *b, Vector2 a, Vector2 c, float thickness) {
+  float dx = c.x - a.x;
+  float dy = c.y - a.y;
+  float len = sqrtf(dx * dx + dy * dy);
+  if (len <= 0.0001f)
+    return;
+  float h = thickness * 0.5f / len;
+  Vector2 n = {-dy * h, dx * h};
+  Vector2 quad[4] = {{a.x + n.x, a.y + n.y},
+                     {c.x + n.x, c.y + n.y},
+                     {c.x - n.x, c.y - n.y},
+                     {a.x - n.x, a.y - n.y}};
+  PushPolygon(b, quad, 4);
+}
+
+// StrokeDrawPath of canvas_render.c: shapes as their tessellated outline.
+static const Stroke *RasterPath(RasterBuilder *b, const Stroke *s, Stroke *view) {
+  if (s->shape != STROKE_SHAPE_RECT && s->shape != STROKE_SHAPE_CIRCLE)
+    return s;
+  int count = StrokeOutlineCount(s, b->camera.zoom);
+  if (!EnsureCapacity((void **)&b->scratch, &b->scratchCapacity, count,
+                      sizeof(Point))) {
+    b->failed = true;
+    return NULL;
+  }
+  *view = *s;
+  view->points = b->scratch;
+  view->pointCount = StrokeOutline(s, b->camera.zoom, b->scratch);
+  view->shape = STROKE_SHAPE_PATH;
+  return view;
+}
+
+static void PushArrow(RasterBuilder *b, const Stroke *s, float thickness) {
+  Vector2 shaftEnd;
+  Vector2 head[3];
+  if (!StrokeArrowHead(s, thickness, &shaftEnd, head))
+    return;
+  PushBar(b, (Vector2){s->points[0].x, s->points[0].y}, shaftEnd, thickness);
+  PushPolygon(b, head, 3);
+}
+
+// DrawStrokeVariableWidth draws each segment as a trapezoid with a dot at
+// either end, which is a capsule whose radius follows the width.
+static void PushVariableWidth(RasterBuilder *b, Stroke *s, float baseWidth) {
+  int count = StrokeSmoothedPoints(s, baseWidth);
+  const Point *pts = s->cachedPoints;
+  for (int i = 0; i + 1 < count && !b->failed; i++)
+    PushCapsule(b, (Vector2){pts[i].x, pts[i].y}, (Vector2){pts[i + 1].x, pts[i + 1].y},
+                pts[i].width, pts[i + 1].width);
+}
+
+// The same decisions as DrawStroke, or as DrawStrokeSolid for the selection
+// outline (`sketchy` false).
+static void PushStroke(RasterBuilder *b, Stroke *stroke, float thickness,
+                       bool sketchy) {
+  if (stroke->pointCount < 2)
+    return;
+  if (stroke->shape == STROKE_SHAPE_ARROW) {
+    PushArrow(b, stroke, thickness);
+    return;
+  }
+  if (sketchy && stroke->usePressure) {
+    PushVariableWidth(b, stroke, thickness);
+    return;
+  }
+
+  Stroke view;
+  const Stroke *s = RasterPath(b, stroke, &view);
+  if (!s)
+    return;
+  bool closed;
+  int loopCount = StrokeLoopCount(s, &closed);
+  if (closed && loopCount < 4) {
+    for (int i = 0; i < loopCount; i++) {
+      const Point *p = &s->points[i];
+      const Point *q = &s->points[(i + 1) % loopCount];
+      PushBar(b, (Vector2){p->x, p->y}, (Vector2){q->x, q->y}, thickness);
+    }
+    return;
+  }
+
+  uint32_t seed = StrokeSeed(s);
+  float amp = fmaxf(0.35f, thickness * 0.18f);
+  float wavelength = fmaxf(10.0f, thickness * 2.5f);
+  float dist = 0.0f;
+  Vector2 first = {s->points[0].x, s->points[0].y};
+  if (sketchy)
+    first = JitterPoint(s->points, loopCount, closed, 0, 0.0f, amp, wavelength, seed);
+  Vector2 prev = first;
+  PushCapsule(b, prev, prev, thickness, thickness);
+  for (int i = 1; i < loopCount && !b->failed; i++) {
+    Vector2 curr = {s->points[i].x, s->points[i].y};
+    if (sketchy) {
+      float dx = s->points[i].x - s->points[i - 1].x;
+      float dy = s->points[i].y - s->points[i - 1].y;
+      dist += sqrtf(dx * dx + dy * dy);
+      curr = JitterPoint(s->points, loopCount, closed, i, dist, amp, wavelength, seed);
+    }
+    PushCapsule(b, prev, curr, thickness, thickness);
+    prev = curr;
+  }
+  if (closed)
+    PushCapsule(b, prev, first, thickness, thickness);
+}
+
+// Strokes whose control points, widened by anything drawn around them, miss
+// the buffer are skipped before any geometry is built.
+static bool StrokeMayShow(const RasterBuilder *b, const Stroke *s, float thickness) {
+  Rectangle r;
+  if (!StrokeGetBounds(s, &r))
+    return false;
+  // Arrow heads reach furthest: 2.2 thicknesses or 8.8 units to each side.
+  float pad = thickness * 2.5f + 10.0f;
+  RasterPrim box = {0};
+  box.corners = 4;
+  for (int i = 0; i < 4; i++) {
+    Vector2 p = ToPixels(b, (Vector2){(i & 1) ? r.x + r.width + pad : r.x - pad,
+                                      (i & 2) ? r.y + r.height + pad : r.y - pad});
+    box.x[i] = p.x;
+    box.y[i] = p.y;
+  }
+  RasterBox px = PrimBox(&box);
+  return px.maxX > 0.0f && px.maxY > 0.0f && px.minX < (float)b->width &&
+         px.minY < (float)b->height;
+}
+
+// DrawInfiniteGrid over the buffer: one-pixel lines at the same spacing.
+static void PushGrid(RasterBuilder *b, Color color) {
+  float zoom = b->camera.zoom;
+  float spacing = 40.0f;
+  if (zoom > 2.0f)
+    spacing *= 0.5f;
+  if (zoom < 0.5f)
+    spacing *= 2.0f;
+  if (zoom < 0.25f)
+    spacing *= 4.0f;
+  // Lines closer than a pixel would only fill the buffer with grid colour.
+  if (spacing * zoom < 1.0f)
+    return;
+
+  // World rectangle around the buffer, from its corners.
+  RasterPrim corners = {0};
+  corners.corners = 4;
+  for (int i = 0; i < 4; i++) {
+    float dx = (((i & 1) ? (float)b->width : 0.0f) + b->originX - b->camera.offset.x) / zoom;
+    float dy = (((i & 2) ? (float)b->height : 0.0f) + b->originY - b->camera.offset.y) / zoom;
+    corners.x[i] = dx * b->cosR + dy * b->sinR + b->camera.target.x;
+    corners.y[i] = -dx * b->sinR + dy * b->cosR + b->camera.target.y;
+  }
+  RasterBox w = PrimBox(&corners);
+
+  int startCol = (int)floorf(w.minX / spacing);
+  int endCol = (int)ceilf(w.maxX / spacing);
+  int startRow = (int)floorf(w.minY / spacing);
+  int endRow = (int)ceilf(w.maxY / spacing);
+  float width = 1.0f / zoom;
+  for (int i = startCol; i <= endCol && !b->failed; i++) {
+    float x = i * spacing;
+    BeginShape(b, color);
+    PushBar(b, (Vector2){x, w.minY}, (Vector2){x, w.maxY}, width);
+  }
+  for (int i = startRow; i <= endRow && !b->failed; i++) {
+    float y = i * spacing;
+    BeginShape(b, color);
+    PushBar(b, (Vector2){w.minX, y}, (Vector2){w.maxX, y}, width);
+  }
+}
+
+static void BuildScene(RasterBuilder *b, Canvas *canvas) {
+  if (canvas->showGrid)
+    PushGrid(b, canvas->gridColor);
+
+  for (int i = 0; i < canvas->strokeCount && !b->failed; i++) {
+    Stroke *s = &canvas->strokes[i];
+    if (!StrokeMayShow(b, s, s->thickness))
+      continue;
+    BeginShape(b, s->color);
+    PushStroke(b, s, s->thickness, true);
+  }
+
+  if (canvas->selectedStrokeIndex >= 0 &&
+      canvas->selectedStrokeIndex < canvas->strokeCount && !b->failed) {
+    Stroke *s = &canvas->strokes[canvas->selectedStrokeIndex];
+    BeginShape(b, canvas->selectionColor);
+    PushStroke(b, s, s->thickness + 2.0f, false);
+  }
+}
+
+// Tile holding pixel coordinate `v`, clamped to the grid.
+static int TileOf(float v, int tiles) {
+  if (v <= 0.0f)
+    return 0;
+  if (v >= (float)tiles * RASTER_TILE)
+    return tiles - 1;
+  return (int)v / RASTER_TILE;
+}
+
+// Tiles a primitive touches, with a pixel of antialiasing fringe.
+static void PrimTiles(const RasterJob *job, const RasterPrim *p, int *tx0, int *ty0,
+                      int *tx1, int *ty1) {
+  RasterBox box = PrimBox(p);
+  *tx0 = TileOf(box.minX - 1.0f, job->tilesX);
+  *ty0 = TileOf(box.minY - 1.0f, job->tilesY);
+  *tx1 = TileOf(box.maxX + 1.0f, job->tilesX);
+  *ty1 = TileOf(box.maxY + 1.0f, job->tilesY);
+}
+
+static bool BinPrims(RasterJob *job) {
+  const RasterBuilder *b = job->b;
+  size_t tiles = (size_t)job->tilesX * (size_t)job->tilesY;
+  job->binStart = (size_t *)calloc(tiles + 1, sizeof(size_t));
+  if (!job->binStart)
+    return false;
+  for (int i = 0; i < b->primCount; i++) {
+    int tx0, ty0, tx1, ty1;
+    PrimTiles(job, &b->prims[i], &tx0, &ty0, &tx1, &ty1);
+    for (int ty = ty0; ty <= ty1; ty++)
+      for (int tx = tx0; tx <= tx1; tx++)
+        job->binStart[(size_t)ty * (size_t)job->tilesX + (size_t)tx + 1]++;
+  }
+  for (size_t t = 0; t < tiles; t++)
+    job->binStart[t + 1] += job->binStart[t];
+  if (job->binStart[tiles] == 0)
+    return true;
+
+  job->bins = (int *)malloc(sizeof(int) * job->binStart[tiles]);
+  size_t *fill = (size_t *)malloc(sizeof(size_t) * tiles);
+  if (!job->bins || !fill) {
+    free(fill);
+    return false;
+  }
+  memcpy(fill, job->binStart, sizeof(size_t) * tiles);
+  for (int i = 0; i < b->primCount; i++) {
+    int tx0, ty0, tx1, ty1;
+    PrimTiles(job, &b->prims[i], &tx0, &ty0, &tx1, &ty1);
+    for (int ty = ty0; ty <= ty1; ty++)
+      for (int tx = tx0; tx <= tx1; tx++)
+        job->bins[fill[(size_t)ty * (size_t)job->tilesX + (size_t)tx]++] = i;
+  }
+  free(fill);
+  return true;
+}
+
+RASTER_INLINE RasterVec Splat(float v) { return (RasterVec){0} + v; }
+
+RASTER_INLINE RasterVec Select(RasterVecI mask, RasterVec a, RasterVec b) {
+  return (RasterVec)((mask & (RasterVecI)a) | (~mask & (RasterVecI)b));
+}
+
+RASTER_INLINE RasterVec VecMin(RasterVec a, RasterVec b) { return Select(a < b, a, b); }
+
+RASTER_INLINE RasterVec VecMax(RasterVec a, RasterVec b) { return Select(a > b, a, b); }
+
+RASTER_INLINE RasterVec Clamp01(RasterVec v) {
+  return VecMin(VecMax(v, Splat(0.0f)), Splat(1.0f));
+}
+
+// sqrt(v) for v >= 0 from a bit-trick inverse square root and two Newton
+// steps, good to about 1e-5 relative; vector extensions have no sqrt.
+RASTER_INLINE RasterVec VecSqrt(RasterVec v) {
+  RasterVecI bits = (RasterVecI)v;
+  RasterVec y = (RasterVec)(((RasterVecI){0} + 0x5f3759df) - (bits >> 1));
+  RasterVec half = v * 0.5f;
+  y = y * (1.5f - half * y * y);
+  y = y * (1.5f - half * y * y);
+  return v * y;
+}
+
+// Pixel rows and eight-pixel columns of a tile a primitive covers.
+typedef struct {
+  int y0, y1; // rows, end exclusive
+  int c0, c1; // chunks, end exclusive
+} RasterSpan;
+
+RASTER_INLINE bool ClipSpan(RasterBox box, RasterSpan *span) {
+  float x0 = box.minX - 1.0f, y0 = box.minY - 1.0f;
+  float x1 = box.maxX + 1.0f, y1 = box.maxY + 1.0f;
+  if (x1 <= 0.0f || y1 <= 0.0f || x0 >= (float)RASTER_TILE || y0 >= (float)RASTER_TILE)
+    return false;
+  span->c0 = x0 <= 0.0f ? 0 : (int)x0 / RASTER_LANES;
+  span->c1 = x1 >= (float)RASTER_TILE ? RASTER_CHUNKS : (int)x1 / RASTER_LANES + 1;
+  span->y0 = y0 <= 0.0f ? 0 : (int)y0;
+  span->y1 = y1 >= (float)RASTER_TILE ? RASTER_TILE : (int)y1 + 1;
+  return true;
+}
+
+// Coverage of a capsule from its distance field: 0.5 - (distance to the
+// segment - radius there), clamped, so it fades over the edge pixel.
+RASTER_INLINE bool CoverCapsule(RasterTile *t, const RasterPrim *p, float ox, float oy,
+                                RasterSpan *span) {
+  RasterBox box = PrimBox(p);
+  box.minX -= ox;
+  box.maxX -= ox;
+  box.minY -= oy;
+  box.maxY -= oy;
+  if (!ClipSpan(box, span))
+    return false;
+  float ax = p->x[0] - ox, ay = p->y[0] - oy;
+  float dx = p->x[1] - p->x[0], dy = p->y[1] - p->y[0];
+  float lenSq = dx * dx + dy * dy;
+  float inv = lenSq > 1e-12f ? 1.0f / lenSq : 0.0f;
+  float r0 = p->x[2], dr = p->x[3] - p->x[2];
+  RasterVec lane = {0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f};
+  for (int y = span->y0; y < span->y1; y++) {
+    float py = (float)y + 0.5f - ay;
+    RasterVec *row = &t->cover[y * RASTER_CHUNKS];
+    for (int c = span->c0; c < span->c1; c++) {
+      RasterVec px = lane + ((float)(c * RASTER_LANES) - ax);
+      RasterVec h = Clamp01((px * dx + py * dy) * inv);
+      RasterVec ex = px - dx * h;
+      RasterVec ey = py - dy * h;
+      RasterVec cov = Clamp01((0.5f + r0) + dr * h - VecSqrt(ex * ex + ey * ey));
+      row[c] = VecMax(row[c], cov);
+    }
+  }
+  return true;
+}
+
+// Coverage of a convex polygon from its nearest edge: each edge line gives a
+// signed distance, positive inside, and the smallest one decides.
+RASTER_INLINE bool CoverPolygon(RasterTile *t, const RasterPrim *p, float ox, float oy,
+                                RasterSpan *span) {
+  RasterBox box = PrimBox(p);
+  box.minX -= ox;
+  box.maxX -= ox;
+  box.minY -= oy;
+  box.maxY -= oy;
+  if (!ClipSpan(box, span))
+    return false;
+  float x[4], y[4];
+  float area = 0.0f;
+  for (int i = 0; i < p->corners; i++) {
+    x[i] = p->x[i] - ox;
+    y[i] = p->y[i] - oy;
+  }
+  for (int i = 0; i < p->corners; i++) {
+    int j = (i + 1) % p->corners;
+    area += x[i] * y[j] - x[j] * y[i];
+  }
+  if (area > -1e-6f && area < 1e-6f)
+    return false;
+
+  // Edge e is nx * px + ny * py + k, in pixels and facing inwards.
+  float nx[4], ny[4], k[4];
+  int edges = 0;
+  float sign = area > 0.0f ? 1.0f : -1.0f;
+  for (int i = 0; i < p->corners; i++) {
+    int j = (i + 1) % p->corners;
+    float ex = x[j] - x[i], ey = y[j] - y[i];
+    float len = sqrtf(ex * ex + ey * ey);
+    if (len <= 1e-6f)
+      continue;
+    nx[edges] = -ey / len * sign;
+    ny[edges] = ex / len * sign;
+    k[edges] = -(nx[edges] * x[i] + ny[edges] * y[i]);
+    edges++;
+  }
+  RasterVec lane = {0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f};
+  for (int yy = span->y0; yy < span->y1; yy++) {
+    float py = (float)yy + 0.5f;
+    RasterVec *row = &t->cover[yy * RASTER_CHUNKS];
+    for (int c = span->c0; c < span->c1; c++) {
+      RasterVec px = lane + (float)(c * RASTER_LANES);
+      RasterVec d = px * nx[0] + (ny[0] * py + k[0]);
+      for (int e = 1; e < edges; e++)
+        d = VecMin(d, px * nx[e] + (ny[e] * py + k[e]));
+      row[c] = VecMax(row[c], Clamp01(d + 0.5f));
+    }
+  }
+  return true;
+}
+
+// Blends one stroke's coverage over the tile and clears it for the next.
+RASTER_INLINE void CompositeShape(RasterTile *t, RasterColor color, const RasterSpan *span) {
+  float src[4] = {color.r, color.g, color.b, color.a};
+  for (int y = span->y0; y < span->y1; y++) {
+    for (int c = span->c0; c < span->c1; c++) {
+      int at = y * RASTER_CHUNKS + c;
+      RasterVec a = t->cover[at] * color.a;
+      for (int ch = 0; ch < 4; ch++)
+        t->color[ch][at] += (src[ch] - t->color[ch][at]) * a;
+      t->cover[at] = Splat(0.0f);
+    }
+  }
+}
+
+RASTER_INLINE void RenderTileBody(RasterJob *job, int tile, RasterTile *t) {
+  const RasterBuilder *b = job->b;
+  float ox = (float)(tile % job->tilesX * RASTER_TILE);
+  float oy = (float)(tile / job->tilesX * RASTER_TILE);
+
+  RasterColor bg = job->background;
+  float fill[4] = {bg.r, bg.g, bg.b, bg.a};
+  for (int ch = 0; ch < 4; ch++)
+    for (int i = 0; i < RASTER_TILE * RASTER_CHUNKS; i++)
+      t->color[ch][i] = Splat(fill[ch]);
+
+  size_t end = job->binStart[tile + 1];
+  for (size_t i = job->binStart[tile]; i < end;) {
+    int shape = b->prims[job->bins[i]].shape;
+    RasterSpan dirty = {RASTER_TILE, 0, RASTER_CHUNKS, 0};
+    for (; i < end && b->prims[job->bins[i]].shape == shape; i++) {
+      const RasterPrim *p = &b->prims[job->bins[i]];
+      RasterSpan span;
+      bool hit = p->corners == 0 ? CoverCapsule(t, p, ox, oy, &span)
+                                 : CoverPolygon(t, p, ox, oy, &span);
+      if (!hit)
+        continue;
+      dirty.y0 = span.y0 < dirty.y0 ? span.y0 : dirty.y0;
+      dirty.y1 = span.y1 > dirty.y1 ? span.y1 : dirty.y1;
+      dirty.c0 = span.c0 < dirty.c0 ? span.c0 : dirty.c0;
+      dirty.c1 = span.c1 > dirty.c1 ? span.c1 : dirty.c1;
+    }
+    if (dirty.y0 < dirty.y1)
+      CompositeShape(t, b->shapes[shape], &dirty);
+  }
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+__attribute__((target("avx2,fma"))) static void RenderTileAvx2(RasterJob *job, int tile,
+                                                              RasterTile *t) {
+  RenderTileBody(job, tile, t);
+}
+
+static bool HaveAvx2(void) {
+  static int have = -1;
+  int known = __atomic_load_n(&have, __ATOMIC_RELAXED);
+  if (known < 0) {
+    __builtin_cpu_init();
+    known = (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) ? 1 : 0;
+    __atomic_store_n(&have, known, __ATOMIC_RELAXED);
+  }
+  return known != 0;
+}
+#endif
+
+static void RenderTileDefault(RasterJob *job, int tile, RasterTile *t) {
+  RenderTileBody(job, tile, t);
+}
+
+static void StoreTile(RasterJob *job, int tile, const RasterTile *t) {
+  int x0 = tile % job->tilesX * RASTER_TILE;
+  int y0 = tile / job->tilesX * RASTER_TILE;
+  int w = job->b->width - x0 < RASTER_TILE ? job->b->width - x0 : RASTER_TILE;
+  int h = job->b->height - y0 < RASTER_TILE ? job->b->height - y0 : RASTER_TILE;
+  const float *planes[4];
+  for (int ch = 0; ch < 4; ch++)
+    planes[ch] = (const float *)t->color[ch];
+  for (int y = 0; y < h; y++) {
+    uint8_t *out = job->rgba + job->stride * (size_t)(y0 + y) + (size_t)x0 * 4;
+    for (int x = 0; x < w; x++) {
+      for (int ch = 0; ch < 4; ch++) {
+        float v = MinF(MaxF(planes[ch][y * RASTER_TILE + x], 0.0f), 1.0f);
+        out[x * 4 + ch] = (uint8_t)(v * 255.0f + 0.5f);
+      }
+    }
+  }
+}
+
+static void *RasterWorker(void *arg) {
+  RasterJob *job = (RasterJob *)arg;
+  void (*render)(RasterJob *, int, RasterTile *) = RenderTileDefault;
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  if (HaveAvx2())
+    render = RenderTileAvx2;
+#endif
+  void *mem = NULL;
+  if (posix_memalign(&mem, sizeof(RasterVec), sizeof(RasterTile)) != 0) {
+    __atomic_store_n(&job->failed, true, __ATOMIC_RELAXED);
+    return NULL;
+  }
+  RasterTile *t = (RasterTile *)mem;
+  memset(t->cover, 0, sizeof(t->cover));
+  int tiles = job->tilesX * job->tilesY;
+  for (;;) {
+    int tile = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+    if (tile >= tiles)
+      break;
+    render(job, tile, t);
+    StoreTile(job, tile, t);
+  }
+  free(mem);
+  return NULL;
+}
+
+static int RasterThreads(int wanted, int tiles) {
+  if (wanted <= 0) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    wanted = cores < 1 ? 1 : (int)cores;
+  }
+  if (wanted > RASTER_MAX_THREADS)
+    wanted = RASTER_MAX_THREADS;
+  return wanted < tiles ? wanted : tiles;
+}
+
+bool CanvasRasterize(Canvas *canvas, int x, int y, int width, int height,
+                     uint8_t *rgba, size_t stride, int threads) {
+  if (!canvas || !rgba || width <= 0 || height <= 0 || stride < (size_t)width * 4 ||
+      !(canvas->camera.zoom > 0.0f))
+    return false;
+  // Tile indices are ints.
+  if ((int64_t)((width + RASTER_TILE - 1) / RASTER_TILE) *
+          ((height + RASTER_TILE - 1) / RASTER_TILE) > INT32_MAX)
+    return false;
+
+  RasterBuilder b = {0};
+  b.camera = canvas->camera;
+  float angle = canvas->camera.rotation * DEG2RAD;
+  b.cosR = cosf(angle);
+  b.sinR = sinf(angle);
+  b.originX = (float)x;
+  b.originY = (float)y;
+  b.width = width;
+  b.height = height;
+  BuildScene(&b, canvas);
+
+  RasterJob job = {0};
+  job.b = &b;
+  job.background = ColorToRaster(canvas->backgroundColor);
+  job.tilesX = (width + RASTER_TILE - 1) / RASTER_TILE;
+  job.tilesY = (height + RASTER_TILE - 1) / RASTER_TILE;
+  job.rgba = rgba;
+  job.stride = stride;
+  bool ok = !b.failed && BinPrims(&job);
+  if (ok) {
+    pthread_t workers[RASTER_MAX_THREADS];
+    int want = RasterThreads(threads, job.tilesX * job.tilesY);
+    int started = 0;
+    // Fewer threads than asked for is fine; this one works through the rest.
+    while (started + 1 < want &&
+           pthread_create(&workers[started], NULL, RasterWorker, &job) == 0)
+      started++;
+    RasterWorker(&job);
+    for (int i = 0; i < started; i++)
+      pthread_join(workers[i], NULL);
+    ok = !job.failed;
+  }
+
+  free(job.binStart);
+  free(job.bins);
+  free(b.prims);
+  free(b.shapes);
+  free(b.scratch);
+  return ok;
+}
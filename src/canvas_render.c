@@ -1,238 +1,31 @@
-#include "canvas.h"
+#include "canvas_internal.h"
 #include "raymath.h"
 #include <math.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
-static float *gWidthScratch = NULL;
-static int gWidthScratchCapacity = 0;
+static Point *gOutlineScratch = NULL;
+static int gOutlineScratchCapacity = 0;
 
-static float *EnsureWidthScratch(int count) {
+static Point *EnsureOutlineScratch(int count) {
   if (count <= 0)
     return NULL;
-  if (gWidthScratchCapacity >= count)
-    return gWidthScratch;
-  int newCap = (gWidthScratchCapacity == 0) ? 64 : gWidthScratchCapacity;
+  if (gOutlineScratchCapacity >= count)
+    return gOutlineScratch;
+  int newCap = (gOutlineScratchCapacity == 0) ? 64 : gOutlineScratchCapacity;
   while (newCap < count)
     newCap *= 2;
-  float *next = (float *)realloc(gWidthScratch, sizeof(float) * (size_t)newCap);
+  Point *next = (Point *)realloc(gOutlineScratch, sizeof(Point) * (size_t)newCap);
   if (!next)
     return NULL;
-  gWidthScratch = next;
-  gWidthScratchCapacity = newCap;
-  return gWidthScratch;
-}
-
-static bool EnsureStrokeCache(Stroke *s, int needed) {
-  if (needed <= 0)
-    return false;
-  if (s->cachedCapacity >= needed)
-    return true;
-  int newCap = (s->cachedCapacity == 0) ? 64 : s->cachedCapacity;
-  while (newCap < needed)
-    newCap *= 2;
-  Point *next =
-      (Point *)realloc(s->cachedPoints, sizeof(Point) * (size_t)newCap);
-  if (!next)
-    return false;
-  s->cachedPoints = next;
-  s->cachedCapacity = newCap;
-  return true;
+  gOutlineScratch = next;
+  gOutlineScratchCapacity = newCap;
+  return gOutlineScratch;
 }
 
 static Vector2 PointAsVector2(Point p) { return (Vector2){p.x, p.y}; }
 
-static float PointWidth(const Point *p, float base) {
-  if (p->width > 0.0f)
-    return p->width;
-  return base;
-}
-
-static float ClampFloat(float v, float min, float max) {
-  if (v < min)
-    return min;
-  if (v > max)
-    return max;
-  return v;
-}
-
-static float SmoothStep01(float t) { return t * t * (3.0f - 2.0f * t); }
-
-static float CatmullRom(float p0, float p1, float p2, float p3, float t) {
-  float t2 = t * t;
-  float t3 = t2 * t;
-  return 0.5f * ((2.0f * p1) + (-p0 + p2) * t +
-                 (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
-                 (-p0 + 3.0f * p1 - 3.0f * p2 + p3) * t3);
-}
-
-static void SmoothPointWidths(Point *points, int count, int passes) {
-  if (count < 3 || passes <= 0)
-    return;
-  float *tmp = EnsureWidthScratch(count);
-  if (!tmp)
-    return;
-
-  for (int pass = 0; pass < passes; pass++) {
-    tmp[0] = points[0].width;
-    tmp[count - 1] = points[count - 1].width;
-    for (int i = 1; i < count - 1; i++)
-      tmp[i] =
-          (points[i - 1].width + points[i].width * 2.0f + points[i + 1].width) *
-          0.25f;
-    for (int i = 0; i < count; i++)
-      points[i].width = tmp[i];
-  }
-
-}
-
-static void ApplyStrokeTaper(Point *points, int count, float baseWidth) {
-  if (count < 3)
-    return;
-  int taperCount = count / 4;
-  if (taperCount < 3)
-    taperCount = 3;
-  if (taperCount > 12)
-    taperCount = 12;
-  if (taperCount * 2 >= count)
-    taperCount = count / 2;
-  if (taperCount < 1)
-    return;
-
-  float minWidth = fmaxf(0.45f, baseWidth * 0.15f);
-  for (int i = 0; i < taperCount; i++) {
-    float t = (float)(i + 1) / (float)(taperCount + 1);
-    float factor = SmoothStep01(t);
-    points[i].width = minWidth + (points[i].width - minWidth) * factor;
-  }
-  for (int i = 0; i < taperCount; i++) {
-    int idx = count - 1 - i;
-    float t = (float)(i + 1) / (float)(taperCount + 1);
-    float factor = SmoothStep01(t);
-    points[idx].width = minWidth + (points[idx].width - minWidth) * factor;
-  }
-}
-
-static int BuildStrokeCache(Stroke *s, float baseWidth) {
-  if (s->pointCount < 2) {
-    s->cachedCount = 0;
-    return 0;
-  }
-
-  const int samplesPerSegment = 7;
-  int segments = s->pointCount - 1;
-  int outCount = segments * samplesPerSegment + 1;
-
-  if (!EnsureStrokeCache(s, outCount)) {
-    s->cachedCount = 0;
-    return 0;
-  }
-  Point *resampled = s->cachedPoints;
-
-  float minWidth = fmaxf(0.4f, baseWidth * 0.18f);
-  float maxWidth = fmaxf(minWidth + 0.5f, baseWidth * 2.2f);
-
-  int index = 0;
-  for (int i = 0; i < segments; i++) {
-    int i0 = (i == 0) ? 0 : i - 1;
-    int i1 = i;
-    int i2 = i + 1;
-    int i3 = (i + 2 < s->pointCount) ? i + 2 : s->pointCount - 1;
-
-    Point p0 = s->points[i0];
-    Point p1 = s->points[i1];
-    Point p2 = s->points[i2];
-    Point p3 = s->points[i3];
-
-    float w0 = PointWidth(&p0, baseWidth);
-    float w1 = PointWidth(&p1, baseWidth);
-    float w2 = PointWidth(&p2, baseWidth);
-    float w3 = PointWidth(&p3, baseWidth);
-
-    for (int j = 0; j < samplesPerSegment; j++) {
-      float t = (float)j / (float)samplesPerSegment;
-      resampled[index].x = CatmullRom(p0.x, p1.x, p2.x, p3.x, t);
-      resampled[index].y = CatmullRom(p0.y, p1.y, p2.y, p3.y, t);
-      resampled[index].width =
-          ClampFloat(CatmullRom(w0, w1, w2, w3, t), minWidth, maxWidth);
-      index++;
-    }
-  }
-
-  Point last = s->points[s->pointCount - 1];
-  resampled[index] =
-      (Point){last.x, last.y, ClampFloat(PointWidth(&last, baseWidth), minWidth, maxWidth)};
-  index++;
-
-  SmoothPointWidths(resampled, index, 3);
-  ApplyStrokeTaper(resampled, index, baseWidth);
-
-  s->cachedCount = index;
-  return index;
-}
-
-static uint32_t HashU32(uint32_t x) {
-  x ^= x >> 16;
-  x *= 0x7feb352dU;
-  x ^= x >> 15;
-  x *= 0x846ca68bU;
-  x ^= x >> 16;
-  return x;
-}
-
-static uint32_t FloatBits(float f) {
-  union {
-    float f;
-    uint32_t u;
-  } v;
-  v.f = f;
-  return v.u;
-}
-
-static float HashToSignedFloat(uint32_t x) {
-  // Convert to [-1, 1] using 24 bits of precision to keep it stable on all
-  // platforms/compilers.
-  float v = (float)(x & 0x00FFFFFFu) / (float)0x00FFFFFFu; // [0, 1]
-  return v * 2.0f - 1.0f;
-}
-
-static float SmoothStep(float t) { return t * t * (3.0f - 2.0f * t); }
-
-static float ValueNoise1D(uint32_t seed, float x) {
-  float fx = floorf(x);
-  int xi = (int)fx;
-  float t = x - fx;
-  float a = HashToSignedFloat(HashU32(seed ^ (uint32_t)xi));
-  float b = HashToSignedFloat(HashU32(seed ^ (uint32_t)(xi + 1)));
-  return a + (b - a) * SmoothStep(t);
-}
-
-static uint32_t StrokeSeed(const Stroke *s) {
-  uint32_t seed = 0xC0FFEE11u;
-  seed ^= (uint32_t)s->color.r | ((uint32_t)s->color.g << 8) |
-          ((uint32_t)s->color.b << 16) | ((uint32_t)s->color.a << 24);
-  if (s->pointCount > 0) {
-    seed ^= HashU32(FloatBits(s->points[0].x));
-    seed ^= HashU32(FloatBits(s->points[0].y));
-  }
-  if (seed == 0)
-    seed = 1u;
-  return seed;
-}
-
-static bool StrokeLooksLikeArrow(const Stroke *s) {
-  if (s->pointCount != 5)
-    return false;
-
-  // Current arrow representation from TOOL_LINE:
-  // [start, tip, left, right, tip]
-  Point tip = s->points[1];
-  Point last = s->points[4];
-  float dx = tip.x - last.x;
-  float dy = tip.y - last.y;
-  return (dx * dx + dy * dy) <= 0.0001f;
-}
-
 static void DrawStrokePolylineRound(const Point *points, int pointCount, bool closed,
                                     float thickness, Color color) {
   if (pointCount < 2)
@@ -255,44 +48,6 @@ static void DrawStrokePolylineRound(const Point *points, int pointCount, bool cl
   }
 }
 
-static Vector2 JitterPoint(const Point *points, int pointCount, bool closed, int i,
-                           float dist, float amplitude, float wavelength,
-                           uint32_t seed) {
-  int prevIndex = i - 1;
-  int nextIndex = i + 1;
-  if (closed) {
-    if (prevIndex < 0)
-      prevIndex = pointCount - 1;
-    if (nextIndex >= pointCount)
-      nextIndex = 0;
-  } else {
-    if (prevIndex < 0)
-      prevIndex = 0;
-    if (nextIndex >= pointCount)
-      nextIndex = pointCount - 1;
-  }
-
-  Vector2 pPrev = PointAsVector2(points[prevIndex]);
-  Vector2 pNext = PointAsVector2(points[nextIndex]);
-  Vector2 dir = Vector2Subtract(pNext, pPrev);
-  float len = Vector2Length(dir);
-  if (len <= 0.0001f)
-    dir = (Vector2){1.0f, 0.0f};
-  else
-    dir = Vector2Scale(dir, 1.0f / len);
-
-  Vector2 perp = (Vector2){-dir.y, dir.x};
-
-  float x = (wavelength <= 0.0001f) ? dist : (dist / wavelength);
-  float n = ValueNoise1D(seed, x);
-  float m = ValueNoise1D(seed ^ 0xA511E9B3u, x + 17.0f);
-
-  Vector2 p = PointAsVector2(points[i]);
-  p = Vector2Add(p, Vector2Scale(perp, n * amplitude));
-  p = Vector2Add(p, Vector2Scale(dir, m * amplitude * 0.20f));
-  return p;
-}
-
 static void DrawStrokeSketchyPass(const Point *points, int pointCount, bool closed,
                                   float thickness, Color color, uint32_t seed,
                                   float amplitude, float wavelength) {
@@ -328,15 +83,10 @@ static void DrawStrokeVariableWidth(Stroke *s, float baseWidth, Color color) {
   if (s->pointCount < 2)
     return;
 
-  if (s->cacheDirty || s->cacheVersion != s->lastBuiltVersion || s->cachedCount < 2) {
-    int built = BuildStrokeCache(s, baseWidth);
-    if (built < 2)
-      return;
-    s->cacheDirty = false;
-    s->lastBuiltVersion = s->cacheVersion;
-  }
+  int count = StrokeSmoothedPoints(s, baseWidth);
+  if (count < 2)
+    return;
   Point *resampled = s->cachedPoints;
-  int count = s->cachedCount;
 
   for (int i = 0; i < count - 1; i++) {
     Vector2 a = PointAsVector2(resampled[i]);
@@ -370,33 +120,18 @@ static void DrawStrokeVariableWidth(Stroke *s, float baseWidth, Color color) {
 
 static void DrawArrowStroke(const Stroke *s, float thickness, Color color) {
   Vector2 start = PointAsVector2(s->points[0]);
-  Vector2 tip = PointAsVector2(s->points[1]);
-
-  Vector2 st = Vector2Subtract(tip, start);
-  float len = Vector2Length(st);
-  if (len <= 0.0001f) {
-    DrawLineEx(start, tip, thickness, color);
+  Vector2 shaftEnd;
+  Vector2 head[3];
+  if (!StrokeArrowHead(s, thickness, &shaftEnd, head)) {
+    DrawLineEx(start, PointAsVector2(s->points[1]), thickness, color);
     return;
   }
-
-  Vector2 dir = Vector2Scale(st, 1.0f / len);
-  Vector2 perp = (Vector2){-dir.y, dir.x};
-
-  float headLen = fmaxf(16.0f, thickness * 4.0f);
-  headLen = fminf(headLen, len * 0.5f);
-  float headW = fmaxf(thickness * 3.0f, headLen * 1.10f);
-
-  Vector2 base = Vector2Subtract(tip, Vector2Scale(dir, headLen));
-  Vector2 left = Vector2Add(base, Vector2Scale(perp, headW * 0.5f));
-  Vector2 right = Vector2Subtract(base, Vector2Scale(perp, headW * 0.5f));
-
-  // Draw shaft slightly into the head to avoid a visible seam.
-  Vector2 shaftEnd = Vector2Add(base, Vector2Scale(dir, thickness * 0.25f));
   DrawLineEx(start, shaftEnd, thickness, color);
 
   // raylib expects CCW order for filled triangles.
-  Vector2 l = left;
-  Vector2 r = right;
+  Vector2 tip = head[0];
+  Vector2 l = head[1];
+  Vector2 r = head[2];
   Vector2 tl = Vector2Subtract(l, tip);
   Vector2 tr = Vector2Subtract(r, tip);
   float cross = tl.x * tr.y - tl.y * tr.x;
@@ -411,18 +146,6 @@ static void DrawArrowStroke(const Stroke *s, float thickness, Color color) {
   DrawTriangle(tip, l, r, color);
 }
 
-static bool StrokeIsClosed(const Stroke *s) {
-  if (s->pointCount < 3)
-    return false;
-  Point first = s->points[0];
-  Point last = s->points[s->pointCount - 1];
-  float dx = first.x - last.x;
-  float dy = first.y - last.y;
-
-  // World-space epsilon; tight on purpose (our shape tools close exactly).
-  return (dx * dx + dy * dy) <= 0.0001f;
-}
-
 static void DrawStrokeLinearClosed(const Stroke *s, int loopCount, float thickness,
                                    Color color) {
   if (loopCount < 2)
@@ -461,59 +184,68 @@ static void DrawInfiniteGrid(Camera2D camera, Color gridColor) {
   }
 }
 
-static void DrawStrokeSolid(const Stroke *s, float thickness, Color color) {
-  if (s->pointCount < 2)
+// Rectangles and circles draw through the closed-path code below, using an
+// outline tessellated for the current zoom. Returns `s` for plain paths.
+static const Stroke *StrokeDrawPath(const Stroke *s, float zoom, Stroke *view) {
+  if (s->shape != STROKE_SHAPE_RECT && s->shape != STROKE_SHAPE_CIRCLE)
+    return s;
+  Point *outline = EnsureOutlineScratch(StrokeOutlineCount(s, zoom));
+  if (!outline)
+    return NULL;
+  *view = *s;
+  view->points = outline;
+  view->pointCount = StrokeOutline(s, zoom, outline);
+  view->shape = STROKE_SHAPE_PATH;
+  return view;
+}
+
+static void DrawStrokeSolid(const Stroke *stroke, float zoom, float thickness,
+                            Color color) {
+  if (stroke->pointCount < 2)
     return;
 
-  if (StrokeLooksLikeArrow(s)) {
-    DrawArrowStroke(s, thickness, color);
+  if (stroke->shape == STROKE_SHAPE_ARROW) {
+    DrawArrowStroke(stroke, thickness, color);
     return;
   }
 
-  bool closed = StrokeIsClosed(s);
-  int loopCount = s->pointCount;
-  if (closed && loopCount > 3) {
-    Point first = s->points[0];
-    Point last = s->points[loopCount - 1];
-    float dx = first.x - last.x;
-    float dy = first.y - last.y;
-    if ((dx * dx + dy * dy) <= 0.0001f)
-      loopCount -= 1;
-  }
+  Stroke view;
+  const Stroke *s = StrokeDrawPath(stroke, zoom, &view);
+  if (!s)
+    return;
+
+  bool closed;
+  int loopCount = StrokeLoopCount(s, &closed);
 
   if (closed && loopCount < 4) {
     DrawStrokeLinearClosed(s, loopCount, thickness, color);
     return;
   }
 
-  DrawStrokePolylineRound(s->points, closed ? loopCount : s->pointCount, closed,
-                          thickness, color);
+  DrawStrokePolylineRound(s->points, loopCount, closed, thickness, color);
 }
 
-static void DrawStroke(Stroke *s, float thickness, Color color) {
-  if (s->pointCount < 2)
+static void DrawStroke(Stroke *stroke, float zoom, float thickness, Color color) {
+  if (stroke->pointCount < 2)
     return;
 
-  if (StrokeLooksLikeArrow(s)) {
-    DrawArrowStroke(s, thickness, color);
+  if (stroke->shape == STROKE_SHAPE_ARROW) {
+    DrawArrowStroke(stroke, thickness, color);
     return;
   }
 
-  if (s->usePressure) {
-    DrawStrokeVariableWidth(s, thickness, color);
+  if (stroke->usePressure) {
+    DrawStrokeVariableWidth(stroke, thickness, color);
     return;
   }
 
-  bool closed = StrokeIsClosed(s);
-  int loopCount = s->pointCount;
-  if (closed && loopCount > 3) {
-    Point first = s->points[0];
-    Point last = s->points[loopCount - 1];
-    float dx = first.x - last.x;
-    float dy = first.y - last.y;
-    if ((dx * dx + dy * dy) <= 0.0001f)
-      loopCount -= 1;
-  }
+  Stroke view;
+  const Stroke *s = StrokeDrawPath(stroke, zoom, &view);
+  if (!s)
+    return;
+
+  bool closed;
+  int loopCount = StrokeLoopCount(s, &closed);
 
   if (closed && loopCount < 4) {
     DrawStrokeLinearClosed(s, loopCount, thickness, color);
@@ -524,8 +256,44 @@ static void DrawStroke(Stroke *s, float thickness, Color color) {
   float amp = fmaxf(0.35f, thickness * 0.18f);
   float wavelength = fmaxf(10.0f, thickness * 2.5f);
 
-  DrawStrokeSketchyPass(s->points, closed ? loopCount : s->pointCount, closed,
-                        thickness, color, seed, amp, wavelength);
+  DrawStrokeSketchyPass(s->points, loopCount, closed, thickness, color, seed,
+                        amp, wavelength);
+}
+
+// Draws the stroke being captured with the predicted pen tail appended. The
+// tail sits past pointCount in capacity reserved by the input code, so it is
+// dropped again right after drawing and never reaches the committed stroke.
+// Pen input only appends points or replaces the last one, so a pressure
+// stroke's cache keeps every sample that depends on earlier points only.
+static void DrawLiveStroke(Canvas *canvas) {
+  Stroke *s = &canvas->currentStroke;
+  PenState *pen = &canvas->pen;
+  int realCount = s->pointCount;
+  int tail = pen->predictedCount;
+  bool extend = tail > 0 && s->capacity >= realCount + tail;
+  if (extend) {
+    memcpy(s->points + realCount, pen->predicted, sizeof(Point) * (size_t)tail);
+    s->pointCount += tail;
+    s->cacheDirty = true;
+    s->cacheVersion++;
+  }
+
+  if (s->usePressure) {
+    int keep = 0;
+    if (pen->smoothedPoints > 0 && pen->smoothedWidth == s->thickness)
+      keep = (pen->smoothedPoints < realCount ? pen->smoothedPoints : realCount) - 1;
+    StrokeSmoothedPointsGrowing(s, s->thickness, keep);
+    pen->smoothedPoints = realCount;
+    pen->smoothedWidth = s->thickness;
+  }
+  DrawStroke(s, canvas->camera.zoom, s->thickness, s->color);
+
+  // The cache now includes the tail; a committed stroke rebuilds it.
+  if (extend) {
+    s->pointCount = realCount;
+    s->cacheDirty = true;
+    s->cacheVersion++;
+  }
 }
 
 void DrawCanvas(Canvas *canvas) {
@@ -535,18 +303,18 @@ void DrawCanvas(Canvas *canvas) {
     DrawInfiniteGrid(canvas->camera, canvas->gridColor);
 
   for (int i = 0; i < canvas->strokeCount; i++)
-    DrawStroke(&canvas->strokes[i], canvas->strokes[i].thickness,
-               canvas->strokes[i].color);
+    DrawStroke(&canvas->strokes[i], canvas->camera.zoom,
+               canvas->strokes[i].thickness, canvas->strokes[i].color);
 
   if (canvas->selectedStrokeIndex >= 0 &&
       canvas->selectedStrokeIndex < canvas->strokeCount) {
     Stroke *s = &canvas->strokes[canvas->selectedStrokeIndex];
-    DrawStrokeSolid(s, s->thickness + 2.0f, canvas->selectionColor);
+    DrawStrokeSolid(s, canvas->camera.zoom, s->thickness + 2.0f,
+                    canvas->selectionColor);
   }
 
   if (canvas->isDrawing)
-    DrawStroke(&canvas->currentStroke, canvas->currentStroke.thickness,
-               canvas->currentStroke.color);
+    DrawLiveStroke(canvas);
 
   EndMode2D();
 }
@@ -0,0 +1,215 @@
+#include "canvas_internal.h"
+#include <math.h>
+
+// Largest allowed gap, in screen pixels, between a tessellated circle and
+// the true curve.
+static const float kCircleTolerancePx = 0.25f;
+
+float StrokeCircleRadius(const Stroke *s) {
+  if (!s || s->pointCount < 2)
+    return 0.0f;
+  float dx = s->points[1].x - s->points[0].x;
+  float dy = s->points[1].y - s->points[0].y;
+  return sqrtf(dx * dx + dy * dy);
+}
+
+int StrokeCircleSegments(float screenRadius) {
+  if (screenRadius <= kCircleTolerancePx)
+    return 12;
+  // Chord sagitta r * (1 - cos(pi / n)) stays under the tolerance.
+  float c = 1.0f - kCircleTolerancePx / screenRadius;
+  int n = (int)ceilf(PI / acosf(c));
+  if (n < 12)
+    n = 12;
+  if (n > 2048)
+    n = 2048;
+  return n;
+}
+
+int StrokeOutlineCount(const Stroke *s, float zoom) {
+  if (!s)
+    return 0;
+  switch (s->shape) {
+  case STROKE_SHAPE_ARROW:
+    return s->pointCount >= 2 ? 2 : 0;
+  case STROKE_SHAPE_RECT:
+    return s->pointCount >= 2 ? 5 : 0;
+  case STROKE_SHAPE_CIRCLE:
+    if (s->pointCount < 2)
+      return 0;
+    return StrokeCircleSegments(StrokeCircleRadius(s) * zoom) + 1;
+  default:
+    return s->pointCount;
+  }
+}
+
+int StrokeOutline(const Stroke *s, float zoom, Point *out) {
+  int count = StrokeOutlineCount(s, zoom);
+  if (count <= 0 || !out)
+    return 0;
+
+  switch (s->shape) {
+  case STROKE_SHAPE_ARROW:
+    out[0] = s->points[0];
+    out[1] = s->points[1];
+    return 2;
+  case STROKE_SHAPE_RECT: {
+    Point a = s->points[0];
+    Point b = s->points[1];
+    out[0] = a;
+    out[1] = (Point){b.x, a.y, a.width};
+    out[2] = (Point){b.x, b.y, a.width};
+    out[3] = (Point){a.x, b.y, a.width};
+    out[4] = a;
+    return 5;
+  }
+  case STROKE_SHAPE_CIRCLE: {
+    Point c = s->points[0];
+    float radius = StrokeCircleRadius(s);
+    int segments = count - 1;
+    for (int i = 0; i < segments; i++) {
+      float a = (float)i / (float)segments * PI * 2.0f;
+      out[i] = (Point){c.x + cosf(a) * radius, c.y + sinf(a) * radius, c.width};
+    }
+    // Close the loop exactly (avoid float drift between 0 and 2*PI).
+    out[segments] = out[0];
+    return count;
+  }
+  default:
+    for (int i = 0; i < count; i++)
+      out[i] = s->points[i];
+    return count;
+  }
+}
+
+static bool StrokeBoundsCurrent(const Stroke *s) {
+  return s->boundsVersion == s->cacheVersion + 1u;
+}
+
+// Corners rather than a rectangle, so moving them is exact.
+static void MeasureBounds(const Stroke *s, Vector2 *min, Vector2 *max) {
+  if (s->shape == STROKE_SHAPE_CIRCLE && s->pointCount >= 2) {
+    float r = StrokeCircleRadius(s);
+    *min = (Vector2){s->points[0].x - r, s->points[0].y - r};
+    *max = (Vector2){min->x + r * 2.0f, min->y + r * 2.0f};
+    return;
+  }
+
+  // Paths and rectangles stay within their control points.
+  float minX = s->points[0].x, maxX = s->points[0].x;
+  float minY = s->points[0].y, maxY = s->points[0].y;
+  for (int i = 1; i < s->pointCount; i++) {
+    float x = s->points[i].x;
+    float y = s->points[i].y;
+    if (x < minX)
+      minX = x;
+    if (x > maxX)
+      maxX = x;
+    if (y < minY)
+      minY = y;
+    if (y > maxY)
+      maxY = y;
+  }
+  // An arrow's head wings reach out past the shaft.
+  Vector2 shaftEnd, head[3];
+  if (s->shape == STROKE_SHAPE_ARROW && s->pointCount >= 2 &&
+      StrokeArrowHead(s, s->thickness, &shaftEnd, head)) {
+    for (int i = 0; i < 3; i++) {
+      minX = fminf(minX, head[i].x);
+      maxX = fmaxf(maxX, head[i].x);
+      minY = fminf(minY, head[i].y);
+      maxY = fmaxf(maxY, head[i].y);
+    }
+  }
+  *min = (Vector2){minX, minY};
+  *max = (Vector2){maxX, maxY};
+}
+
+bool StrokeGetBounds(const Stroke *s, Rectangle *out) {
+  if (!s || !out || s->pointCount <= 0)
+    return false;
+  Vector2 min = s->boundsMin, max = s->boundsMax;
+  if (!StrokeBoundsCurrent(s))
+    MeasureBounds(s, &min, &max);
+  *out = (Rectangle){min.x, min.y, max.x - min.x, max.y - min.y};
+  return true;
+}
+
+void CanvasBoundsAdd(Canvas *canvas, Stroke *s) {
+  if (canvas->boundsStale || s->pointCount <= 0)
+    return;
+  if (!StrokeBoundsCurrent(s)) {
+    MeasureBounds(s, &s->boundsMin, &s->boundsMax);
+    s->boundsVersion = s->cacheVersion + 1u;
+  }
+  float radius = fmaxf(1.0f, s->thickness) * 0.5f;
+  Vector2 min = {s->boundsMin.x - radius, s->boundsMin.y - radius};
+  Vector2 max = {s->boundsMax.x + radius, s->boundsMax.y + radius};
+  if (!canvas->hasBounds) {
+    canvas->boundsMin = min;
+    canvas->boundsMax = max;
+    canvas->hasBounds = true;
+    return;
+  }
+  canvas->boundsMin.x = fminf(canvas->boundsMin.x, min.x);
+  canvas->boundsMin.y = fminf(canvas->boundsMin.y, min.y);
+  canvas->boundsMax.x = fmaxf(canvas->boundsMax.x, max.x);
+  canvas->boundsMax.y = fmaxf(canvas->boundsMax.y, max.y);
+}
+
+void CanvasBoundsRemove(Canvas *canvas, const Stroke *s) {
+  if (canvas->boundsStale || s->pointCount <= 0)
+    return;
+  // Without the bounds it was added with, the stroke may be anywhere.
+  if (s->boundsVersion == 0) {
+    canvas->boundsStale = true;
+    return;
+  }
+  float radius = fmaxf(1.0f, s->thickness) * 0.5f;
+  if (s->boundsMin.x - radius <= canvas->boundsMin.x ||
+      s->boundsMin.y - radius <= canvas->boundsMin.y ||
+      s->boundsMax.x + radius >= canvas->boundsMax.x ||
+      s->boundsMax.y + radius >= canvas->boundsMax.y)
+    canvas->boundsStale = true;
+}
+
+void CanvasBoundsReset(Canvas *canvas, bool stale) {
+  canvas->hasBounds = false;
+  canvas->boundsStale = stale;
+}
+
+bool CanvasStrokeBounds(Canvas *canvas, Rectangle *out) {
+  if (!canvas || !out)
+    return false;
+  if (canvas->boundsStale) {
+    CanvasBoundsReset(canvas, false);
+    for (int i = 0; i < canvas->strokeCount; i++)
+      CanvasBoundsAdd(canvas, &canvas->strokes[i]);
+  }
+  if (!canvas->hasBounds)
+    return false;
+  out->x = canvas->boundsMin.x;
+  out->y = canvas->boundsMin.y;
+  out->width = canvas->boundsMax.x - canvas->boundsMin.x;
+  out->height = canvas->boundsMax.y - canvas->boundsMin.y;
+  return true;
+}
+
+bool StrokeUpgradeLegacyArrow(Stroke *s) {
+  if (!s || s->shape != STROKE_SHAPE_PATH || s->usePressure || s->pointCount != 5)
+    return false;
+
+  // Arrows used to be baked as [start, tip, left, right, tip].
+  Point tip = s->points[1];
+  Point last = s->points[4];
+  float dx = tip.x - last.x;
+  float dy = tip.y - last.y;
+  if ((dx * dx + dy * dy) > 0.0001f)
+    return false;
+
+  s->shape = STROKE_SHAPE_ARROW;
+  s->pointCount = 2;
+  s->cacheDirty = true;
+  s->cacheVersion++;
+  return true;
+}
@@ -0,0 +1,103 @@
+#include "canvas_internal.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+static uint8_t *gKeepScratch = NULL;
+static int gKeepScratchCapacity = 0;
+static int *gStackScratch = NULL;
+static int gStackScratchCapacity = 0;
+
+static bool EnsureScratch(int count) {
+  if (gKeepScratchCapacity < count) {
+    uint8_t *next = (uint8_t *)realloc(gKeepScratch, (size_t)count);
+    if (!next)
+      return false;
+    gKeepScratch = next;
+    gKeepScratchCapacity = count;
+  }
+  // Each pending range takes two slots; at most one range per point.
+  if (gStackScratchCapacity < count * 2) {
+    int *next = (int *)realloc(gStackScratch, sizeof(int) * (size_t)count * 2);
+    if (!next)
+      return false;
+    gStackScratch = next;
+    gStackScratchCapacity = count * 2;
+  }
+  return true;
+}
+
+// Outline error of dropping `p` from the chord a-b: centerline distance plus
+// half the width difference, since width moves each edge by half its change.
+static float PointError(Point p, Point a, Point b) {
+  float dx = b.x - a.x;
+  float dy = b.y - a.y;
+  float len2 = dx * dx + dy * dy;
+  float t = 0.0f;
+  float dist;
+  if (len2 <= 0.000001f) {
+    float px = p.x - a.x;
+    float py = p.y - a.y;
+    dist = sqrtf(px * px + py * py);
+  } else {
+    t = ((p.x - a.x) * dx + (p.y - a.y) * dy) / len2;
+    if (t < 0.0f)
+      t = 0.0f;
+    if (t > 1.0f)
+      t = 1.0f;
+    float px = a.x + dx * t - p.x;
+    float py = a.y + dy * t - p.y;
+    dist = sqrtf(px * px + py * py);
+  }
+  float w = a.width + (b.width - a.width) * t;
+  return dist + 0.5f * fabsf(p.width - w);
+}
+
+int SimplifyStrokePoints(Point *points, int count, float tolerance) {
+  if (!points || count < 3 || tolerance <= 0.0f)
+    return count;
+  if (!EnsureScratch(count))
+    return count;
+
+  uint8_t *keep = gKeepScratch;
+  int *stack = gStackScratch;
+  for (int i = 0; i < count; i++)
+    keep[i] = 0;
+  keep[0] = 1;
+  keep[count - 1] = 1;
+
+  int top = 0;
+  stack[top++] = 0;
+  stack[top++] = count - 1;
+  while (top > 0) {
+    int last = stack[--top];
+    int first = stack[--top];
+    if (last - first < 2)
+      continue;
+
+    float worst = -1.0f;
+    int worstIndex = -1;
+    for (int i = first + 1; i < last; i++) {
+      float e = PointError(points[i], points[first], points[last]);
+      if (e > worst) {
+        worst = e;
+        worstIndex = i;
+      }
+    }
+    if (worst <= tolerance)
+      continue;
+
+    keep[worstIndex] = 1;
+    stack[top++] = first;
+    stack[top++] = worstIndex;
+    stack[top++] = worstIndex;
+    stack[top++] = last;
+  }
+
+  int out = 0;
+  for (int i = 0; i < count; i++) {
+    if (keep[i])
+      points[out++] = points[i];
+  }
+  return out;
+}
@@ -0,0 +1,143 @@
+#include "canvas_internal.h"
+#include "raymath.h"
+#include <math.h>
+
+static Vector2 PointAsVector2(Point p) { return (Vector2){p.x, p.y}; }
+
+static uint32_t HashU32(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352dU;
+  x ^= x >> 15;
+  x *= 0x846ca68bU;
+  x ^= x >> 16;
+  return x;
+}
+
+static uint32_t FloatBits(float f) {
+  union {
+    float f;
+    uint32_t u;
+  } v;
+  v.f = f;
+  return v.u;
+}
+
+static float HashToSignedFloat(uint32_t x) {
+  // Convert to [-1, 1] using 24 bits of precision to keep it stable on all
+  // platforms/compilers.
+  float v = (float)(x & 0x00FFFFFFu) / (float)0x00FFFFFFu; // [0, 1]
+  return v * 2.0f - 1.0f;
+}
+
+static float SmoothStep(float t) { return t * t * (3.0f - 2.0f * t); }
+
+static float ValueNoise1D(uint32_t seed, float x) {
+  float fx = floorf(x);
+  int xi = (int)fx;
+  float t = x - fx;
+  float a = HashToSignedFloat(HashU32(seed ^ (uint32_t)xi));
+  float b = HashToSignedFloat(HashU32(seed ^ (uint32_t)(xi + 1)));
+  return a + (b - a) * SmoothStep(t);
+}
+
+uint32_t StrokeSeed(const Stroke *s) {
+  uint32_t seed = 0xC0FFEE11u;
+  seed ^= (uint32_t)s->color.r | ((uint32_t)s->color.g << 8) |
+          ((uint32_t)s->color.b << 16) | ((uint32_t)s->color.a << 24);
+  if (s->pointCount > 0) {
+    seed ^= HashU32(FloatBits(s->points[0].x));
+    seed ^= HashU32(FloatBits(s->points[0].y));
+  }
+  if (seed == 0)
+    seed = 1u;
+  return seed;
+}
+
+Vector2 JitterPoint(const Point *points, int pointCount, bool closed, int i,
+                    float dist, float amplitude, float wavelength, uint32_t seed) {
+  int prevIndex = i - 1;
+  int nextIndex = i + 1;
+  if (closed) {
+    if (prevIndex < 0)
+      prevIndex = pointCount - 1;
+    if (nextIndex >= pointCount)
+      nextIndex = 0;
+  } else {
+    if (prevIndex < 0)
+      prevIndex = 0;
+    if (nextIndex >= pointCount)
+      nextIndex = pointCount - 1;
+  }
+
+  Vector2 pPrev = PointAsVector2(points[prevIndex]);
+  Vector2 pNext = PointAsVector2(points[nextIndex]);
+  Vector2 dir = Vector2Subtract(pNext, pPrev);
+  float len = Vector2Length(dir);
+  if (len <= 0.0001f)
+    dir = (Vector2){1.0f, 0.0f};
+  else
+    dir = Vector2Scale(dir, 1.0f / len);
+
+  Vector2 perp = (Vector2){-dir.y, dir.x};
+
+  float x = (wavelength <= 0.0001f) ? dist : (dist / wavelength);
+  float n = ValueNoise1D(seed, x);
+  float m = ValueNoise1D(seed ^ 0xA511E9B3u, x + 17.0f);
+
+  Vector2 p = PointAsVector2(points[i]);
+  p = Vector2Add(p, Vector2Scale(perp, n * amplitude));
+  p = Vector2Add(p, Vector2Scale(dir, m * amplitude * 0.20f));
+  return p;
+}
+
+static bool StrokeIsClosed(const Stroke *s) {
+  if (s->pointCount < 3)
+    return false;
+  Point first = s->points[0];
+  Point last = s->points[s->pointCount - 1];
+  float dx = first.x - last.x;
+  float dy = first.y - last.y;
+
+  // World-space epsilon; tight on purpose (our shape tools close exactly).
+  return (dx * dx + dy * dy) <= 0.0001f;
+}
+
+int StrokeLoopCount(const Stroke *s, bool *closed) {
+  *closed = StrokeIsClosed(s);
+  int loopCount = s->pointCount;
+  if (*closed && loopCount > 3) {
+    Point first = s->points[0];
+    Point last = s->points[loopCount - 1];
+    float dx = first.x - last.x;
+    float dy = first.y - last.y;
+    if ((dx * dx + dy * dy) <= 0.0001f)
+      loopCount -= 1;
+  }
+  return loopCount;
+}
+
+bool StrokeArrowHead(const Stroke *s, float thickness, Vector2 *shaftEnd,
+                     Vector2 head[3]) {
+  Vector2 start = PointAsVector2(s->points[0]);
+  Vector2 tip = PointAsVector2(s->points[1]);
+
+  Vector2 st = Vector2Subtract(tip, start);
+  float len = Vector2Length(st);
+  if (len <= 0.0001f)
+    return false;
+
+  Vector2 dir = Vector2Scale(st, 1.0f / len);
+  Vector2 perp = (Vector2){-dir.y, dir.x};
+
+  float headLen = fmaxf(16.0f, thickness * 4.0f);
+  headLen = fminf(headLen, len * 0.5f);
+  float headW = fmaxf(thickness * 3.0f, headLen * 1.10f);
+
+  Vector2 base = Vector2Subtract(tip, Vector2Scale(dir, headLen));
+  // Draw shaft slightly into the head to avoid a visible seam.
+  *shaftEnd = Vector2Add(base, Vector2Scale(dir, thickness * 0.25f));
+  head[0] = tip;
+  head[1] = Vector2Add(base, Vector2Scale(perp, headW * 0.5f));
+  head[2] = Vector2Subtract(base, Vector2Scale(perp, headW * 0.5f));
+  return true;
+}
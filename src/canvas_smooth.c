@@ -0,0 +1,274 @@
+#include "canvas.h"
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+
+// Segments of each round end cap of a filled outline.
+#define OUTLINE_CAP_SEGMENTS 8
+// Passes of width smoothing, and so how many samples a changed width reaches.
+#define SMOOTH_WIDTH_PASSES 3
+
+static bool EnsureStrokeCache(Stroke *s, int needed) {
+  if (needed <= 0)
+    return false;
+  if (s->cachedCapacity >= needed)
+    return true;
+  int newCap = (s->cachedCapacity == 0) ? 64 : s->cachedCapacity;
+  while (newCap < needed)
+    newCap *= 2;
+  Point *next =
+      (Point *)realloc(s->cachedPoints, sizeof(Point) * (size_t)newCap);
+  if (!next)
+    return false;
+  s->cachedPoints = next;
+  s->cachedCapacity = newCap;
+  return true;
+}
+
+static float PointWidth(const Point *p, float base) {
+  if (p->width > 0.0f)
+    return p->width;
+  return base;
+}
+
+static float ClampFloat(float v, float min, float max) {
+  if (v < min)
+    return min;
+  if (v > max)
+    return max;
+  return v;
+}
+
+static float SmoothStep01(float t) { return t * t * (3.0f - 2.0f * t); }
+
+static float CatmullRom(float p0, float p1, float p2, float p3, float t) {
+  float t2 = t * t;
+  float t3 = t2 * t;
+  return 0.5f * ((2.0f * p1) + (-p0 + p2) * t +
+                 (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+                 (-p0 + 3.0f * p1 - 3.0f * p2 + p3) * t3);
+}
+
+// In place, carrying the previous unsmoothed width instead of a scratch copy
+// so StrokeSmoothInto needs no shared state.
+static void SmoothPointWidths(Point *points, int count, int passes) {
+  if (count < 3 || passes <= 0)
+    return;
+  for (int pass = 0; pass < passes; pass++) {
+    float prev = points[0].width;
+    for (int i = 1; i < count - 1; i++) {
+      float cur = points[i].width;
+      points[i].width = (prev + cur * 2.0f + points[i + 1].width) * 0.25f;
+      prev = cur;
+    }
+  }
+}
+
+// Samples narrowed at each end of `count` smoothed points.
+static int TaperCount(int count) {
+  if (count < 3)
+    return 0;
+  int taperCount = count / 4;
+  if (taperCount < 3)
+    taperCount = 3;
+  if (taperCount > 12)
+    taperCount = 12;
+  if (taperCount * 2 >= count)
+    taperCount = count / 2;
+  return taperCount;
+}
+
+static void TaperEnd(Point *points, int count, float baseWidth, bool head) {
+  int taperCount = TaperCount(count);
+  float minWidth = fmaxf(0.45f, baseWidth * 0.15f);
+  for (int i = 0; i < taperCount; i++) {
+    int idx = head ? i : count - 1 - i;
+    float t = (float)(i + 1) / (float)(taperCount + 1);
+    float factor = SmoothStep01(t);
+    points[idx].width = minWidth + (points[idx].width - minWidth) * factor;
+  }
+}
+
+static void ApplyStrokeTaper(Point *points, int count, float baseWidth) {
+  TaperEnd(points, count, baseWidth, true);
+  TaperEnd(points, count, baseWidth, false);
+}
+
+// Strokes too long for the resampled count to fit an int keep their points.
+static int SamplesPerSegment(const Stroke *s) {
+  return s->pointCount <= (INT_MAX - 1) / 7 ? 7 : 1;
+}
+
+int StrokeSmoothedCount(const Stroke *s) {
+  if (s->pointCount < 2)
+    return 0;
+  return (s->pointCount - 1) * SamplesPerSegment(s) + 1;
+}
+
+// Catmull-Rom samples, before width smoothing and tapering, of segments
+// `firstSegment` on and the last point; they start at that segment's place in
+// `out`. Returns the total sample count.
+static int StrokeRawSamples(const Stroke *s, float baseWidth, int firstSegment,
+                            Point *out) {
+  const int samplesPerSegment = SamplesPerSegment(s);
+  int segments = s->pointCount - 1;
+
+  float minWidth = fmaxf(0.4f, baseWidth * 0.18f);
+  float maxWidth = fmaxf(minWidth + 0.5f, baseWidth * 2.2f);
+
+  int index = firstSegment * samplesPerSegment;
+  for (int i = firstSegment; i < segments; i++) {
+    int i0 = (i == 0) ? 0 : i - 1;
+    int i1 = i;
+    int i2 = i + 1;
+    int i3 = (i + 2 < s->pointCount) ? i + 2 : s->pointCount - 1;
+
+    Point p0 = s->points[i0];
+    Point p1 = s->points[i1];
+    Point p2 = s->points[i2];
+    Point p3 = s->points[i3];
+
+    float w0 = PointWidth(&p0, baseWidth);
+    float w1 = PointWidth(&p1, baseWidth);
+    float w2 = PointWidth(&p2, baseWidth);
+    float w3 = PointWidth(&p3, baseWidth);
+
+    for (int j = 0; j < samplesPerSegment; j++) {
+      float t = (float)j / (float)samplesPerSegment;
+      out[index].x = CatmullRom(p0.x, p1.x, p2.x, p3.x, t);
+      out[index].y = CatmullRom(p0.y, p1.y, p2.y, p3.y, t);
+      out[index].width =
+          ClampFloat(CatmullRom(w0, w1, w2, w3, t), minWidth, maxWidth);
+      index++;
+    }
+  }
+
+  Point last = s->points[s->pointCount - 1];
+  out[index] =
+      (Point){last.x, last.y, ClampFloat(PointWidth(&last, baseWidth), minWidth, maxWidth)};
+  return index + 1;
+}
+
+int StrokeSmoothInto(const Stroke *s, float baseWidth, Point *out) {
+  if (s->pointCount < 2)
+    return 0;
+  int count = StrokeRawSamples(s, baseWidth, 0, out);
+  SmoothPointWidths(out, count, SMOOTH_WIDTH_PASSES);
+  ApplyStrokeTaper(out, count, baseWidth);
+  return count;
+}
+
+int StrokeSmoothedPoints(Stroke *s, float baseWidth) {
+  if (s->pointCount < 2) {
+    s->cachedCount = 0;
+    return 0;
+  }
+  if (!s->cacheDirty && s->cacheVersion == s->lastBuiltVersion && s->cachedCount >= 2)
+    return s->cachedCount;
+
+  if (!EnsureStrokeCache(s, StrokeSmoothedCount(s))) {
+    s->cachedCount = 0;
+    return 0;
+  }
+  s->cachedCount = StrokeSmoothInto(s, baseWidth, s->cachedPoints);
+  s->cacheDirty = false;
+  s->lastBuiltVersion = s->cacheVersion;
+  return s->cachedCount;
+}
+
+int StrokeSmoothedPointsGrowing(Stroke *s, float baseWidth, int keep) {
+  int count = StrokeSmoothedCount(s);
+  int samplesPerSegment = SamplesPerSegment(s);
+  int prev = s->cachedCount;
+  // Leading samples still right: their raw samples' segments use only points
+  // before `keep`, with room for the smoothing passes, and neither build's
+  // end taper reached them.
+  int start = (keep - 2) * samplesPerSegment - SMOOTH_WIDTH_PASSES;
+  if (start > prev - TaperCount(prev))
+    start = prev - TaperCount(prev);
+  if (start > count - TaperCount(count))
+    start = count - TaperCount(count);
+  // Re-smoothing from a segment boundary at least as many samples back as
+  // there are passes leaves that margin wrong at the window's start; the kept
+  // values are put back there. The head taper must be out of the way too.
+  int window = (start - SMOOTH_WIDTH_PASSES) / samplesPerSegment * samplesPerSegment;
+  float kept[SMOOTH_WIDTH_PASSES + 8];
+  int keptCount = start - window;
+  if (count < 2 || start - SMOOTH_WIDTH_PASSES < 0 || window < TaperCount(count) ||
+      TaperCount(prev) != TaperCount(count) || keptCount > (int)(sizeof(kept) / sizeof(kept[0])) ||
+      !EnsureStrokeCache(s, count)) {
+    s->cacheDirty = true;
+    return StrokeSmoothedPoints(s, baseWidth);
+  }
+
+  for (int i = 0; i < keptCount; i++)
+    kept[i] = s->cachedPoints[window + i].width;
+  StrokeRawSamples(s, baseWidth, window / samplesPerSegment, s->cachedPoints);
+  SmoothPointWidths(s->cachedPoints + window, count - window, SMOOTH_WIDTH_PASSES);
+  for (int i = 0; i < keptCount; i++)
+    s->cachedPoints[window + i].width = kept[i];
+  TaperEnd(s->cachedPoints, count, baseWidth, false);
+  s->cachedCount = count;
+  s->cacheDirty = false;
+  s->lastBuiltVersion = s->cacheVersion;
+  return count;
+}
+
+int StrokeFillOutlineCount(int count) {
+  if (count < 1 || count > INT_MAX / 2 - OUTLINE_CAP_SEGMENTS)
+    return 0;
+  return count * 2 + (OUTLINE_CAP_SEGMENTS - 1) * 2;
+}
+
+// Unit normal at `i` from its neighbours, as the sketchy pass jitters; left
+// unchanged where the neighbours coincide.
+static bool OutlineNormal(const Point *pts, int count, int i, float *nx, float *ny) {
+  const Point *a = &pts[i > 0 ? i - 1 : 0];
+  const Point *b = &pts[i + 1 < count ? i + 1 : count - 1];
+  float dx = b->x - a->x;
+  float dy = b->y - a->y;
+  float len = sqrtf(dx * dx + dy * dy);
+  if (len <= 0.0001f)
+    return false;
+  *nx = -dy / len;
+  *ny = dx / len;
+  return true;
+}
+
+// Half circle around `c` from the side at normal (nx, ny) to the other side,
+// interior points only.
+static void OutlineCap(Point c, float nx, float ny, Point *out) {
+  float r = c.width * 0.5f;
+  for (int k = 1; k < OUTLINE_CAP_SEGMENTS; k++) {
+    float a = (float)M_PI * (float)k / (float)OUTLINE_CAP_SEGMENTS;
+    float ca = cosf(a), sa = sinf(a);
+    // Rotating the normal clockwise by `a` sweeps through the tangent side.
+    float ox = nx * ca + ny * sa;
+    float oy = ny * ca - nx * sa;
+    out[k - 1] = (Point){c.x + ox * r, c.y + oy * r, 0.0f};
+  }
+}
+
+// Left side forward, a cap round the end, the right side back, and a cap
+// round the start.
+int StrokeFillOutline(const Point *pts, int count, Point *out) {
+  if (count < 1)
+    return 0;
+  int right = count + OUTLINE_CAP_SEGMENTS - 1;
+  // Points repeated at the start take the first normal found further on.
+  float nx = 0.0f, ny = -1.0f;
+  for (int i = 0; i < count; i++) {
+    if (OutlineNormal(pts, count, i, &nx, &ny))
+      break;
+  }
+  float firstX = nx, firstY = ny;
+  for (int i = 0; i < count; i++) {
+    OutlineNormal(pts, count, i, &nx, &ny);
+    float r = pts[i].width * 0.5f;
+    out[i] = (Point){pts[i].x + nx * r, pts[i].y + ny * r, 0.0f};
+    out[right + count - 1 - i] = (Point){pts[i].x - nx * r, pts[i].y - ny * r, 0.0f};
+  }
+  OutlineCap(pts[count - 1], nx, ny, out + count);
+  OutlineCap(pts[0], -firstX, -firstY, out + right + count);
+  return StrokeFillOutlineCount(count);
+}
@@ -0,0 +1,177 @@
+#include "canvas_internal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+PointStore *PointStoreMapFile(FILE *f) {
+  if (!f)
+    return NULL;
+  int fd = fileno(f);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0 || st.st_size <= 0)
+    return NULL;
+
+  PointStore *store = (PointStore *)calloc(1, sizeof(PointStore));
+  if (!store)
+    return NULL;
+  store->size = (size_t)st.st_size;
+  store->refs = 1;
+
+  void *base = mmap(NULL, store->size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (base != MAP_FAILED) {
+    store->base = base;
+    store->mapped = true;
+    return store;
+  }
+
+  // Filesystems without mmap support still load, just not zero-copy.
+  store->base = malloc(store->size);
+  if (!store->base || fseek(f, 0, SEEK_SET) != 0 ||
+      fread(store->base, 1, store->size, f) != store->size) {
+    free(store->base);
+    free(store);
+    return NULL;
+  }
+  return store;
+}
+
+PointStore *PointStoreAdopt(void *data, size_t size) {
+  PointStore *store = (PointStore *)calloc(1, sizeof(PointStore));
+  if (!store)
+    return NULL;
+  store->base = (uint8_t *)data;
+  store->size = size;
+  store->refs = 1;
+  return store;
+}
+
+void PointStoreRetain(PointStore *store) {
+  if (store)
+    __atomic_add_fetch(&store->refs, 1, __ATOMIC_RELAXED);
+}
+
+void PointStoreRelease(PointStore *store) {
+  if (!store || __atomic_sub_fetch(&store->refs, 1, __ATOMIC_ACQ_REL) != 0)
+    return;
+  if (store->mapped)
+    munmap(store->base, store->size);
+  else
+    free(store->base);
+  free(store);
+}
+
+void StrokeFreePoints(Stroke *s) {
+  if (!s)
+    return;
+  if (s->store)
+    PointStoreRelease(s->store);
+  else
+    free(s->points);
+  s->store = NULL;
+  s->points = NULL;
+}
+
+bool StrokeMakePointsWritable(Stroke *s) {
+  if (!s || !s->store)
+    return true;
+  // An adopted buffer nobody else borrows any more is simply taken back.
+  if (!s->store->mapped && s->points == (Point *)s->store->base &&
+      __atomic_load_n(&s->store->refs, __ATOMIC_ACQUIRE) == 1) {
+    free(s->store);
+    s->store = NULL;
+    s->capacity = s->pointCount;
+    return true;
+  }
+  Point *copy = NULL;
+  if (s->pointCount > 0) {
+    copy = (Point *)malloc(sizeof(Point) * (size_t)s->pointCount);
+    if (!copy)
+      return false;
+    memcpy(copy, s->points, sizeof(Point) * (size_t)s->pointCount);
+  }
+  PointStoreRelease(s->store);
+  s->store = NULL;
+  s->points = copy;
+  s->capacity = s->pointCount;
+  return true;
+}
+
+bool StrokeShare(Stroke *s, Stroke *copy, bool withCache) {
+  // Owned buffers become shared stores, so the next edit copies them.
+  if (!s->store && s->points && s->pointCount > 0) {
+    PointStore *store = PointStoreAdopt(s->points, sizeof(Point) * (size_t)s->pointCount);
+    if (!store)
+      return false;
+    s->store = store;
+    s->capacity = s->pointCount;
+  }
+  *copy = *s;
+  copy->cachedPoints = NULL;
+  copy->cachedCount = 0;
+  copy->cachedCapacity = 0;
+  // Without memory for the cache, the copy rebuilds its own.
+  bool cacheBuilt = withCache && !s->cacheDirty && s->cacheVersion == s->lastBuiltVersion &&
+                    s->cachedPoints && s->cachedCount >= 2;
+  if (cacheBuilt) {
+    size_t bytes = sizeof(Point) * (size_t)s->cachedCount;
+    copy->cachedPoints = (Point *)malloc(bytes);
+    if (copy->cachedPoints) {
+      memcpy(copy->cachedPoints, s->cachedPoints, bytes);
+      copy->cachedCount = s->cachedCount;
+      copy->cachedCapacity = s->cachedCount;
+    } else {
+      copy->cacheDirty = true;
+    }
+  }
+  if (copy->store)
+    PointStoreRetain(copy->store);
+  else
+    copy->points = NULL;
+  return true;
+}
+
+Canvas *CanvasSnapshotCreate(Canvas *canvas, bool withCaches) {
+  if (!canvas || canvas->lazy)
+    return NULL;
+  Canvas *snapshot = (Canvas *)calloc(1, sizeof(Canvas));
+  if (!snapshot)
+    return NULL;
+  snapshot->camera = canvas->camera;
+  snapshot->showGrid = canvas->showGrid;
+  snapshot->compressSaves = canvas->compressSaves;
+  snapshot->backgroundColor = canvas->backgroundColor;
+  snapshot->gridColor = canvas->gridColor;
+  snapshot->selectionColor = canvas->selectionColor;
+  snapshot->selectedStrokeIndex = -1;
+  snapshot->boundsMin = canvas->boundsMin;
+  snapshot->boundsMax = canvas->boundsMax;
+  snapshot->hasBounds = canvas->hasBounds;
+  snapshot->boundsStale = canvas->boundsStale;
+  if (canvas->strokeCount > 0) {
+    snapshot->strokes = (Stroke *)malloc(sizeof(Stroke) * (size_t)canvas->strokeCount);
+    if (!snapshot->strokes) {
+      free(snapshot);
+      return NULL;
+    }
+    snapshot->capacity = canvas->strokeCount;
+  }
+
+  for (int i = 0; i < canvas->strokeCount; i++) {
+    Stroke copy;
+    if (!StrokeShare(&canvas->strokes[i], &copy, withCaches)) {
+      CanvasSnapshotFree(snapshot);
+      return NULL;
+    }
+    snapshot->strokes[snapshot->strokeCount++] = copy;
+    snapshot->totalPoints += copy.pointCount;
+  }
+  return snapshot;
+}
+
+void CanvasSnapshotFree(Canvas *snapshot) {
+  if (!snapshot)
+    return;
+  FreeCanvas(snapshot);
+  free(snapshot);
+}
@@ -0,0 +1,198 @@
+#include "canvas_verify.h"
+#include "canvas_chunked.h"
+#include "canvas_format.h"
+#include "canvas_journal.h"
+#include "crc32c.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+bool VerifyChecked(const uint8_t *base, uint64_t size, bool withPoints, uint64_t *end,
+                   char *error, size_t errorSize) {
+  if (size < CHECKED_PREAMBLE_SIZE ||
+      Crc32c(0, base, CHECKED_PREAMBLE_CRC_AT) != GetU32(base + CHECKED_PREAMBLE_CRC_AT)) {
+    snprintf(error, errorSize, "header checksum mismatch");
+    return false;
+  }
+  uint32_t strokeCount = GetU32(base + 4 + 8);
+  uint64_t tableOffset = GetU64(base + MAPPED_TABLE_OFFSET_AT);
+  if (tableOffset < CHECKED_PREAMBLE_SIZE || tableOffset > size ||
+      (size - tableOffset) / MAPPED_ENTRY_SIZE < strokeCount) {
+    snprintf(error, errorSize, "stroke table out of bounds");
+    return false;
+  }
+  uint64_t tableSize = (uint64_t)strokeCount * MAPPED_ENTRY_SIZE;
+  if (Crc32c(0, base + tableOffset, (size_t)tableSize) != GetU32(base + CHECKED_TABLE_CRC_AT)) {
+    snprintf(error, errorSize, "stroke table checksum mismatch");
+    return false;
+  }
+
+  *end = tableOffset + tableSize;
+  for (uint32_t i = 0; i < strokeCount; i++) {
+    const uint8_t *entry = base + tableOffset + (uint64_t)i * MAPPED_ENTRY_SIZE;
+    uint32_t pointCount = GetU32(entry + 12);
+    uint64_t blockOffset = GetU64(entry + BINARY_STROKE_SIZE);
+    uint64_t bytes = (uint64_t)pointCount * sizeof(Point);
+    if (blockOffset > size || size - blockOffset < MAPPED_BLOCK_PREFIX ||
+        size - blockOffset - MAPPED_BLOCK_PREFIX < bytes) {
+      snprintf(error, errorSize, "stroke %u: points out of bounds", i);
+      return false;
+    }
+    const uint8_t *block = base + blockOffset;
+    if (withPoints &&
+        Crc32c(0, block + MAPPED_BLOCK_PREFIX, (size_t)bytes) != GetU32(block + 4)) {
+      snprintf(error, errorSize, "stroke %u: point checksum mismatch", i);
+      return false;
+    }
+    if (blockOffset + MAPPED_BLOCK_PREFIX + bytes > *end)
+      *end = blockOffset + MAPPED_BLOCK_PREFIX + bytes;
+  }
+  *end = AlignUp(*end);
+  return true;
+}
+
+// Journal frames from `offset` on must be intact and run to the end of the
+// file. Loads stop quietly at a damaged one; this says where.
+static bool VerifyJournal(FILE *f, uint64_t offset, uint64_t fileSize, char *error,
+                          size_t errorSize) {
+  uint8_t *payload = NULL;
+  size_t payloadCapacity = 0;
+  uint32_t size = 0;
+  bool ok = true;
+  while (offset < fileSize) {
+    if (!JournalReadFrame(f, &offset, fileSize, &payload, &payloadCapacity, &size)) {
+      snprintf(error, errorSize, "damaged journal frame at byte %llu",
+               (unsigned long long)offset);
+      ok = false;
+      break;
+    }
+  }
+  free(payload);
+  return ok;
+}
+
+// Checks the index and every chunk of a v4 file written with checksums.
+static bool VerifyChunked(FILE *f, const uint8_t *header, uint64_t fileSize, uint64_t *end,
+                          char *error, size_t errorSize) {
+  uint8_t offsetBytes[8];
+  uint8_t prefix[CHUNKED_INDEX_PREFIX];
+  if (fread(offsetBytes, 1, sizeof(offsetBytes), f) != sizeof(offsetBytes)) {
+    snprintf(error, errorSize, "truncated header");
+    return false;
+  }
+  // Offsets may pass what fseek takes, so reads go through pread like the
+  // chunked loader's.
+  int fd = fileno(f);
+  uint64_t indexOffset = GetU64(offsetBytes);
+  if (indexOffset < MAPPED_PREAMBLE_SIZE || indexOffset > fileSize ||
+      !ReadAt(fd, prefix, sizeof(prefix), indexOffset)) {
+    snprintf(error, errorSize, "chunk index out of bounds");
+    return false;
+  }
+  uint32_t chunkCount = GetU32(prefix);
+  uint64_t indexSize = (uint64_t)chunkCount * CHUNKED_ENTRY_SIZE;
+  if (indexSize > fileSize - indexOffset - CHUNKED_INDEX_PREFIX ||
+      indexSize > SIZE_MAX) {
+    snprintf(error, errorSize, "chunk index out of bounds");
+    return false;
+  }
+
+  uint8_t *index = (uint8_t *)malloc(indexSize > 0 ? (size_t)indexSize : 1);
+  uint8_t *buffer = NULL;
+  size_t bufferCapacity = 0;
+  bool ok = false;
+  if (!index || !ReadAt(fd, index, indexSize, indexOffset + sizeof(prefix))) {
+    snprintf(error, errorSize, "cannot read the chunk index");
+    goto done;
+  }
+  uint32_t crc = Crc32c(0, kBinaryMagic, sizeof(kBinaryMagic));
+  crc = Crc32c(crc, header, BINARY_HEADER_SIZE);
+  crc = Crc32c(crc, offsetBytes, sizeof(offsetBytes));
+  if (Crc32c(crc, index, (size_t)indexSize) != GetU32(prefix + 4)) {
+    snprintf(error, errorSize, "chunk index checksum mismatch");
+    goto done;
+  }
+
+  for (uint32_t c = 0; c < chunkCount; c++) {
+    ChunkInfo chunk;
+    UnpackChunkEntry(index + (uint64_t)c * CHUNKED_ENTRY_SIZE, &chunk);
+    if (chunk.offset < MAPPED_PREAMBLE_SIZE || chunk.offset > indexOffset ||
+        chunk.size > indexOffset - chunk.offset || chunk.size > SIZE_MAX) {
+      snprintf(error, errorSize, "chunk %u out of bounds", c);
+      goto done;
+    }
+    if (chunk.size > bufferCapacity) {
+      uint8_t *next = (uint8_t *)realloc(buffer, (size_t)chunk.size);
+      if (!next) {
+        snprintf(error, errorSize, "out of memory");
+        goto done;
+      }
+      buffer = next;
+      bufferCapacity = (size_t)chunk.size;
+    }
+    if (!ReadAt(fd, buffer, chunk.size, chunk.offset) ||
+        Crc32c(0, buffer, (size_t)chunk.size) != chunk.crc) {
+      snprintf(error, errorSize, "chunk %u (strokes from %u): checksum mismatch", c,
+               chunk.firstStroke);
+      goto done;
+    }
+  }
+  *end = indexOffset + CHUNKED_INDEX_PREFIX + indexSize;
+  ok = true;
+
+done:
+  free(index);
+  free(buffer);
+  return ok;
+}
+
+bool CanvasVerifyFile(const char *path, bool *checksummed, char *error, size_t errorSize) {
+  *checksummed = false;
+  error[0] = '\0';
+  FILE *f = fopen(path, "rb");
+  struct stat st;
+  if (!f || fstat(fileno(f), &st) != 0) {
+    snprintf(error, errorSize, "cannot open");
+    if (f)
+      fclose(f);
+    return false;
+  }
+  setvbuf(f, NULL, _IOFBF, BINARY_STDIO_BUFFER);
+  uint64_t fileSize = (uint64_t)st.st_size;
+
+  uint8_t magic[4] = {0};
+  uint8_t header[BINARY_HEADER_SIZE];
+  bool binary = fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+                memcmp(magic, kBinaryMagic, sizeof(kBinaryMagic)) == 0 &&
+                fread(header, 1, sizeof(header), f) == sizeof(header);
+  uint32_t version = binary ? GetU32(header + 0) : 0;
+  uint64_t end = 0;
+  bool ok;
+  if (binary && version == kBinaryVersionChecked) {
+    *checksummed = true;
+    PointStore *store = PointStoreMapFile(f);
+    if (!store)
+      snprintf(error, errorSize, "cannot read");
+    ok = store && VerifyChecked(store->base, store->size, true, &end, error, errorSize);
+    PointStoreRelease(store);
+  } else if (binary && version == kBinaryVersionChunked &&
+             (GetU32(header + 4) & kBinaryFlagChunkChecksums)) {
+    *checksummed = true;
+    ok = VerifyChunked(f, header, fileSize, &end, error, errorSize);
+  } else {
+    // Nothing to check against, so see whether it loads.
+    fclose(f);
+    Canvas canvas;
+    InitCanvas(&canvas, 0, 0);
+    ok = LoadCanvasFromFile(&canvas, path) && CanvasEnsureLoaded(&canvas);
+    FreeCanvas(&canvas);
+    if (!ok)
+      snprintf(error, errorSize, "does not load");
+    return ok;
+  }
+
+  if (ok)
+    ok = VerifyJournal(f, end, fileSize, error, errorSize);
+  fclose(f);
+  return ok;
+}
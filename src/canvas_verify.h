@@ -0,0 +1,15 @@
+#ifndef CANVAS_VERIFY_H
+#define CANVAS_VERIFY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Checks the header and stroke table checksums of a mapped v5 file, and that
+// each section lies within it; `withPoints` checks every point block too,
+// which reads the whole file. `end` is where the base file stops and any
+// journal begins.
+bool VerifyChecked(const uint8_t *base, uint64_t size, bool withPoints, uint64_t *end,
+                   char *error, size_t errorSize);
+
+#endif // CANVAS_VERIFY_H
@@ -0,0 +1,84 @@
+#include "crc32c.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define CRC32C_POLY 0x82F63B78u // reflected
+
+// Slicing-by-8: kTable[k][b] is the CRC of byte b followed by k zero bytes,
+// so eight bytes fold in with eight lookups and no dependency between them.
+static uint32_t kTable[8][256];
+static pthread_once_t gTableOnce = PTHREAD_ONCE_INIT;
+
+static void BuildTables(void) {
+  for (uint32_t b = 0; b < 256; b++) {
+    uint32_t crc = b;
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc >> 1) ^ (CRC32C_POLY & (0u - (crc & 1u)));
+    kTable[0][b] = crc;
+  }
+  for (uint32_t b = 0; b < 256; b++) {
+    for (int k = 1; k < 8; k++)
+      kTable[k][b] = (kTable[k - 1][b] >> 8) ^ kTable[0][kTable[k - 1][b] & 0xFF];
+  }
+}
+
+static uint32_t Crc32cSlicing(uint32_t crc, const uint8_t *p, size_t size) {
+  pthread_once(&gTableOnce, BuildTables);
+  for (; size > 0 && ((uintptr_t)p & 7) != 0; size--)
+    crc = (crc >> 8) ^ kTable[0][(crc ^ *p++) & 0xFF];
+  for (; size >= 8; size -= 8, p += 8) {
+    uint32_t lo, hi;
+    memcpy(&lo, p, sizeof(lo));
+    memcpy(&hi, p + 4, sizeof(hi));
+    lo ^= crc; // little-endian, like everything else in the file formats
+    crc = kTable[7][lo & 0xFF] ^ kTable[6][(lo >> 8) & 0xFF] ^
+          kTable[5][(lo >> 16) & 0xFF] ^ kTable[4][lo >> 24] ^
+          kTable[3][hi & 0xFF] ^ kTable[2][(hi >> 8) & 0xFF] ^
+          kTable[1][(hi >> 16) & 0xFF] ^ kTable[0][hi >> 24];
+  }
+  for (; size > 0; size--)
+    crc = (crc >> 8) ^ kTable[0][(crc ^ *p++) & 0xFF];
+  return crc;
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+// The SSE4.2 crc32 instruction computes exactly this polynomial.
+__attribute__((target("sse4.2"))) static uint32_t Crc32cHardware(uint32_t crc,
+                                                                 const uint8_t *p,
+                                                                 size_t size) {
+  for (; size > 0 && ((uintptr_t)p & 7) != 0; size--)
+    crc = __builtin_ia32_crc32qi(crc, *p++);
+  uint64_t c = crc;
+  for (; size >= 8; size -= 8, p += 8) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    c = __builtin_ia32_crc32di(c, v);
+  }
+  crc = (uint32_t)c;
+  for (; size > 0; size--)
+    crc = __builtin_ia32_crc32qi(crc, *p++);
+  return crc;
+}
+
+static bool HaveHardwareCrc(void) {
+  static int have = -1;
+  int known = __atomic_load_n(&have, __ATOMIC_RELAXED);
+  if (known < 0) {
+    __builtin_cpu_init();
+    known = __builtin_cpu_supports("sse4.2") ? 1 : 0;
+    __atomic_store_n(&have, known, __ATOMIC_RELAXED);
+  }
+  return known != 0;
+}
+#endif
+
+uint32_t Crc32c(uint32_t crc, const void *data, size_t size) {
+  const uint8_t *p = (const uint8_t *)data;
+  crc = ~crc;
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  if (HaveHardwareCrc())
+    return ~Crc32cHardware(crc, p, size);
+#endif
+  return ~Crc32cSlicing(crc, p, size);
+}
@@ -0,0 +1,11 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-32C (Castagnoli), as used by iSCSI and ext4. Start with 0 and pass the
+// result back in to checksum data that arrives in pieces.
+uint32_t Crc32c(uint32_t crc, const void *data, size_t size);
+
+#endif // CRC32C_H
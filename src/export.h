@@ -0,0 +1,34 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include "canvas.h"
+#include <stdbool.h>
+
+// Exporters that need no window: each draws the world rectangle `view` into
+// an output of `width` x `height` units. Grid lines, when the canvas shows
+// them, are spaced the way they are on screen at `gridZoom`.
+typedef struct {
+  Rectangle view;
+  float width;
+  float height;
+  float gridZoom;
+} ExportView;
+
+// Builds the render cache of pressure strokes that do not have one yet.
+bool ExportSvgFile(Canvas *canvas, const ExportView *view, const char *path);
+
+// PDF of what ExportSvgFile draws, written as it is generated. The drawing is
+// one content stream, deflated when `compress` is set, that each page shows
+// through its own window, so memory stays flat however big the drawing. An
+// output unit is 1/96 inch. Pages of `pageWidth` x `pageHeight` points tile
+// the drawing from its top left; with either at 0 it gets one page its size.
+typedef struct {
+  float pageWidth;
+  float pageHeight;
+  bool compress;
+} ExportPdfOptions;
+
+bool ExportPdfFile(Canvas *canvas, const ExportView *view,
+                   const ExportPdfOptions *options, const char *path);
+
+#endif // EXPORT_H
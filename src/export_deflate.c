@@ -0,0 +1,254 @@
+#include "export_deflate.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFLATE_OUT_SIZE (1 << 16)
+#define DEFLATE_WINDOW 32768
+// Input encoded per block; each block restates the fixed-code header.
+#define DEFLATE_BLOCK (1 << 16)
+#define DEFLATE_MIN_MATCH 3
+#define DEFLATE_MAX_MATCH 258
+#define DEFLATE_HASH_BITS 15
+#define ADLER_MOD 65521u
+// Most bytes summed before the Adler-32 sums can overflow 32 bits.
+#define ADLER_NMAX 5552
+
+struct DeflateStream {
+  DeflateSink sink;
+  void *ctx;
+  // The window holds up to DEFLATE_WINDOW bytes already encoded, then the
+  // bytes still to encode. Positions are offsets in the stream.
+  uint8_t *window;
+  size_t windowLen;
+  size_t windowPos;
+  uint64_t windowBase;
+  uint64_t *head; // per hash, 1 + the last position with it (0 for none)
+  uint64_t bits;
+  int bitCount;
+  uint32_t adlerA;
+  uint32_t adlerB;
+  uint8_t *out;
+  size_t outLen;
+};
+
+// Fixed Huffman codes, bit-reversed to go straight into the LSB-first stream.
+static uint16_t kLitCode[288];
+static uint8_t kLitBits[288];
+static uint8_t kDistCode[30];
+static pthread_once_t gTablesOnce = PTHREAD_ONCE_INIT;
+
+static uint32_t ReverseBits(uint32_t code, int bits) {
+  uint32_t r = 0;
+  for (int i = 0; i < bits; i++)
+    r |= ((code >> i) & 1u) << (bits - 1 - i);
+  return r;
+}
+
+static void BuildTables(void) {
+  for (int sym = 0; sym < 288; sym++) {
+    uint32_t code;
+    int bits;
+    if (sym < 144) {
+      code = 0x30u + (uint32_t)sym;
+      bits = 8;
+    } else if (sym < 256) {
+      code = 0x190u + (uint32_t)(sym - 144);
+      bits = 9;
+    } else if (sym < 280) {
+      code = (uint32_t)(sym - 256);
+      bits = 7;
+    } else {
+      code = 0xC0u + (uint32_t)(sym - 280);
+      bits = 8;
+    }
+    kLitCode[sym] = (uint16_t)ReverseBits(code, bits);
+    kLitBits[sym] = (uint8_t)bits;
+  }
+  for (int d = 0; d < 30; d++)
+    kDistCode[d] = (uint8_t)ReverseBits((uint32_t)d, 5);
+}
+
+static void FlushOut(DeflateStream *z) {
+  if (z->outLen == 0)
+    return;
+  z->sink(z->ctx, z->out, z->outLen);
+  z->outLen = 0;
+}
+
+static void PutByte(DeflateStream *z, uint8_t b) {
+  z->out[z->outLen++] = b;
+  if (z->outLen == DEFLATE_OUT_SIZE)
+    FlushOut(z);
+}
+
+static void PutBits(DeflateStream *z, uint32_t value, int count) {
+  z->bits |= (uint64_t)value << z->bitCount;
+  z->bitCount += count;
+  while (z->bitCount >= 8) {
+    PutByte(z, (uint8_t)z->bits);
+    z->bits >>= 8;
+    z->bitCount -= 8;
+  }
+}
+
+static void PutLiteral(DeflateStream *z, int sym) {
+  PutBits(z, kLitCode[sym], kLitBits[sym]);
+}
+
+// Length 3..258 and distance 1..32768, each as code plus extra bits.
+static void PutMatch(DeflateStream *z, int len, int dist) {
+  int l = len - DEFLATE_MIN_MATCH;
+  if (len == DEFLATE_MAX_MATCH) {
+    PutLiteral(z, 285);
+  } else if (l < 8) {
+    PutLiteral(z, 257 + l);
+  } else {
+    int k = 31 - __builtin_clz((unsigned)l);
+    int extra = k - 2;
+    PutLiteral(z, 257 + 4 * (k - 1) + ((l >> extra) & 3));
+    PutBits(z, (uint32_t)l & ((1u << extra) - 1u), extra);
+  }
+
+  int d = dist - 1;
+  if (d < 4) {
+    PutBits(z, kDistCode[d], 5);
+  } else {
+    int k = 31 - __builtin_clz((unsigned)d);
+    int extra = k - 1;
+    PutBits(z, kDistCode[2 * k + ((d >> extra) & 1)], 5);
+    PutBits(z, (uint32_t)d & ((1u << extra) - 1u), extra);
+  }
+}
+
+static uint32_t Hash3(const uint8_t *p) {
+  uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+  return (v * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+}
+
+// One fixed-code block of everything pending, less the last bytes a match
+// could still extend into unless this is the end of the stream. Matches are
+// greedy against the last position with the same hash.
+static void DeflateBlock(DeflateStream *z, bool final) {
+  uint8_t *w = z->window;
+  size_t end = z->windowLen;
+  size_t stop = final ? end : end - DEFLATE_MAX_MATCH;
+  PutBits(z, final ? 3u : 2u, 3);
+
+  size_t p = z->windowPos;
+  while (p < stop) {
+    if (end - p < DEFLATE_MIN_MATCH) {
+      PutLiteral(z, w[p++]);
+      continue;
+    }
+    uint32_t h = Hash3(w + p);
+    uint64_t cand = z->head[h];
+    uint64_t at = z->windowBase + p;
+    z->head[h] = at + 1;
+    size_t len = 0;
+    uint64_t dist = 0;
+    if (cand != 0) {
+      dist = at - (cand - 1);
+      if (dist <= DEFLATE_WINDOW && dist <= p) {
+        const uint8_t *a = w + p - dist;
+        size_t max = end - p < DEFLATE_MAX_MATCH ? end - p : DEFLATE_MAX_MATCH;
+        while (len < max && a[len] == w[p + len])
+          len++;
+      }
+    }
+    if (len < DEFLATE_MIN_MATCH) {
+      PutLiteral(z, w[p++]);
+      continue;
+    }
+    PutMatch(z, (int)len, (int)dist);
+    // Later matches, periodic ones especially, need the positions inside.
+    for (size_t i = 1; i < len && p + i + DEFLATE_MIN_MATCH <= end; i++)
+      z->head[Hash3(w + p + i)] = z->windowBase + p + i + 1;
+    p += len;
+  }
+  PutLiteral(z, 256);
+  z->windowPos = p;
+
+  // Keep one window of history in front of what is left.
+  size_t keep = p > DEFLATE_WINDOW ? p - DEFLATE_WINDOW : 0;
+  memmove(w, w + keep, end - keep);
+  z->windowLen -= keep;
+  z->windowPos -= keep;
+  z->windowBase += keep;
+}
+
+static void UpdateAdler(DeflateStream *z, const uint8_t *p, size_t size) {
+  uint32_t a = z->adlerA, b = z->adlerB;
+  while (size > 0) {
+    size_t n = size < ADLER_NMAX ? size : ADLER_NMAX;
+    size -= n;
+    for (; n > 0; n--) {
+      a += *p++;
+      b += a;
+    }
+    a %= ADLER_MOD;
+    b %= ADLER_MOD;
+  }
+  z->adlerA = a;
+  z->adlerB = b;
+}
+
+DeflateStream *DeflateOpen(DeflateSink sink, void *ctx) {
+  if (!sink)
+    return NULL;
+  pthread_once(&gTablesOnce, BuildTables);
+  DeflateStream *z = (DeflateStream *)calloc(1, sizeof(DeflateStream));
+  if (!z)
+    return NULL;
+  z->sink = sink;
+  z->ctx = ctx;
+  z->window = (uint8_t *)malloc(DEFLATE_WINDOW + DEFLATE_BLOCK + DEFLATE_MAX_MATCH);
+  z->head = (uint64_t *)calloc((size_t)1 << DEFLATE_HASH_BITS, sizeof(uint64_t));
+  z->out = (uint8_t *)malloc(DEFLATE_OUT_SIZE);
+  z->adlerA = 1;
+  if (!z->window || !z->head || !z->out) {
+    free(z->window);
+    free(z->head);
+    free(z->out);
+    free(z);
+    return NULL;
+  }
+  // zlib header: deflate with a 32K window, no dictionary.
+  PutByte(z, 0x78);
+  PutByte(z, 0x01);
+  return z;
+}
+
+void DeflateWrite(DeflateStream *z, const void *data, size_t size) {
+  const uint8_t *p = (const uint8_t *)data;
+  UpdateAdler(z, p, size);
+  const size_t capacity = DEFLATE_WINDOW + DEFLATE_BLOCK + DEFLATE_MAX_MATCH;
+  while (size > 0) {
+    size_t n = capacity - z->windowLen;
+    if (n > size)
+      n = size;
+    memcpy(z->window + z->windowLen, p, n);
+    z->windowLen += n;
+    p += n;
+    size -= n;
+    if (z->windowLen == capacity)
+      DeflateBlock(z, false);
+  }
+}
+
+void DeflateClose(DeflateStream *z) {
+  if (!z)
+    return;
+  DeflateBlock(z, true);
+  if (z->bitCount > 0)
+    PutBits(z, 0, 8 - z->bitCount);
+  uint32_t adler = (z->adlerB << 16) | z->adlerA;
+  for (int shift = 24; shift >= 0; shift -= 8)
+    PutByte(z, (uint8_t)(adler >> shift));
+  FlushOut(z);
+  free(z->window);
+  free(z->head);
+  free(z->out);
+  free(z);
+}
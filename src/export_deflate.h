@@ -0,0 +1,18 @@
+#ifndef EXPORT_DEFLATE_H
+#define EXPORT_DEFLATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// zlib stream encoder for the exporters: deflate with the fixed Huffman
+// codes, fed in pieces of any size. Compressed bytes go to `sink` in pieces
+// of up to 64 KiB as they are produced, so memory stays constant.
+typedef void (*DeflateSink)(void *ctx, const uint8_t *data, size_t size);
+typedef struct DeflateStream DeflateStream;
+
+DeflateStream *DeflateOpen(DeflateSink sink, void *ctx);
+void DeflateWrite(DeflateStream *z, const void *data, size_t size);
+// Ends the stream, hands over what is left and frees the encoder.
+void DeflateClose(DeflateStream *z);
+
+#endif // EXPORT_DEFLATE_H
@@ -0,0 +1,73 @@
+#include "export_geometry.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define EXPORT_GRID_MAX_LINES 2000
+
+// Grows the exporter's point buffer like the canvas arrays grow.
+Point *ExportScratchEnsure(ExportScratch *scratch, int count) {
+  if (count <= 0)
+    return NULL;
+  if (scratch->capacity >= count)
+    return scratch->points;
+  int newCap = (scratch->capacity == 0) ? 64 : scratch->capacity;
+  while (newCap < count)
+    newCap *= 2;
+  Point *next = (Point *)realloc(scratch->points, sizeof(Point) * (size_t)newCap);
+  if (!next)
+    return NULL;
+  scratch->points = next;
+  scratch->capacity = newCap;
+  return next;
+}
+
+static float GridSpacingForZoom(float zoom) {
+  float spacing = 40.0f;
+  if (zoom > 2.0f)
+    spacing *= 0.5f;
+  if (zoom < 0.5f)
+    spacing *= 2.0f;
+  if (zoom < 0.25f)
+    spacing *= 4.0f;
+  return spacing;
+}
+
+ExportGrid ExportGridLines(Rectangle view, float zoom) {
+  ExportGrid g;
+  g.spacing = GridSpacingForZoom(zoom) / 2.0f;
+  do {
+    g.spacing *= 2.0f;
+    g.startCol = (int)floorf(view.x / g.spacing);
+    g.endCol = (int)ceilf((view.x + view.width) / g.spacing);
+    g.startRow = (int)floorf(view.y / g.spacing);
+    g.endRow = (int)ceilf((view.y + view.height) / g.spacing);
+  } while (g.endCol - g.startCol + 1 > EXPORT_GRID_MAX_LINES ||
+           g.endRow - g.startRow + 1 > EXPORT_GRID_MAX_LINES);
+  return g;
+}
+
+int ExportPathPoints(Stroke *s, float thickness, ExportScratch *scratch,
+                     const Point **points, bool *filled) {
+  if (s->usePressure) {
+    int count = StrokeSmoothedPoints(s, s->thickness);
+    int outlineCount = StrokeFillOutlineCount(count);
+    Point *outline = ExportScratchEnsure(scratch, outlineCount);
+    if (count >= 2 && outline) {
+      StrokeFillOutline(s->cachedPoints, count, outline);
+      *points = outline;
+      *filled = true;
+      return outlineCount;
+    }
+  }
+
+  *points = s->points;
+  *filled = false;
+  if (s->pointCount > 12) {
+    Point *smoothed = ExportScratchEnsure(scratch, StrokeSmoothedCount(s));
+    if (smoothed) {
+      *points = smoothed;
+      return StrokeSmoothInto(s, thickness, smoothed);
+    }
+  }
+  return s->pointCount;
+}
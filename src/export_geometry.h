@@ -0,0 +1,34 @@
+#ifndef EXPORT_GEOMETRY_H
+#define EXPORT_GEOMETRY_H
+
+#include "canvas.h"
+#include <stdbool.h>
+
+// What the vector exporters draw, shared so SVG and PDF show the same shapes
+// and only differ in how they write them.
+
+// Point buffer reused from stroke to stroke; free `points` when done.
+typedef struct {
+  Point *points;
+  int capacity;
+} ExportScratch;
+Point *ExportScratchEnsure(ExportScratch *scratch, int count);
+
+// Grid lines covering `view`: columns startCol..endCol and rows
+// startRow..endRow, at multiples of `spacing`. The spacing is the screen's
+// at `zoom`, doubled until neither direction needs more than 2000 lines.
+typedef struct {
+  float spacing;
+  int startCol, endCol;
+  int startRow, endRow;
+} ExportGrid;
+ExportGrid ExportGridLines(Rectangle view, float zoom);
+
+// Points of a freehand stroke (2 or more). Pressure strokes are filled
+// outlines (`*filled`) of the renderer's smoothed, tapered points, which are
+// reused as drawn or cached for the next frame. Other long strokes keep a
+// uniform width along the same curve.
+int ExportPathPoints(Stroke *s, float thickness, ExportScratch *scratch,
+                     const Point **points, bool *filled);
+
+#endif // EXPORT_GEOMETRY_H
@@ -0,0 +1,355 @@
+#include "export.h"
+#include "export_deflate.h"
+#include "export_geometry.h"
+#include "export_writer.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Output units are CSS pixels, 96 to the inch; PDF points are 72.
+#define PDF_POINTS_PER_UNIT 0.75f
+// Largest page side readers accept; bigger single pages scale by UserUnit.
+#define PDF_MAX_PAGE 14400.0f
+#define PDF_MAX_PAGES 10000
+#define PDF_CONTENT_BUFFER 4096
+// Kappa for drawing a quarter circle as one cubic Bezier.
+#define PDF_CIRCLE_KAPPA 0.5522847f
+
+// Object numbers. Each page takes two more from PDF_OBJ_FIRST_PAGE on: the
+// page and its content stream.
+enum {
+  PDF_OBJ_CATALOG = 1,
+  PDF_OBJ_PAGES,
+  PDF_OBJ_DRAWING,
+  PDF_OBJ_DRAWING_LENGTH,
+  PDF_OBJ_DRAWING_RESOURCES,
+  PDF_OBJ_FIRST_PAGE
+};
+
+// The drawing's content stream, in world coordinates. Bytes collect in
+// `buf` and go to the file, through `z` when compressed. Style is set only
+// when it changes; `alphas` records which opacity states the stream uses.
+typedef struct {
+  ExportWriter *w;
+  DeflateStream *z;
+  char buf[PDF_CONTENT_BUFFER];
+  size_t len;
+  bool haveStroke, haveFill;
+  Color stroke, fill;
+  float width;
+  int alpha;
+  uint32_t alphas[8];
+} PdfContent;
+
+static void ContentFlush(PdfContent *c) {
+  if (c->z)
+    DeflateWrite(c->z, c->buf, c->len);
+  else
+    ExportPut(c->w, c->buf, c->len);
+  c->len = 0;
+}
+
+static void ContentPut(PdfContent *c, const char *data, size_t size) {
+  if (c->len + size > sizeof(c->buf))
+    ContentFlush(c);
+  memcpy(c->buf + c->len, data, size);
+  c->len += size;
+}
+
+static void ContentStr(PdfContent *c, const char *s) { ContentPut(c, s, strlen(s)); }
+
+// Coordinates go out on the same hundredths grid as SVG.
+static void ContentNumber(PdfContent *c, float v) {
+  char text[EXPORT_FORMAT_MAX + 1];
+  size_t len = ExportFormatHundredths(text, ExportQuantize(v));
+  text[len++] = ' ';
+  ContentPut(c, text, len);
+}
+
+static void ContentPoint(PdfContent *c, float x, float y, const char *op) {
+  ContentNumber(c, x);
+  ContentNumber(c, y);
+  ContentStr(c, op);
+}
+
+static void WriteDeflated(void *ctx, const uint8_t *data, size_t size) {
+  ExportPut((ExportWriter *)ctx, (const char *)data, size);
+}
+
+static void PutColorOp(PdfContent *c, Color color, const char *op) {
+  char text[48];
+  int n = snprintf(text, sizeof(text), "%.3f %.3f %.3f %s\n", color.r / 255.0f,
+                   color.g / 255.0f, color.b / 255.0f, op);
+  ContentPut(c, text, (size_t)n);
+}
+
+static void UseAlpha(PdfContent *c, unsigned char alpha) {
+  if (c->alpha == alpha)
+    return;
+  char text[16];
+  int n = snprintf(text, sizeof(text), "/A%d gs\n", alpha);
+  ContentPut(c, text, (size_t)n);
+  c->alphas[alpha >> 5] |= 1u << (alpha & 31);
+  c->alpha = alpha;
+}
+
+static void UseStroke(PdfContent *c, Color color, float width) {
+  if (!c->haveStroke || memcmp(&c->stroke, &color, 3) != 0)
+    PutColorOp(c, color, "RG");
+  if (!c->haveStroke || c->width != width) {
+    ContentNumber(c, width);
+    ContentStr(c, "w\n");
+  }
+  UseAlpha(c, color.a);
+  c->haveStroke = true;
+  c->stroke = color;
+  c->width = width;
+}
+
+static void UseFill(PdfContent *c, Color color) {
+  if (!c->haveFill || memcmp(&c->fill, &color, 3) != 0)
+    PutColorOp(c, color, "rg");
+  UseAlpha(c, color.a);
+  c->haveFill = true;
+  c->fill = color;
+}
+
+// A polyline as one subpath, dropping points that round onto the previous
+// one but keeping a segment so round caps still draw a dot.
+static void ContentPolyline(PdfContent *c, const Point *pts, int count) {
+  int64_t lastX = ExportQuantize(pts[0].x), lastY = ExportQuantize(pts[0].y);
+  ContentPoint(c, pts[0].x, pts[0].y, "m\n");
+  bool any = false;
+  for (int i = 1; i < count; i++) {
+    int64_t qx = ExportQuantize(pts[i].x), qy = ExportQuantize(pts[i].y);
+    if (qx == lastX && qy == lastY)
+      continue;
+    ContentPoint(c, pts[i].x, pts[i].y, "l\n");
+    lastX = qx;
+    lastY = qy;
+    any = true;
+  }
+  if (!any)
+    ContentPoint(c, pts[0].x, pts[0].y, "l\n");
+}
+
+static void ContentCircle(PdfContent *c, float cx, float cy, float r) {
+  float k = r * PDF_CIRCLE_KAPPA;
+  ContentPoint(c, cx + r, cy, "m\n");
+  // Four quarter arcs: to the bottom, left, top and back to the right.
+  const float arcs[4][6] = {
+      {cx + r, cy + k, cx + k, cy + r, cx, cy + r},
+      {cx - k, cy + r, cx - r, cy + k, cx - r, cy},
+      {cx - r, cy - k, cx - k, cy - r, cx, cy - r},
+      {cx + k, cy - r, cx + r, cy - k, cx + r, cy},
+  };
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 6; j++)
+      ContentNumber(c, arcs[i][j]);
+    ContentStr(c, "c\n");
+  }
+  ContentStr(c, "h S\n");
+}
+
+static void ContentArrow(PdfContent *c, const Stroke *s) {
+  Vector2 shaftEnd = {s->points[1].x, s->points[1].y};
+  Vector2 head[3];
+  bool hasHead = StrokeArrowHead(s, s->thickness, &shaftEnd, head);
+  UseStroke(c, s->color, s->thickness);
+  ContentPoint(c, s->points[0].x, s->points[0].y, "m ");
+  ContentPoint(c, shaftEnd.x, shaftEnd.y, "l S\n");
+  if (!hasHead)
+    return;
+  UseFill(c, s->color);
+  ContentPoint(c, head[0].x, head[0].y, "m ");
+  ContentPoint(c, head[1].x, head[1].y, "l ");
+  ContentPoint(c, head[2].x, head[2].y, "l h f\n");
+}
+
+static void ContentGrid(PdfContent *c, Rectangle view, Color grid, float zoom) {
+  ExportGrid g = ExportGridLines(view, zoom);
+  UseStroke(c, grid, 1.0f);
+  for (int i = g.startCol; i <= g.endCol; i++) {
+    float x = (float)i * g.spacing;
+    ContentPoint(c, x, view.y, "m ");
+    ContentPoint(c, x, view.y + view.height, "l\n");
+  }
+  for (int i = g.startRow; i <= g.endRow; i++) {
+    float y = (float)i * g.spacing;
+    ContentPoint(c, view.x, y, "m ");
+    ContentPoint(c, view.x + view.width, y, "l\n");
+  }
+  ContentStr(c, "S\n");
+}
+
+static void ContentStrokes(PdfContent *c, Canvas *canvas) {
+  ExportScratch scratch = {0};
+  for (int i = 0; i < canvas->strokeCount; i++) {
+    Stroke *s = &canvas->strokes[i];
+    if (s->pointCount < 2)
+      continue;
+
+    float thickness = (s->thickness > 0.0f) ? s->thickness : 1.0f;
+    if (s->shape == STROKE_SHAPE_ARROW) {
+      ContentArrow(c, s);
+    } else if (s->shape == STROKE_SHAPE_RECT) {
+      Point a = s->points[0], b = s->points[1];
+      UseStroke(c, s->color, thickness);
+      ContentNumber(c, fminf(a.x, b.x));
+      ContentNumber(c, fminf(a.y, b.y));
+      ContentNumber(c, fabsf(b.x - a.x));
+      ContentNumber(c, fabsf(b.y - a.y));
+      ContentStr(c, "re S\n");
+    } else if (s->shape == STROKE_SHAPE_CIRCLE) {
+      UseStroke(c, s->color, thickness);
+      ContentCircle(c, s->points[0].x, s->points[0].y, StrokeCircleRadius(s));
+    } else {
+      const Point *pts;
+      bool filled;
+      int count = ExportPathPoints(s, thickness, &scratch, &pts, &filled);
+      if (filled)
+        UseFill(c, s->color);
+      else
+        UseStroke(c, s->color, thickness);
+      ContentPolyline(c, pts, count);
+      ContentStr(c, filled ? "h f\n" : "S\n");
+    }
+  }
+  free(scratch.points);
+}
+
+static void BeginObject(ExportWriter *w, uint64_t *offsets, int id) {
+  offsets[id] = w->offset;
+  ExportPutf(w, "%d 0 obj\n", id);
+}
+
+// The drawing as a form XObject: its stream, the stream's length (known
+// only afterwards) and the opacity states it used.
+static void WriteDrawing(ExportWriter *w, uint64_t *offsets, Canvas *canvas,
+                         Rectangle r, float gridZoom, bool compress) {
+  BeginObject(w, offsets, PDF_OBJ_DRAWING);
+  ExportPutf(w,
+             "<< /Type /XObject /Subtype /Form /BBox [%.2f %.2f %.2f %.2f]"
+             " /Resources %d 0 R /Length %d 0 R%s >>\nstream\n",
+             r.x, r.y, r.x + r.width, r.y + r.height, PDF_OBJ_DRAWING_RESOURCES,
+             PDF_OBJ_DRAWING_LENGTH, compress ? " /Filter /FlateDecode" : "");
+  uint64_t start = w->offset;
+
+  PdfContent *c = (PdfContent *)calloc(1, sizeof(PdfContent));
+  if (!c || (compress && !(c->z = DeflateOpen(WriteDeflated, w)))) {
+    free(c);
+    w->failed = true;
+    return;
+  }
+  c->w = w;
+  c->alpha = 255;
+  ContentStr(c, "1 J 1 j\n");
+  UseFill(c, canvas->backgroundColor);
+  ContentNumber(c, r.x);
+  ContentNumber(c, r.y);
+  ContentNumber(c, r.width);
+  ContentNumber(c, r.height);
+  ContentStr(c, "re f\n");
+  if (canvas->showGrid)
+    ContentGrid(c, r, canvas->gridColor, gridZoom);
+  ContentStrokes(c, canvas);
+  ContentFlush(c);
+  DeflateClose(c->z);
+  uint64_t length = w->offset - start;
+  ExportPutStr(w, "\nendstream\nendobj\n");
+
+  BeginObject(w, offsets, PDF_OBJ_DRAWING_LENGTH);
+  ExportPutf(w, "%llu\nendobj\n", (unsigned long long)length);
+
+  BeginObject(w, offsets, PDF_OBJ_DRAWING_RESOURCES);
+  ExportPutStr(w, "<< /ExtGState <<");
+  for (int a = 0; a < 256; a++) {
+    if (c->alphas[a >> 5] & (1u << (a & 31)))
+      ExportPutf(w, " /A%d << /CA %.3f /ca %.3f >>", a, a / 255.0f, a / 255.0f);
+  }
+  ExportPutStr(w, " >> >>\nendobj\n");
+  free(c);
+}
+
+bool ExportPdfFile(Canvas *canvas, const ExportView *view,
+                   const ExportPdfOptions *options, const char *path) {
+  if (!canvas || !view || !options || !path)
+    return false;
+  Rectangle r = view->view;
+  if (r.width <= 0.0f)
+    r.width = 1.0f;
+  if (r.height <= 0.0f)
+    r.height = 1.0f;
+
+  // The drawing in points, then in page units: points, unless one page
+  // would be too big, when UserUnit makes each unit several points.
+  float drawW = fmaxf(view->width, 1.0f) * PDF_POINTS_PER_UNIT;
+  float drawH = fmaxf(view->height, 1.0f) * PDF_POINTS_PER_UNIT;
+  bool tiled = options->pageWidth > 0.0f && options->pageHeight > 0.0f;
+  float pageW = tiled ? fminf(options->pageWidth, PDF_MAX_PAGE) : drawW;
+  float pageH = tiled ? fminf(options->pageHeight, PDF_MAX_PAGE) : drawH;
+  float unit = tiled ? 1.0f : ceilf(fmaxf(drawW, drawH) / PDF_MAX_PAGE);
+  if (unit < 1.0f)
+    unit = 1.0f;
+  pageW /= unit;
+  pageH /= unit;
+  int cols = tiled ? (int)ceilf(drawW / unit / pageW) : 1;
+  int rows = tiled ? (int)ceilf(drawH / unit / pageH) : 1;
+  if (cols < 1 || rows < 1 || (int64_t)cols * rows > PDF_MAX_PAGES)
+    return false;
+  int pages = cols * rows;
+  int objectCount = PDF_OBJ_FIRST_PAGE + 2 * pages;
+  uint64_t *offsets = (uint64_t *)calloc((size_t)objectCount, sizeof(uint64_t));
+  if (!offsets)
+    return false;
+
+  ExportWriter w;
+  if (!ExportWriterOpen(&w, path)) {
+    free(offsets);
+    return false;
+  }
+  // The binary comment line tells transfer tools the file is not text.
+  ExportPutf(&w, "%%PDF-%s\n%%\xE2\xE3\xCF\xD3\n", unit > 1.0f ? "1.6" : "1.4");
+  BeginObject(&w, offsets, PDF_OBJ_CATALOG);
+  ExportPutf(&w, "<< /Type /Catalog /Pages %d 0 R >>\nendobj\n", PDF_OBJ_PAGES);
+  WriteDrawing(&w, offsets, canvas, r, view->gridZoom, options->compress);
+
+  // Each page shows the drawing through its own window: world units to
+  // page units with y flipped, shifted to the page's place in the tiling.
+  float scale = drawW / r.width / unit;
+  for (int p = 0; p < pages; p++) {
+    float offsetX = (float)(p % cols) * pageW;
+    float offsetY = (float)(p / cols) * pageH;
+    char content[160];
+    int n = snprintf(content, sizeof(content), "q %.6f 0 0 %.6f %.4f %.4f cm /D Do Q\n",
+                     scale, -scale, -r.x * scale - offsetX,
+                     pageH + r.y * scale + offsetY);
+    int id = PDF_OBJ_FIRST_PAGE + 2 * p;
+    BeginObject(&w, offsets, id);
+    ExportPutf(&w, "<< /Type /Page /Parent %d 0 R /MediaBox [0 0 %.2f %.2f]",
+               PDF_OBJ_PAGES, pageW, pageH);
+    if (unit > 1.0f)
+      ExportPutf(&w, " /UserUnit %.0f", unit);
+    ExportPutf(&w, " /Resources << /XObject << /D %d 0 R >> >> /Contents %d 0 R >>\nendobj\n",
+               PDF_OBJ_DRAWING, id + 1);
+    BeginObject(&w, offsets, id + 1);
+    ExportPutf(&w, "<< /Length %d >>\nstream\n", n);
+    ExportPut(&w, content, (size_t)n);
+    ExportPutStr(&w, "\nendstream\nendobj\n");
+  }
+
+  BeginObject(&w, offsets, PDF_OBJ_PAGES);
+  ExportPutStr(&w, "<< /Type /Pages /Kids [");
+  for (int p = 0; p < pages; p++)
+    ExportPutf(&w, "%s%d 0 R", p % 16 == 15 ? "\n" : " ", PDF_OBJ_FIRST_PAGE + 2 * p);
+  ExportPutf(&w, "] /Count %d >>\nendobj\n", pages);
+
+  uint64_t xref = w.offset;
+  ExportPutf(&w, "xref\n0 %d\n0000000000 65535 f \n", objectCount);
+  for (int i = 1; i < objectCount; i++)
+    ExportPutf(&w, "%010llu 00000 n \n", (unsigned long long)offsets[i]);
+  ExportPutf(&w, "trailer\n<< /Size %d /Root %d 0 R >>\nstartxref\n%llu\n%%%%EOF\n",
+             objectCount, PDF_OBJ_CATALOG, (unsigned long long)xref);
+  free(offsets);
+  return ExportWriterClose(&w);
+}
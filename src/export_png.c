@@ -0,0 +1,190 @@
+#include "export_png.h"
+#include "export_deflate.h"
+#include "export_writer.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct PngWriter {
+  ExportWriter out;
+  int width;
+  int height;
+  int rows;
+  size_t rowBytes;
+  uint8_t *prev;     // last row as given, zeros before the first
+  uint8_t *filtered; // the row under each filter but None
+  DeflateStream *z;  // image data, written out as IDAT chunks
+};
+
+static uint32_t kCrcTable[256];
+static pthread_once_t gTablesOnce = PTHREAD_ONCE_INIT;
+
+static void BuildTables(void) {
+  for (uint32_t b = 0; b < 256; b++) {
+    uint32_t crc = b;
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    kCrcTable[b] = crc;
+  }
+}
+
+static uint32_t Crc32(uint32_t crc, const uint8_t *p, size_t size) {
+  crc = ~crc;
+  for (; size > 0; size--)
+    crc = (crc >> 8) ^ kCrcTable[(crc ^ *p++) & 0xFF];
+  return ~crc;
+}
+
+static void PutBE32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)(v >> 24);
+  p[1] = (uint8_t)(v >> 16);
+  p[2] = (uint8_t)(v >> 8);
+  p[3] = (uint8_t)v;
+}
+
+static void WriteChunk(PngWriter *png, const char *type, const uint8_t *data,
+                       size_t size) {
+  uint8_t head[8];
+  PutBE32(head, (uint32_t)size);
+  memcpy(head + 4, type, 4);
+  uint32_t crc = Crc32(0, head + 4, 4);
+  crc = Crc32(crc, data, size);
+  uint8_t tail[4];
+  PutBE32(tail, crc);
+  ExportPut(&png->out, (const char *)head, sizeof(head));
+  ExportPut(&png->out, (const char *)data, size);
+  ExportPut(&png->out, (const char *)tail, sizeof(tail));
+}
+
+static void WriteIdat(void *ctx, const uint8_t *data, size_t size) {
+  WriteChunk((PngWriter *)ctx, "IDAT", data, size);
+}
+
+// Written without branches so the filter loops vectorize.
+static uint8_t Paeth(int a, int b, int c) {
+  int pa = abs(b - c);
+  int pb = abs(a - c);
+  int pc = abs(a + b - 2 * c);
+  int bc = pb <= pc ? b : c;
+  return (uint8_t)(pa <= pb && pa <= pc ? a : bc);
+}
+
+// Sum of the filtered bytes taken as signed; the usual guess at which
+// filter compresses a row best. Wrapping on absurdly wide rows only makes
+// the guess worse.
+static uint32_t FilterCost(const uint8_t *row, size_t size) {
+  uint32_t cost = 0;
+  for (size_t i = 0; i < size; i++)
+    cost += (uint32_t)abs((int)(int8_t)row[i]);
+  return cost;
+}
+
+PngWriter *PngWriterOpen(const char *path, int width, int height, float dpi) {
+  if (!path || width <= 0 || height <= 0 || (size_t)width > SIZE_MAX / 12)
+    return NULL;
+  pthread_once(&gTablesOnce, BuildTables);
+  PngWriter *png = (PngWriter *)calloc(1, sizeof(PngWriter));
+  if (!png)
+    return NULL;
+  png->width = width;
+  png->height = height;
+  png->rowBytes = (size_t)width * 4;
+  png->prev = (uint8_t *)calloc(1, png->rowBytes);
+  png->filtered = (uint8_t *)malloc(png->rowBytes * 3);
+  if (!png->prev || !png->filtered || !ExportWriterOpen(&png->out, path)) {
+    free(png->prev);
+    free(png->filtered);
+    free(png);
+    return NULL;
+  }
+
+  static const uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  ExportPut(&png->out, (const char *)kSignature, sizeof(kSignature));
+  uint8_t ihdr[13];
+  PutBE32(ihdr, (uint32_t)width);
+  PutBE32(ihdr + 4, (uint32_t)height);
+  ihdr[8] = 8;  // bits per channel
+  ihdr[9] = 6;  // RGBA
+  ihdr[10] = 0; // deflate
+  ihdr[11] = 0; // adaptive filtering
+  ihdr[12] = 0; // not interlaced
+  WriteChunk(png, "IHDR", ihdr, sizeof(ihdr));
+  if (dpi > 0.0f) {
+    uint8_t phys[9];
+    uint32_t perMeter = (uint32_t)lroundf(dpi / 0.0254f);
+    PutBE32(phys, perMeter);
+    PutBE32(phys + 4, perMeter);
+    phys[8] = 1; // meters
+    WriteChunk(png, "pHYs", phys, sizeof(phys));
+  }
+  // The image data follows the header chunks.
+  png->z = DeflateOpen(WriteIdat, png);
+  if (!png->z) {
+    png->out.failed = true;
+    PngWriterClose(png);
+    return NULL;
+  }
+  return png;
+}
+
+void PngWriterRow(PngWriter *png, const uint8_t *rgba) {
+  if (png->rows >= png->height)
+    return;
+  const size_t n = png->rowBytes;
+  const size_t bpp = n < 4 ? n : 4;
+  const uint8_t *up = png->prev;
+  uint8_t *sub = png->filtered;
+  uint8_t *upf = sub + n;
+  uint8_t *paeth = upf + n;
+  // Rows repeating the last, common in margins, go straight out as Up.
+  if (png->rows > 0 && memcmp(rgba, up, n) == 0) {
+    static const uint8_t kUp = 2;
+    memset(upf, 0, n);
+    DeflateWrite(png->z, &kUp, 1);
+    DeflateWrite(png->z, upf, n);
+    png->rows++;
+    return;
+  }
+  // The first pixel has nothing to its left.
+  for (size_t i = 0; i < bpp; i++) {
+    sub[i] = rgba[i];
+    paeth[i] = (uint8_t)(rgba[i] - up[i]);
+  }
+  for (size_t i = bpp; i < n; i++)
+    sub[i] = (uint8_t)(rgba[i] - rgba[i - 4]);
+  for (size_t i = 0; i < n; i++)
+    upf[i] = (uint8_t)(rgba[i] - up[i]);
+  for (size_t i = bpp; i < n; i++)
+    paeth[i] = (uint8_t)(rgba[i] - Paeth(rgba[i - 4], up[i], up[i - 4]));
+
+  static const uint8_t kTypes[4] = {0, 1, 2, 4}; // None, Sub, Up, Paeth
+  const uint8_t *rows[4] = {rgba, sub, upf, paeth};
+  int best = 0;
+  uint32_t bestCost = FilterCost(rgba, n);
+  for (int k = 1; k < 4; k++) {
+    uint32_t cost = FilterCost(rows[k], n);
+    if (cost < bestCost) {
+      bestCost = cost;
+      best = k;
+    }
+  }
+  DeflateWrite(png->z, &kTypes[best], 1);
+  DeflateWrite(png->z, rows[best], n);
+  memcpy(png->prev, rgba, n);
+  png->rows++;
+}
+
+bool PngWriterClose(PngWriter *png) {
+  if (!png)
+    return false;
+  bool complete = png->rows == png->height;
+  DeflateClose(png->z);
+  WriteChunk(png, "IEND", (const uint8_t *)"", 0);
+
+  bool ok = ExportWriterClose(&png->out) && complete;
+  free(png->prev);
+  free(png->filtered);
+  free(png);
+  return ok;
+}
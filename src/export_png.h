@@ -0,0 +1,19 @@
+#ifndef EXPORT_PNG_H
+#define EXPORT_PNG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// PNG encoder that takes the image a scanline at a time, so an export of
+// any size needs only the rows its caller has in hand. Rows are 8-bit RGBA,
+// top to bottom. Compression is deflate with the fixed Huffman codes.
+typedef struct PngWriter PngWriter;
+
+// `dpi` is recorded in the file for printing; 0 leaves it out.
+PngWriter *PngWriterOpen(const char *path, int width, int height, float dpi);
+void PngWriterRow(PngWriter *png, const uint8_t *rgba);
+// Finishes the file and frees the writer; false if anything failed since
+// the open or fewer than `height` rows arrived.
+bool PngWriterClose(PngWriter *png);
+
+#endif // EXPORT_PNG_H
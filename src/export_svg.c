@@ -0,0 +1,299 @@
+#include "export.h"
+#include "export_geometry.h"
+#include "export_writer.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void PutColorAttr(ExportWriter *w, const char *name, Color c) {
+  ExportPutf(w, " %s=\"#%02X%02X%02X\"", name, c.r, c.g, c.b);
+  if (c.a < 255)
+    ExportPutf(w, " %s-opacity=\"%.3f\"", name, (float)c.a / 255.0f);
+}
+
+static void PutAttr(ExportWriter *w, const char *name, float v) {
+  ExportPutf(w, " %s=\"", name);
+  ExportPutNumber(w, v);
+  ExportPut(w, "\"", 1);
+}
+
+// Path data with relative coordinates on the hundredths grid. Numbers need a
+// separator only when the next one would otherwise run into the last.
+typedef struct {
+  ExportWriter *w;
+  int64_t x, y; // pen position, quantized
+  bool lastHasDot;
+  bool needSeparator;
+  int64_t startX, startY; // start of the current subpath, where "z" returns
+} SvgPath;
+
+static void PathCommand(SvgPath *p, char command) {
+  ExportPut(p->w, &command, 1);
+  p->needSeparator = false;
+}
+
+static void PathNumber(SvgPath *p, int64_t q) {
+  char text[EXPORT_FORMAT_MAX];
+  size_t len = ExportFormatHundredths(text, q);
+  if (p->needSeparator && text[0] != '-' && !(text[0] == '.' && p->lastHasDot))
+    ExportPut(p->w, " ", 1);
+  ExportPut(p->w, text, len);
+  p->lastHasDot = memchr(text, '.', len) != NULL;
+  p->needSeparator = true;
+}
+
+static void PathMoveTo(SvgPath *p, float x, float y) {
+  int64_t qx = ExportQuantize(x), qy = ExportQuantize(y);
+  PathCommand(p, 'm');
+  PathNumber(p, qx - p->x);
+  PathNumber(p, qy - p->y);
+  p->x = qx;
+  p->y = qy;
+  p->startX = qx;
+  p->startY = qy;
+}
+
+// "z" leaves the pen at the subpath's start, which the next relative move
+// is measured from.
+static void PathClose(SvgPath *p) {
+  PathCommand(p, 'z');
+  p->x = p->startX;
+  p->y = p->startY;
+}
+
+static void PathLineTo(SvgPath *p, float x, float y) {
+  int64_t qx = ExportQuantize(x), qy = ExportQuantize(y);
+  PathNumber(p, qx - p->x);
+  PathNumber(p, qy - p->y);
+  p->x = qx;
+  p->y = qy;
+}
+
+// A polyline as one subpath: "m" to the start, then implicit "l" deltas.
+// Points that round onto the previous one are dropped, except that a stroke
+// keeps one segment so its round caps still draw a dot.
+static void PathPolyline(SvgPath *p, const Point *pts, int count) {
+  PathMoveTo(p, pts[0].x, pts[0].y);
+  bool any = false;
+  for (int i = 1; i < count; i++) {
+    int64_t qx = ExportQuantize(pts[i].x), qy = ExportQuantize(pts[i].y);
+    if (qx == p->x && qy == p->y)
+      continue;
+    if (!any)
+      PathCommand(p, 'l');
+    PathLineTo(p, pts[i].x, pts[i].y);
+    any = true;
+  }
+  if (!any) {
+    PathCommand(p, 'l');
+    PathNumber(p, 0);
+    PathNumber(p, 0);
+  }
+}
+
+// Consecutive strokes of one color and width share a <g> carrying the style;
+// filled outlines group by color alone. Opaque strokes in a group also share
+// one <path>; translucent ones keep their own, since overlapping subpaths of
+// one path do not blend twice.
+typedef struct {
+  ExportWriter *w;
+  bool groupOpen;
+  bool filled;
+  Color color;
+  float width;
+  bool pathOpen;
+  SvgPath path;
+} SvgStyleState;
+
+static void ClosePath(SvgStyleState *st) {
+  if (st->pathOpen)
+    ExportPutStr(st->w, "\"/>\n");
+  st->pathOpen = false;
+}
+
+static void CloseGroup(SvgStyleState *st) {
+  ClosePath(st);
+  if (st->groupOpen)
+    ExportPutStr(st->w, "</g>\n");
+  st->groupOpen = false;
+}
+
+static void UseStyle(SvgStyleState *st, Color color, float width, bool filled) {
+  if (filled)
+    width = 0.0f;
+  if (st->groupOpen && memcmp(&st->color, &color, sizeof(Color)) == 0 &&
+      st->width == width && st->filled == filled)
+    return;
+  CloseGroup(st);
+  if (filled) {
+    ExportPutStr(st->w, "<g");
+    PutColorAttr(st->w, "fill", color);
+    ExportPutStr(st->w, ">\n");
+  } else {
+    ExportPutStr(st->w, "<g fill=\"none\"");
+    PutColorAttr(st->w, "stroke", color);
+    PutAttr(st->w, "stroke-width", width);
+    ExportPutStr(st->w, " stroke-linecap=\"round\" stroke-linejoin=\"round\">\n");
+  }
+  st->groupOpen = true;
+  st->filled = filled;
+  st->color = color;
+  st->width = width;
+}
+
+static SvgPath *OpenPath(SvgStyleState *st) {
+  if (st->pathOpen && st->color.a == 255)
+    return &st->path;
+  ClosePath(st);
+  ExportPutStr(st->w, "<path d=\"");
+  st->path = (SvgPath){st->w, 0, 0, false, false};
+  st->pathOpen = true;
+  return &st->path;
+}
+
+static void WriteArrow(ExportWriter *w, const Stroke *s) {
+  Vector2 start = {s->points[0].x, s->points[0].y};
+  Vector2 shaftEnd = {s->points[1].x, s->points[1].y};
+  Vector2 head[3];
+  bool hasHead = StrokeArrowHead(s, s->thickness, &shaftEnd, head);
+
+  ExportPutStr(w, "<line");
+  PutAttr(w, "x1", start.x);
+  PutAttr(w, "y1", start.y);
+  PutAttr(w, "x2", shaftEnd.x);
+  PutAttr(w, "y2", shaftEnd.y);
+  PutColorAttr(w, "stroke", s->color);
+  PutAttr(w, "stroke-width", s->thickness);
+  ExportPutStr(w, " stroke-linecap=\"round\"/>\n");
+  if (!hasHead)
+    return;
+
+  ExportPutStr(w, "<path d=\"");
+  SvgPath p = {w, 0, 0, false, false};
+  Point tri[3] = {{head[0].x, head[0].y, 0.0f},
+                  {head[1].x, head[1].y, 0.0f},
+                  {head[2].x, head[2].y, 0.0f}};
+  PathPolyline(&p, tri, 3);
+  PathClose(&p);
+  ExportPut(w, "\"", 1);
+  PutColorAttr(w, "fill", s->color);
+  ExportPutStr(w, "/>\n");
+}
+
+static void WriteGrid(ExportWriter *w, Rectangle view, Color grid, float zoom) {
+  ExportGrid g = ExportGridLines(view, zoom);
+
+  // All lines in one path: a move to each line's start, then "V"/"H" to its
+  // far end.
+  ExportPutStr(w, "<path fill=\"none\"");
+  PutColorAttr(w, "stroke", grid);
+  ExportPutStr(w, " stroke-width=\"1\" d=\"");
+  SvgPath p = {w, 0, 0, false, false};
+  for (int i = g.startCol; i <= g.endCol; i++) {
+    float x = (float)i * g.spacing;
+    PathMoveTo(&p, x, view.y);
+    PathCommand(&p, 'v');
+    int64_t end = ExportQuantize(view.y + view.height);
+    PathNumber(&p, end - p.y);
+    p.y = end;
+  }
+  for (int i = g.startRow; i <= g.endRow; i++) {
+    float y = (float)i * g.spacing;
+    PathMoveTo(&p, view.x, y);
+    PathCommand(&p, 'h');
+    int64_t end = ExportQuantize(view.x + view.width);
+    PathNumber(&p, end - p.x);
+    p.x = end;
+  }
+  ExportPutStr(w, "\"/>\n");
+}
+
+static void WriteStrokePath(SvgStyleState *st, Stroke *s, float thickness,
+                            ExportScratch *scratch) {
+  const Point *pts;
+  bool filled;
+  int count = ExportPathPoints(s, thickness, scratch, &pts, &filled);
+  UseStyle(st, s->color, thickness, filled);
+  SvgPath *p = OpenPath(st);
+  PathPolyline(p, pts, count);
+  if (filled)
+    PathClose(p);
+}
+
+bool ExportSvgFile(Canvas *canvas, const ExportView *view, const char *path) {
+  if (!canvas || !view || !path)
+    return false;
+  Rectangle r = view->view;
+  if (r.width <= 0.0f)
+    r.width = 1.0f;
+  if (r.height <= 0.0f)
+    r.height = 1.0f;
+
+  ExportWriter w;
+  if (!ExportWriterOpen(&w, path))
+    return false;
+
+  ExportPutStr(&w, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+  ExportPutStr(&w, "<svg xmlns=\"http://www.w3.org/2000/svg\"");
+  PutAttr(&w, "width", view->width);
+  PutAttr(&w, "height", view->height);
+  ExportPutf(&w, " viewBox=\"%.2f %.2f %.2f %.2f\">\n", r.x, r.y, r.width, r.height);
+
+  ExportPutStr(&w, "<rect");
+  PutAttr(&w, "x", r.x);
+  PutAttr(&w, "y", r.y);
+  PutAttr(&w, "width", r.width);
+  PutAttr(&w, "height", r.height);
+  PutColorAttr(&w, "fill", canvas->backgroundColor);
+  ExportPutStr(&w, "/>\n");
+
+  if (canvas->showGrid)
+    WriteGrid(&w, r, canvas->gridColor, view->gridZoom);
+
+  SvgStyleState st = {0};
+  st.w = &w;
+  ExportScratch scratch = {0};
+  for (int i = 0; i < canvas->strokeCount; i++) {
+    Stroke *s = &canvas->strokes[i];
+    if (s->pointCount < 2)
+      continue;
+
+    float thickness = (s->thickness > 0.0f) ? s->thickness : 1.0f;
+    if (s->shape == STROKE_SHAPE_ARROW) {
+      CloseGroup(&st);
+      WriteArrow(&w, s);
+      continue;
+    }
+
+    if (s->shape == STROKE_SHAPE_PATH) {
+      WriteStrokePath(&st, s, thickness, &scratch);
+      continue;
+    }
+
+    UseStyle(&st, s->color, thickness, false);
+    if (s->shape == STROKE_SHAPE_RECT) {
+      Point a = s->points[0], b = s->points[1];
+      ClosePath(&st);
+      ExportPutStr(&w, "<rect");
+      PutAttr(&w, "x", fminf(a.x, b.x));
+      PutAttr(&w, "y", fminf(a.y, b.y));
+      PutAttr(&w, "width", fabsf(b.x - a.x));
+      PutAttr(&w, "height", fabsf(b.y - a.y));
+      ExportPutStr(&w, "/>\n");
+      continue;
+    }
+    if (s->shape == STROKE_SHAPE_CIRCLE) {
+      ClosePath(&st);
+      ExportPutStr(&w, "<circle");
+      PutAttr(&w, "cx", s->points[0].x);
+      PutAttr(&w, "cy", s->points[0].y);
+      PutAttr(&w, "r", StrokeCircleRadius(s));
+      ExportPutStr(&w, "/>\n");
+    }
+  }
+  CloseGroup(&st);
+  free(scratch.points);
+
+  ExportPutStr(&w, "</svg>\n");
+  return ExportWriterClose(&w);
+}
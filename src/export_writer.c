@@ -0,0 +1,114 @@
+#include "export_writer.h"
+#include <math.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EXPORT_BUFFER_SIZE (1 << 16)
+// Past this, coordinates are nonsense anyway; it keeps q * 100 in range.
+#define EXPORT_MAX_MAGNITUDE 1e15
+
+bool ExportWriterOpen(ExportWriter *w, const char *path) {
+  memset(w, 0, sizeof(*w));
+  w->buf = (char *)malloc(EXPORT_BUFFER_SIZE);
+  if (!w->buf)
+    return false;
+  w->f = fopen(path, "wb");
+  if (!w->f) {
+    free(w->buf);
+    w->buf = NULL;
+    return false;
+  }
+  return true;
+}
+
+static void Flush(ExportWriter *w) {
+  if (w->len > 0 && fwrite(w->buf, 1, w->len, w->f) != w->len)
+    w->failed = true;
+  w->len = 0;
+}
+
+bool ExportWriterClose(ExportWriter *w) {
+  if (!w->f)
+    return false;
+  Flush(w);
+  if (fclose(w->f) != 0)
+    w->failed = true;
+  free(w->buf);
+  w->f = NULL;
+  w->buf = NULL;
+  return !w->failed;
+}
+
+void ExportPut(ExportWriter *w, const char *data, size_t size) {
+  w->offset += size;
+  if (w->len + size > EXPORT_BUFFER_SIZE) {
+    Flush(w);
+    if (size > EXPORT_BUFFER_SIZE) {
+      if (fwrite(data, 1, size, w->f) != size)
+        w->failed = true;
+      return;
+    }
+  }
+  memcpy(w->buf + w->len, data, size);
+  w->len += size;
+}
+
+void ExportPutStr(ExportWriter *w, const char *s) { ExportPut(w, s, strlen(s)); }
+
+void ExportPutf(ExportWriter *w, const char *fmt, ...) {
+  char text[512];
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(text, sizeof(text), fmt, args);
+  va_end(args);
+  if (n < 0 || (size_t)n >= sizeof(text)) {
+    w->failed = true;
+    return;
+  }
+  ExportPut(w, text, (size_t)n);
+}
+
+int64_t ExportQuantize(float v) {
+  double d = (double)v;
+  if (!(d == d))
+    return 0;
+  if (d > EXPORT_MAX_MAGNITUDE)
+    d = EXPORT_MAX_MAGNITUDE;
+  if (d < -EXPORT_MAX_MAGNITUDE)
+    d = -EXPORT_MAX_MAGNITUDE;
+  // Ties go to even, like printf.
+  return (int64_t)llrint(d * 100.0);
+}
+
+size_t ExportFormatHundredths(char *out, int64_t q) {
+  char *p = out;
+  uint64_t u = q < 0 ? (uint64_t)0 - (uint64_t)q : (uint64_t)q;
+  if (q < 0)
+    *p++ = '-';
+  uint64_t whole = u / 100;
+  unsigned frac = (unsigned)(u % 100);
+
+  if (whole > 0 || frac == 0) {
+    char digits[20];
+    int n = 0;
+    do {
+      digits[n++] = (char)('0' + whole % 10);
+      whole /= 10;
+    } while (whole > 0);
+    while (n > 0)
+      *p++ = digits[--n];
+  }
+  if (frac != 0) {
+    *p++ = '.';
+    *p++ = (char)('0' + frac / 10);
+    if (frac % 10 != 0)
+      *p++ = (char)('0' + frac % 10);
+  }
+  return (size_t)(p - out);
+}
+
+void ExportPutNumber(ExportWriter *w, float v) {
+  char text[EXPORT_FORMAT_MAX];
+  ExportPut(w, text, ExportFormatHundredths(text, ExportQuantize(v)));
+}
@@ -0,0 +1,35 @@
+#ifndef EXPORT_WRITER_H
+#define EXPORT_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Buffered output for the text-based exporters. Errors are sticky and
+// reported by ExportWriterClose, so writers need not check every call.
+typedef struct {
+  FILE *f;
+  char *buf;
+  size_t len;
+  uint64_t offset; // bytes put since the open
+  bool failed;
+} ExportWriter;
+
+bool ExportWriterOpen(ExportWriter *w, const char *path);
+// Flushes and closes; false if anything failed since the open.
+bool ExportWriterClose(ExportWriter *w);
+
+void ExportPut(ExportWriter *w, const char *data, size_t size);
+void ExportPutStr(ExportWriter *w, const char *s);
+void ExportPutf(ExportWriter *w, const char *fmt, ...);
+
+// Values are written to hundredths. ExportQuantize rounds to that grid (so
+// deltas of quantized values add up without drift); ExportFormatHundredths
+// prints one as the shortest decimal: "12.5", "-.25", "3".
+#define EXPORT_FORMAT_MAX 24
+int64_t ExportQuantize(float v);
+size_t ExportFormatHundredths(char *out, int64_t q);
+void ExportPutNumber(ExportWriter *w, float v);
+
+#endif // EXPORT_WRITER_H
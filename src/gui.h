@@ -15,6 +15,19 @@ typedef struct {
   Canvas canvas;
   char path[256];
   bool hasPath;
+  // Sidecar file name under the autosave directory, and the canvas edit
+  // count it (or the document file) last caught up with.
+  char autosaveName[48];
+  uint64_t autosavedEdits;
+  // Set while the file is still being read on the open worker; the canvas
+  // holds a preview that only pans and zooms.
+  bool loading;
+  float loadProgress;
+  // The user was told that part of the file could not be read.
+  bool unreadableReported;
+  // Opened from an autosave sidecar and not saved since: the sidecar is the
+  // only copy of its edits, so closing the tab asks first.
+  bool recovered;
 } Document;
 
 typedef struct {
@@ -53,6 +66,15 @@ typedef struct {
   int activeTool;
   Color currentColor;
   float currentThickness;
+  float simplifyTolerance;
+  bool compressSaves;
+  // Print-size PNG export: pixel sizes of 0 follow the drawing at exportDpi.
+  float exportDpi;
+  int exportWidth;
+  int exportHeight;
+  // PDF export pages in points; 0 puts the drawing on one page its size.
+  float pdfPageWidth;
+  float pdfPageHeight;
   Rectangle toolbarRect;
 
   // Slider State
@@ -67,6 +89,11 @@ typedef struct {
   bool showWelcome;
   bool hasSeenWelcome;
 
+  // Autosave recovery: sidecars from an earlier run wait to be recovered or
+  // discarded, and closing a recovered tab waits for confirmation (-1: none).
+  bool showRecovery;
+  int confirmCloseDocument;
+
   // Palette State
   Rectangle paletteRect;
   Rectangle paletteButtonRect;
@@ -142,6 +169,24 @@ void DrawCursorOverlay(GuiState *gui, const Canvas *canvas, bool mouseOverGui);
 void GuiDocumentsInit(GuiState *gui, int screenWidth, int screenHeight,
                       bool showGrid);
 void GuiDocumentsFree(GuiState *gui);
+
+// Periodic autosave of documents with unsaved edits to sidecar files, written
+// on a worker thread. Starting finds sidecars left by an earlier run that are
+// newer than their documents and offers to recover them; stopping autosaves
+// what is left.
+void GuiAutosaveStart(GuiState *gui);
+void GuiAutosaveUpdate(GuiState *gui);
+void GuiAutosaveStop(GuiState *gui);
+
+// Files open on a worker thread (gui_open.c). Each frame moves the strokes
+// read so far into the document, and finishes or cancels (Escape) the open.
+void GuiOpenUpdate(GuiState *gui);
+void GuiOpenStop(void);
+// Exports finish in the background (gui_export.c); each frame draws a few
+// more tiles and reports a finished export. Stopping abandons a running one.
+void GuiExportUpdate(GuiState *gui);
+void GuiExportStop(void);
+bool GuiActiveDocumentLoading(GuiState *gui);
 Document *GuiGetActiveDocument(GuiState *gui);
 Canvas *GuiGetActiveCanvas(GuiState *gui);
 
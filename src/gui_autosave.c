@@ -0,0 +1,344 @@
+#include "app_paths.h"
+#include "gui_internal.h"
+#include <dirent.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// Seconds between autosave passes over documents with unsaved edits.
+static const double kAutosaveInterval = 30.0;
+
+// Each sidecar is <name>.cdraw plus <name>.path holding the document path
+// ("" for untitled documents).
+typedef struct {
+  Canvas *snapshot;
+  char name[48];
+  char docPath[256];
+} AutosaveJob;
+
+typedef struct {
+  char name[48];
+  char docPath[256];
+} AutosaveSidecar;
+
+static struct {
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  AutosaveJob job;    // pending while job.snapshot is set
+  char writing[48];   // name of the sidecar being written, if any
+  bool discardWriting; // its document was saved meanwhile; delete it after
+  bool stop;
+  bool running;
+  char dir[1024];
+  double lastPass;
+  // Sidecars found at start that wait for the user to recover or discard them.
+  AutosaveSidecar *pending;
+  int pendingCount;
+  int pendingCapacity;
+} gAutosave;
+
+static void SidecarPath(char *out, size_t size, const char *name, const char *ext) {
+  snprintf(out, size, "%s/%s%s", gAutosave.dir, name, ext);
+}
+
+static void RemoveSidecar(const char *name) {
+  char path[1200];
+  SidecarPath(path, sizeof(path), name, ".cdraw");
+  remove(path);
+  SidecarPath(path, sizeof(path), name, ".path");
+  remove(path);
+}
+
+static bool WriteSidecar(const AutosaveJob *job) {
+  char path[1200];
+  SidecarPath(path, sizeof(path), job->name, ".path");
+  FILE *f = fopen(path, "wb");
+  if (!f)
+    return false;
+  bool ok = fputs(job->docPath, f) >= 0;
+  if (fclose(f) != 0)
+    ok = false;
+  SidecarPath(path, sizeof(path), job->name, ".cdraw");
+  return ok && WriteCanvasFile(job->snapshot, path);
+}
+
+static void *AutosaveThreadMain(void *arg) {
+  (void)arg;
+  pthread_mutex_lock(&gAutosave.lock);
+  for (;;) {
+    while (!gAutosave.job.snapshot && !gAutosave.stop)
+      pthread_cond_wait(&gAutosave.wake, &gAutosave.lock);
+    if (!gAutosave.job.snapshot)
+      break;
+
+    AutosaveJob job = gAutosave.job;
+    gAutosave.job.snapshot = NULL;
+    memcpy(gAutosave.writing, job.name, sizeof(gAutosave.writing));
+    gAutosave.discardWriting = false;
+    pthread_mutex_unlock(&gAutosave.lock);
+
+    if (!WriteSidecar(&job))
+      fprintf(stderr, "Autosave failed: %s\n", job.name);
+    CanvasSnapshotFree(job.snapshot);
+
+    pthread_mutex_lock(&gAutosave.lock);
+    if (gAutosave.discardWriting)
+      RemoveSidecar(job.name);
+    gAutosave.writing[0] = '\0';
+  }
+  pthread_mutex_unlock(&gAutosave.lock);
+  return NULL;
+}
+
+static bool DocumentNeedsAutosave(const Document *doc) {
+  return doc->canvas.editCount != doc->autosavedEdits && !doc->canvas.lazy &&
+         doc->autosaveName[0] != '\0';
+}
+
+static void FillJob(AutosaveJob *job, Document *doc, Canvas *snapshot) {
+  job->snapshot = snapshot;
+  memcpy(job->name, doc->autosaveName, sizeof(job->name));
+  snprintf(job->docPath, sizeof(job->docPath), "%s", doc->hasPath ? doc->path : "");
+  doc->autosavedEdits = doc->canvas.editCount;
+}
+
+void GuiAutosaveNameDocument(Document *doc) {
+  static unsigned counter = 0;
+  snprintf(doc->autosaveName, sizeof(doc->autosaveName), "doc-%lx-%ld-%u",
+           (unsigned long)time(NULL), (long)getpid(), counter++);
+}
+
+void GuiAutosaveForget(Document *doc) {
+  if (!doc)
+    return;
+  doc->autosavedEdits = doc->canvas.editCount;
+  doc->recovered = false;
+  if (!gAutosave.running || doc->autosaveName[0] == '\0')
+    return;
+  pthread_mutex_lock(&gAutosave.lock);
+  if (gAutosave.job.snapshot && strcmp(gAutosave.job.name, doc->autosaveName) == 0) {
+    CanvasSnapshotFree(gAutosave.job.snapshot);
+    gAutosave.job.snapshot = NULL;
+  }
+  if (strcmp(gAutosave.writing, doc->autosaveName) == 0)
+    gAutosave.discardWriting = true;
+  RemoveSidecar(doc->autosaveName);
+  pthread_mutex_unlock(&gAutosave.lock);
+}
+
+static double FileTime(const char *path) {
+  struct stat st;
+  if (stat(path, &st) != 0)
+    return -1.0;
+  return (double)st.st_mtim.tv_sec + (double)st.st_mtim.tv_nsec * 1e-9;
+}
+
+static bool AddPending(const char *name, const char *docPath) {
+  if (gAutosave.pendingCount >= gAutosave.pendingCapacity) {
+    int newCap = gAutosave.pendingCapacity == 0 ? 4 : gAutosave.pendingCapacity * 2;
+    AutosaveSidecar *next = (AutosaveSidecar *)realloc(
+        gAutosave.pending, sizeof(AutosaveSidecar) * (size_t)newCap);
+    if (!next)
+      return false;
+    gAutosave.pending = next;
+    gAutosave.pendingCapacity = newCap;
+  }
+  AutosaveSidecar *entry = &gAutosave.pending[gAutosave.pendingCount++];
+  memcpy(entry->name, name, sizeof(entry->name));
+  memcpy(entry->docPath, docPath, sizeof(entry->docPath));
+  return true;
+}
+
+static void FreePending(void) {
+  free(gAutosave.pending);
+  gAutosave.pending = NULL;
+  gAutosave.pendingCount = 0;
+  gAutosave.pendingCapacity = 0;
+}
+
+// Lists each sidecar that is newer than its document for the recovery card;
+// older ones are stale and removed.
+static int FindSidecars(void) {
+  DIR *dir = opendir(gAutosave.dir);
+  if (!dir)
+    return 0;
+
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    char name[48];
+    size_t len = strlen(entry->d_name);
+    if (len <= 6 || len - 6 >= sizeof(name) ||
+        strcmp(entry->d_name + len - 6, ".cdraw") != 0)
+      continue;
+    memcpy(name, entry->d_name, len - 6);
+    name[len - 6] = '\0';
+
+    char path[1200];
+    char docPath[256] = {0};
+    SidecarPath(path, sizeof(path), name, ".path");
+    FILE *meta = fopen(path, "rb");
+    if (meta) {
+      size_t n = fread(docPath, 1, sizeof(docPath) - 1, meta);
+      docPath[n] = '\0';
+      fclose(meta);
+    }
+
+    SidecarPath(path, sizeof(path), name, ".cdraw");
+    if (docPath[0] != '\0' && FileTime(docPath) >= FileTime(path)) {
+      RemoveSidecar(name);
+      continue;
+    }
+    if (!AddPending(name, docPath))
+      break;
+  }
+  closedir(dir);
+  return gAutosave.pendingCount;
+}
+
+int GuiAutosavePendingCount(void) { return gAutosave.pendingCount; }
+
+const char *GuiAutosavePendingPath(int index) {
+  if (index < 0 || index >= gAutosave.pendingCount)
+    return "";
+  return gAutosave.pending[index].docPath;
+}
+
+// Opens each waiting sidecar in a new tab. The tab keeps its sidecar, and is
+// marked recovered until it is saved.
+void GuiAutosaveRecover(GuiState *gui, int screenWidth, int screenHeight) {
+  int recovered = 0;
+  int failed = 0;
+  for (int i = 0; i < gAutosave.pendingCount; i++) {
+    const AutosaveSidecar *entry = &gAutosave.pending[i];
+    char path[1200];
+    SidecarPath(path, sizeof(path), entry->name, ".cdraw");
+    Document *doc = GuiAddDocument(gui, screenWidth, screenHeight, true, recovered == 0);
+    if (!doc) {
+      failed += gAutosave.pendingCount - i;
+      break;
+    }
+    if (!LoadCanvasFromFile(&doc->canvas, path)) {
+      GuiCloseDocument(gui, gui->documentCount - 1, screenWidth, screenHeight, true);
+      failed++;
+      continue;
+    }
+    memcpy(doc->autosaveName, entry->name, sizeof(doc->autosaveName));
+    doc->autosavedEdits = doc->canvas.editCount;
+    doc->recovered = true;
+    if (entry->docPath[0] != '\0') {
+      memcpy(doc->path, entry->docPath, sizeof(doc->path));
+      doc->hasPath = true;
+    }
+    recovered++;
+  }
+  FreePending();
+  gui->showRecovery = false;
+
+  char msg[96];
+  if (failed > 0)
+    snprintf(msg, sizeof(msg), "Recovered %d autosaved canvas%s; %d could not be read.",
+             recovered, recovered == 1 ? "" : "es", failed);
+  else
+    snprintf(msg, sizeof(msg), "Recovered %d autosaved canvas%s. Save to keep.",
+             recovered, recovered == 1 ? "" : "es");
+  GuiToastSet(gui, msg);
+}
+
+void GuiAutosaveDiscard(GuiState *gui) {
+  for (int i = 0; i < gAutosave.pendingCount; i++)
+    RemoveSidecar(gAutosave.pending[i].name);
+  FreePending();
+  gui->showRecovery = false;
+  GuiToastSet(gui, "Autosaved canvases discarded.");
+}
+
+void GuiAutosaveStart(GuiState *gui) {
+  if (gAutosave.running ||
+      !CdrawDataDir(gAutosave.dir, sizeof(gAutosave.dir), "autosave"))
+    return;
+
+  gui->showRecovery = FindSidecars() > 0;
+
+  pthread_mutex_init(&gAutosave.lock, NULL);
+  pthread_cond_init(&gAutosave.wake, NULL);
+  gAutosave.job.snapshot = NULL;
+  gAutosave.writing[0] = '\0';
+  gAutosave.stop = false;
+  gAutosave.lastPass = GetTime();
+  if (pthread_create(&gAutosave.thread, NULL, AutosaveThreadMain, NULL) != 0) {
+    pthread_cond_destroy(&gAutosave.wake);
+    pthread_mutex_destroy(&gAutosave.lock);
+    fprintf(stderr, "Autosave: no worker thread\n");
+    return;
+  }
+  gAutosave.running = true;
+}
+
+// Hands at most one changed document per frame to the worker. The snapshot
+// costs a copy of the stroke headers; the main thread never waits for a
+// write in progress.
+void GuiAutosaveUpdate(GuiState *gui) {
+  if (!gAutosave.running)
+    return;
+  double now = GetTime();
+  if (now - gAutosave.lastPass < kAutosaveInterval)
+    return;
+  if (pthread_mutex_trylock(&gAutosave.lock) != 0)
+    return;
+  if (gAutosave.job.snapshot || gAutosave.writing[0] != '\0') {
+    pthread_mutex_unlock(&gAutosave.lock);
+    return;
+  }
+
+  bool posted = false;
+  for (int i = 0; i < gui->documentCount && !posted; i++) {
+    Document *doc = &gui->documents[i];
+    if (!DocumentNeedsAutosave(doc))
+      continue;
+    Canvas *snapshot = CanvasSnapshotCreate(&doc->canvas, false);
+    if (!snapshot)
+      continue;
+    FillJob(&gAutosave.job, doc, snapshot);
+    pthread_cond_signal(&gAutosave.wake);
+    posted = true;
+  }
+  // Keep going on the next frames until every changed document is written.
+  if (!posted)
+    gAutosave.lastPass = now;
+  pthread_mutex_unlock(&gAutosave.lock);
+}
+
+void GuiAutosaveStop(GuiState *gui) {
+  if (!gAutosave.running)
+    return;
+  pthread_mutex_lock(&gAutosave.lock);
+  gAutosave.stop = true;
+  pthread_cond_signal(&gAutosave.wake);
+  pthread_mutex_unlock(&gAutosave.lock);
+  pthread_join(gAutosave.thread, NULL);
+  pthread_cond_destroy(&gAutosave.wake);
+  pthread_mutex_destroy(&gAutosave.lock);
+  gAutosave.running = false;
+  // Sidecars the user has not decided on stay for the next start.
+  FreePending();
+
+  // Unsaved edits survive quitting too; they are offered again next start.
+  for (int i = 0; i < gui->documentCount; i++) {
+    Document *doc = &gui->documents[i];
+    if (!DocumentNeedsAutosave(doc))
+      continue;
+    AutosaveJob job = {0};
+    Canvas *snapshot = CanvasSnapshotCreate(&doc->canvas, false);
+    if (!snapshot)
+      continue;
+    FillJob(&job, doc, snapshot);
+    if (!WriteSidecar(&job))
+      fprintf(stderr, "Autosave failed: %s\n", job.name);
+    CanvasSnapshotFree(snapshot);
+  }
+}
@@ -21,6 +21,7 @@ static Document *GuiAddDocumentInternal(GuiState *gui, int screenWidth,
   doc->canvas.showGrid = showGrid;
   doc->hasPath = false;
   doc->path[0] = '\0';
+  GuiAutosaveNameDocument(doc);
 
   if (makeActive)
     gui->activeDocument = gui->documentCount - 1;
@@ -62,17 +63,39 @@ Canvas *GuiGetActiveCanvas(GuiState *gui) {
   return &doc->canvas;
 }
 
+bool GuiActiveDocumentLoading(GuiState *gui) {
+  Document *doc = GuiGetActiveDocument(gui);
+  return doc && doc->loading;
+}
+
 Document *GuiAddDocument(GuiState *gui, int screenWidth, int screenHeight,
                          bool showGrid, bool makeActive) {
   return GuiAddDocumentInternal(gui, screenWidth, screenHeight, showGrid,
                                 makeActive);
 }
 
+bool GuiRequestCloseDocument(GuiState *gui, int index) {
+  if (index < 0 || index >= gui->documentCount)
+    return false;
+  if (gui->documents[index].recovered) {
+    gui->confirmCloseDocument = index;
+    return false;
+  }
+  GuiCloseDocument(gui, index, GetScreenWidth(), GetScreenHeight(),
+                   gui->documents[index].canvas.showGrid);
+  return true;
+}
+
 void GuiCloseDocument(GuiState *gui, int index, int screenWidth, int screenHeight,
                       bool showGrid) {
   if (index < 0 || index >= gui->documentCount)
     return;
 
+  if (gui->confirmCloseDocument == index)
+    gui->confirmCloseDocument = -1;
+  else if (gui->confirmCloseDocument > index)
+    gui->confirmCloseDocument--;
+  GuiAutosaveForget(&gui->documents[index]);
   FreeCanvas(&gui->documents[index].canvas);
   for (int i = index; i < gui->documentCount - 1; i++)
     gui->documents[i] = gui->documents[i + 1];
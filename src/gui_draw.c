@@ -14,6 +14,14 @@ void DrawGui(GuiState *gui, Canvas *canvas) {
     GuiDrawWelcome(gui, canvas, t, sw, sh);
     return;
   }
+  if (gui->showRecovery) {
+    GuiDrawRecovery(gui, t, sw, sh);
+    return;
+  }
+  if (gui->confirmCloseDocument >= 0) {
+    GuiDrawCloseConfirm(gui, t, sw, sh);
+    return;
+  }
 
 
   const float footerH = 24.0f;
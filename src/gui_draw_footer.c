@@ -90,7 +90,7 @@ void GuiDrawFooter(GuiState *gui, Canvas *canvas, Theme t, int sw, int sh) {
   DrawLineEx((Vector2){0, footer.y}, (Vector2){(float)sw, footer.y}, 1, t.border);
 
   Vector2 mouseWorld = GetScreenToWorld2D(GetMousePosition(), canvas->camera);
-  int totalPoints = GetTotalPoints(canvas);
+  long long totalPoints = (long long)GetTotalPoints(canvas);
   const float fontSize = 12.0f;
   Color textColor = gui->darkMode ? t.text : t.textDim;
 
@@ -99,19 +99,26 @@ void GuiDrawFooter(GuiState *gui, Canvas *canvas, Theme t, int sw, int sh) {
   char fpsText[24];
   char strokesText[32];
   char pointsText[32];
+  char simplifyText[48];
   snprintf(posText, sizeof(posText), "Pos: %.0f, %.0f", mouseWorld.x, mouseWorld.y);
   snprintf(zoomText, sizeof(zoomText), "Zoom: %.2f", canvas->camera.zoom);
   snprintf(fpsText, sizeof(fpsText), "FPS: %d", GetFPS());
   snprintf(strokesText, sizeof(strokesText), "Strokes: %d", canvas->strokeCount);
-  snprintf(pointsText, sizeof(pointsText), "Points: %d", totalPoints);
+  snprintf(pointsText, sizeof(pointsText), "Points: %lld", totalPoints);
+  simplifyText[0] = '\0';
+  if (canvas->lastCommitPointsIn > 0)
+    snprintf(simplifyText, sizeof(simplifyText), "Last stroke: %d -> %d pts",
+             canvas->lastCommitPointsIn, canvas->lastCommitPointsOut);
 
   float leftX = 12.0f;
   float rightX = (float)sw - 12.0f;
   float y = (float)sh - 20.0f;
   float gap = 12.0f;
 
-  const char *rightItems[] = {pointsText, strokesText};
-  for (int i = 0; i < 2; i++) {
+  const char *rightItems[] = {pointsText, strokesText, simplifyText};
+  for (int i = 0; i < 3; i++) {
+    if (rightItems[i][0] == '\0')
+      continue;
     Vector2 size = MeasureTextEx(gui->uiFont, rightItems[i], fontSize, 1.0f);
     if (rightX - size.x < leftX + 20.0f)
       continue;
@@ -121,8 +128,40 @@ void GuiDrawFooter(GuiState *gui, Canvas *canvas, Theme t, int sw, int sh) {
     rightX -= gap;
   }
 
+  // While the active document is opening or an export is being written, a
+  // progress bar takes the place of the position and zoom readouts.
+  Document *doc = GuiGetActiveDocument(gui);
+  char progressText[48];
+  float progress = 0.0f;
+  bool busy = true;
+  if (doc && doc->loading) {
+    progress = doc->loadProgress;
+    snprintf(progressText, sizeof(progressText), "Opening %d%%  (Esc to cancel)",
+             (int)(progress * 100.0f));
+  } else if (GuiExportProgress(&progress)) {
+    snprintf(progressText, sizeof(progressText), "Exporting %d%%",
+             (int)(progress * 100.0f));
+  } else {
+    busy = false;
+  }
+  if (busy) {
+    Rectangle bar = {leftX, footer.y + 10.0f, 140.0f, 8.0f};
+    if (bar.x + bar.width < rightX - 8.0f) {
+      DrawRectangleRounded(bar, 1.0f, 6, ColorAlpha(t.border, 0.6f));
+      Rectangle fill = bar;
+      fill.width = bar.width * progress;
+      if (fill.width > 0.0f)
+        DrawRectangleRounded(fill, 1.0f, 6, t.primary);
+      leftX += bar.width + gap;
+    }
+    Vector2 size = MeasureTextEx(gui->uiFont, progressText, fontSize, 1.0f);
+    if (leftX + size.x <= rightX - 8.0f)
+      DrawTextEx(gui->uiFont, progressText, (Vector2){leftX, y}, fontSize, 1.0f,
+                 textColor);
+  }
+
   const char *leftItems[] = {posText, zoomText, fpsText};
-  for (int i = 0; i < 3; i++) {
+  for (int i = 0; i < 3 && !busy; i++) {
     Vector2 size = MeasureTextEx(gui->uiFont, leftItems[i], fontSize, 1.0f);
     if (leftX + size.x > rightX - 8.0f)
       break;
@@ -1,5 +1,6 @@
 #include "gui_internal.h"
 #include "raymath.h"
+#include <stdio.h>
 
 void GuiDrawHeader(GuiState *gui, Canvas *canvas, Theme t, Color iconIdle,
                    Color iconHover, int sw) {
@@ -56,8 +57,10 @@ void GuiDrawHeader(GuiState *gui, Canvas *canvas, Theme t, Color iconIdle,
                        (Rectangle){tab.x + 8, tab.y + 6, 18, 18}, tabIcon);
 
     Document *doc = &gui->documents[i];
-    const char *label =
-        doc->hasPath ? GetFileName(doc->path) : "Untitled Sketch";
+    char label[160];
+    snprintf(label, sizeof(label), "%s%s",
+             doc->hasPath ? GetFileName(doc->path) : "Untitled Sketch",
+             doc->recovered ? " *" : "");
     DrawTextEx(gui->uiFont, label, (Vector2){tab.x + 30, tab.y + 9}, 12, 1.0f,
                tabText);
 
@@ -65,9 +68,8 @@ void GuiDrawHeader(GuiState *gui, Canvas *canvas, Theme t, Color iconIdle,
     if (GuiIconButton(gui, &gui->icons, tabClose, gui->icons.windowClose, false,
                       t.hover, t.hover, t.text, iconIdle, iconHover,
                       "Close tab")) {
-      bool showGrid = doc->canvas.showGrid;
-      GuiCloseDocument(gui, i, GetScreenWidth(), GetScreenHeight(), showGrid);
-      GuiToastSet(gui, "Closed.");
+      if (GuiRequestCloseDocument(gui, i))
+        GuiToastSet(gui, "Closed.");
       return;
     }
 
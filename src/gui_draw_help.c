@@ -104,6 +104,7 @@ void GuiDrawHelpPanel(GuiState *gui, const Canvas *canvas, Theme t, int sw,
 
   y = DrawSectionTitle(gui->uiFont, x, y, "Files", t);
   y = DrawShortcutRow(gui->uiFont, x, y, "Ctrl + S", "Save", t);
+  y = DrawShortcutRow(gui->uiFont, x, y, "Ctrl + Shift + S", "Save and compact", t);
   y = DrawShortcutRow(gui->uiFont, x, y, "Ctrl + O", "Open", t);
   y = DrawShortcutRow(gui->uiFont, x, y, "Ctrl + N", "New canvas", t);
   y = DrawShortcutRow(gui->uiFont, x, y, "Ctrl + W", "Close tab", t);
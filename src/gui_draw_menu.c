@@ -98,9 +98,13 @@ void GuiDrawMenu(GuiState *gui, Canvas *canvas, Theme t) {
                             itemH},
                "Clear canvas", NULL,
                t, false, NULL)) {
-    ClearCanvas(canvas);
-    GuiMarkNewDocument(gui);
-    GuiToastSet(gui, "Canvas cleared.");
+    if (GuiActiveDocumentLoading(gui)) {
+      GuiToastSet(gui, "Still opening.");
+    } else {
+      ClearCanvas(canvas);
+      GuiMarkNewDocument(gui);
+      GuiToastSet(gui, "Canvas cleared.");
+    }
     gui->showMenu = false;
   }
   y += itemH;
@@ -189,7 +193,7 @@ void GuiDrawMenu(GuiState *gui, Canvas *canvas, Theme t) {
 
   sw = GetScreenWidth();
   sh = GetScreenHeight();
-  const int exportItemCount = 3;
+  const int exportItemCount = 5;
   float exportW = 240.0f;
   float exportH = titleH + pad +
                   exportItemCount * itemH + pad;
@@ -351,6 +355,20 @@ void GuiDrawMenu(GuiState *gui, Canvas *canvas, Theme t) {
       gui->showExportMenu = false;
     }
     ey += itemH;
+    if (MenuItem(gui,
+                 (Rectangle){ex + pad,
+                              ey,
+                              exportW - pad * 2,
+                              itemH},
+                 "PNG (print size)", NULL,
+                 t, false, NULL)) {
+      GuiRequestExport(gui, canvas,
+                       EXPORT_FORMAT_PNG,
+                       EXPORT_SCOPE_CANVAS);
+      gui->showMenu = false;
+      gui->showExportMenu = false;
+    }
+    ey += itemH;
     if (MenuItem(gui,
                  (Rectangle){ex + pad,
                               ey,
@@ -378,6 +396,20 @@ void GuiDrawMenu(GuiState *gui, Canvas *canvas, Theme t) {
       gui->showMenu = false;
       gui->showExportMenu = false;
     }
+    ey += itemH;
+    if (MenuItem(gui,
+                 (Rectangle){ex + pad,
+                              ey,
+                              exportW - pad * 2,
+                              itemH},
+                 "PDF (print)", NULL,
+                 t, false, NULL)) {
+      GuiRequestExport(gui, canvas,
+                       EXPORT_FORMAT_PDF,
+                       EXPORT_SCOPE_CANVAS);
+      gui->showMenu = false;
+      gui->showExportMenu = false;
+    }
   }
 
   y += itemH;
@@ -0,0 +1,100 @@
+#include "gui_internal.h"
+#include <stdio.h>
+
+// The most sidecars listed by name on the recovery card.
+#define RECOVERY_LISTED 5
+
+static Rectangle DrawCard(GuiState *gui, Theme t, int sw, int sh, float cardH) {
+  Color overlay = ColorAlpha(BLACK, gui->darkMode ? 0.55f : 0.35f);
+  DrawRectangle(0, 0, sw, sh, overlay);
+
+  float cardW = (float)sw - 48.0f;
+  if (cardW > 460.0f)
+    cardW = 460.0f;
+  if (cardW < 320.0f)
+    cardW = 320.0f;
+  Rectangle card = {(float)sw / 2.0f - cardW / 2.0f,
+                    (float)sh / 2.0f - cardH / 2.0f, cardW, cardH};
+  DrawRectangleRounded(card, 0.05f, 8, t.surface);
+  DrawRectangleRoundedLinesEx(card, 0.05f, 8, 1.0f, t.border);
+  return card;
+}
+
+static float DrawLineText(Font font, float x, float y, const char *text,
+                          int fontSize, Color c) {
+  DrawTextEx(font, text, (Vector2){x, y}, (float)fontSize, 1.0f, c);
+  return y + (float)fontSize + 6.0f;
+}
+
+static const char *DocumentLabel(const char *path) {
+  return path[0] != '\0' ? GetFileName(path) : "Untitled Sketch";
+}
+
+void GuiDrawRecovery(GuiState *gui, Theme t, int sw, int sh) {
+  int count = GuiAutosavePendingCount();
+  int listed = count < RECOVERY_LISTED ? count : RECOVERY_LISTED;
+  float pad = 18.0f;
+  float btnH = 34.0f;
+  float cardH = pad * 2.0f + 26.0f + 18.0f * (float)(listed + 2) + 12.0f + btnH;
+  Rectangle card = DrawCard(gui, t, sw, sh, cardH);
+  float x = card.x + pad;
+  float y = card.y + pad;
+
+  char line[160];
+  y = DrawLineText(gui->uiFont, x, y, "Recover unsaved work?", 20, t.text);
+  snprintf(line, sizeof(line), "%d canvas%s had edits that were never saved:", count,
+           count == 1 ? "" : "es");
+  y = DrawLineText(gui->uiFont, x, y, line, 12, t.textDim);
+  for (int i = 0; i < listed; i++) {
+    snprintf(line, sizeof(line), "  %s", DocumentLabel(GuiAutosavePendingPath(i)));
+    y = DrawLineText(gui->uiFont, x, y, line, 12, t.text);
+  }
+  if (count > listed) {
+    snprintf(line, sizeof(line), "  and %d more", count - listed);
+    DrawLineText(gui->uiFont, x, y, line, 12, t.textDim);
+  }
+
+  Rectangle recoverBtn = {card.x + card.width - pad - 110.0f,
+                          card.y + card.height - pad - btnH, 110.0f, btnH};
+  Rectangle discardBtn = {recoverBtn.x - 10.0f - 110.0f, recoverBtn.y, 110.0f, btnH};
+  // Enter and Escape are handled in UpdateGui.
+  if (GuiTextButton(gui->uiFont, recoverBtn, "Recover", t, true))
+    GuiAutosaveRecover(gui, GetScreenWidth(), GetScreenHeight());
+  else if (GuiTextButton(gui->uiFont, discardBtn, "Discard", t, false))
+    GuiAutosaveDiscard(gui);
+}
+
+void GuiDrawCloseConfirm(GuiState *gui, Theme t, int sw, int sh) {
+  int index = gui->confirmCloseDocument;
+  if (index < 0 || index >= gui->documentCount) {
+    gui->confirmCloseDocument = -1;
+    return;
+  }
+  Document *doc = &gui->documents[index];
+  float pad = 18.0f;
+  float btnH = 34.0f;
+  Rectangle card = DrawCard(gui, t, sw, sh, pad * 2.0f + 26.0f + 18.0f * 2.0f + 12.0f + btnH);
+  float x = card.x + pad;
+  float y = card.y + pad;
+
+  char title[160];
+  snprintf(title, sizeof(title), "Close %s?", DocumentLabel(doc->hasPath ? doc->path : ""));
+  y = DrawLineText(gui->uiFont, x, y, title, 20, t.text);
+  y = DrawLineText(gui->uiFont, x, y,
+                   "It was recovered from an autosave and has not been saved.", 12,
+                   t.textDim);
+  DrawLineText(gui->uiFont, x, y, "Closing it discards the recovered drawing.", 12,
+               t.textDim);
+
+  Rectangle keepBtn = {card.x + card.width - pad - 110.0f,
+                       card.y + card.height - pad - btnH, 110.0f, btnH};
+  Rectangle discardBtn = {keepBtn.x - 10.0f - 110.0f, keepBtn.y, 110.0f, btnH};
+  if (GuiTextButton(gui->uiFont, keepBtn, "Keep open", t, true)) {
+    gui->confirmCloseDocument = -1;
+  } else if (GuiTextButton(gui->uiFont, discardBtn, "Discard", t, false)) {
+    gui->confirmCloseDocument = -1;
+    GuiCloseDocument(gui, index, GetScreenWidth(), GetScreenHeight(),
+                     doc->canvas.showGrid);
+    GuiToastSet(gui, "Recovered canvas discarded.");
+  }
+}
@@ -75,13 +75,15 @@ void GuiDrawToolbar(GuiState *gui, Canvas *canvas, Theme t, Color iconIdle,
 
     Rectangle undoBtn = {tx, btnY, btnS, btnS};
     if (GuiIconButton(gui, &gui->icons, undoBtn, gui->icons.undo, false, t.hover,
-                      t.hover, t.text, iconIdle, iconHover, "Undo"))
+                      t.hover, t.text, iconIdle, iconHover, "Undo") &&
+        !GuiActiveDocumentLoading(gui))
         Undo(canvas);
     tx += btnS;
 
     Rectangle redoBtn = {tx, btnY, btnS, btnS};
     if (GuiIconButton(gui, &gui->icons, redoBtn, gui->icons.redo, false, t.hover,
-                      t.hover, t.text, iconIdle, iconHover, "Redo"))
+                      t.hover, t.text, iconIdle, iconHover, "Redo") &&
+        !GuiActiveDocumentLoading(gui))
         Redo(canvas);
     tx += btnS + gap;
     Divider(tx, dividerY, dividerH, t.border);
@@ -1,7 +1,7 @@
 #include "gui_internal.h"
 
-static bool TextButton(Font font, Rectangle r, const char *label, Theme t,
-                       bool primary) {
+bool GuiTextButton(Font font, Rectangle r, const char *label, Theme t,
+                   bool primary) {
   Vector2 mouse = GetMousePosition();
   bool hover = CheckCollisionPointRec(mouse, r);
 
@@ -85,7 +85,7 @@ void GuiDrawWelcome(GuiState *gui, Canvas *canvas, Theme t, int sw, int sh) {
   Rectangle primaryBtn = {card.x + card.width - pad - 130.0f,
                           card.y + card.height - pad - btnH, 130.0f, btnH};
 
-  if (TextButton(gui->uiFont, primaryBtn, "Let's draw", t, true) ||
+  if (GuiTextButton(gui->uiFont, primaryBtn, "Let's draw", t, true) ||
       IsKeyPressed(KEY_ENTER) || IsKeyPressed(KEY_ESCAPE)) {
     gui->showWelcome = false;
     gui->hasSeenWelcome = true;
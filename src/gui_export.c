@@ -0,0 +1,351 @@
+#include "export_png.h"
+#include "gui_internal.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EXPORT_TILE_MAX 1024
+// Bands read back ahead of the encoder; this bounds the pixels held.
+#define EXPORT_BANDS_IN_FLIGHT 2
+// Main-thread time per frame spent drawing tiles, in seconds.
+#define EXPORT_FRAME_BUDGET 0.008
+
+typedef enum { BAND_FREE = 0, BAND_READY } BandState;
+
+// One row of tiles as read back, bottom row first like every render texture.
+typedef struct {
+  Image *tiles;
+  BandState state;
+} ExportBand;
+
+// One export runs at a time, from a snapshot of the document so editing can
+// go on. The main thread fills band slots in order and the worker drains
+// them in the same order; only the worker touches the output file.
+static struct {
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  Canvas *snapshot;
+  ExportPlan plan;
+  char path[512];
+  RenderTexture2D target;
+  int tileW;
+  int tileH;
+  int cols;
+  int bandCount;
+  ExportBand bands[EXPORT_BANDS_IN_FLIGHT];
+  int renderBand; // next band to draw
+  int renderCol;  // next tile within it
+  int rowsWritten;
+  bool cancel;
+  bool ok;
+  int done;
+  bool running;
+} gExport;
+
+// Vector formats are written by the worker alone; rasters need tiles drawn.
+static bool IsRaster(ExportFormat format) {
+  return format == EXPORT_FORMAT_PNG || format == EXPORT_FORMAT_JPG;
+}
+
+static int BandRows(int band) {
+  int rows = gExport.plan.height - band * gExport.tileH;
+  return rows < gExport.tileH ? rows : gExport.tileH;
+}
+
+static int TileCols(int col) {
+  int cols = gExport.plan.width - col * gExport.tileW;
+  return cols < gExport.tileW ? cols : gExport.tileW;
+}
+
+// Waits for the next band; false once the export is cancelled.
+static ExportBand *TakeBand(int band) {
+  ExportBand *b = &gExport.bands[band % EXPORT_BANDS_IN_FLIGHT];
+  pthread_mutex_lock(&gExport.lock);
+  while (b->state != BAND_READY && !gExport.cancel)
+    pthread_cond_wait(&gExport.wake, &gExport.lock);
+  bool ready = b->state == BAND_READY && !gExport.cancel;
+  pthread_mutex_unlock(&gExport.lock);
+  return ready ? b : NULL;
+}
+
+static void ReleaseBand(ExportBand *b) {
+  for (int c = 0; c < gExport.cols; c++) {
+    UnloadImage(b->tiles[c]);
+    b->tiles[c] = (Image){0};
+  }
+  pthread_mutex_lock(&gExport.lock);
+  b->state = BAND_FREE;
+  pthread_mutex_unlock(&gExport.lock);
+}
+
+// Flips and stitches row `r` of a band into `out`.
+static void BandRow(ExportBand *b, int r, uint8_t *out) {
+  for (int c = 0; c < gExport.cols; c++) {
+    Image *tile = &b->tiles[c];
+    const uint8_t *pixels = (const uint8_t *)tile->data;
+    memcpy(out + (size_t)c * (size_t)gExport.tileW * 4,
+           pixels + (size_t)tile->width * 4 * (size_t)(tile->height - 1 - r),
+           (size_t)TileCols(c) * 4);
+  }
+}
+
+static bool EncodeRaster(void) {
+  const ExportPlan *plan = &gExport.plan;
+  size_t stride = (size_t)plan->width * 4;
+  PngWriter *png = NULL;
+  uint8_t *row = NULL;
+  // JPG goes through raylib, which needs the whole image at once.
+  Image full = {0};
+  if (plan->format == EXPORT_FORMAT_PNG) {
+    png = PngWriterOpen(gExport.path, plan->width, plan->height, plan->dpi);
+    row = (uint8_t *)malloc(stride);
+    if (!png || !row) {
+      PngWriterClose(png);
+      free(row);
+      return false;
+    }
+  } else {
+    full.data = malloc(stride * (size_t)plan->height);
+    if (!full.data)
+      return false;
+    full.width = plan->width;
+    full.height = plan->height;
+    full.mipmaps = 1;
+    full.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+  }
+
+  bool ok = true;
+  for (int band = 0; band < gExport.bandCount; band++) {
+    ExportBand *b = TakeBand(band);
+    if (!b) {
+      ok = false;
+      break;
+    }
+    for (int c = 0; c < gExport.cols; c++) {
+      if (b->tiles[c].format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+        ImageFormat(&b->tiles[c], PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    }
+    int rows = BandRows(band);
+    for (int r = 0; r < rows; r++) {
+      if (png) {
+        BandRow(b, r, row);
+        PngWriterRow(png, row);
+      } else {
+        size_t y = (size_t)band * (size_t)gExport.tileH + (size_t)r;
+        BandRow(b, r, (uint8_t *)full.data + stride * y);
+      }
+    }
+    ReleaseBand(b);
+    __atomic_add_fetch(&gExport.rowsWritten, rows, __ATOMIC_RELAXED);
+  }
+
+  if (png) {
+    ok = PngWriterClose(png) && ok;
+    free(row);
+  } else {
+    ok = ok && ExportImage(full, gExport.path);
+    UnloadImage(full);
+  }
+  return ok;
+}
+
+static void *ExportThreadMain(void *arg) {
+  (void)arg;
+  if (gExport.plan.format == EXPORT_FORMAT_SVG)
+    gExport.ok = ExportSvgFile(gExport.snapshot, &gExport.plan.svg, gExport.path);
+  else if (gExport.plan.format == EXPORT_FORMAT_PDF)
+    gExport.ok = ExportPdfFile(gExport.snapshot, &gExport.plan.svg, &gExport.plan.pdf,
+                               gExport.path);
+  else
+    gExport.ok = EncodeRaster();
+  if (!gExport.ok)
+    remove(gExport.path);
+  __atomic_store_n(&gExport.done, 1, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+static void FreeBands(void) {
+  for (int i = 0; i < EXPORT_BANDS_IN_FLIGHT; i++) {
+    ExportBand *b = &gExport.bands[i];
+    for (int c = 0; b->tiles && c < gExport.cols; c++)
+      UnloadImage(b->tiles[c]);
+    free(b->tiles);
+    b->tiles = NULL;
+    b->state = BAND_FREE;
+  }
+}
+
+// Tiles are no larger than the window, whose size the grid drawing assumes.
+static bool SetUpRaster(void) {
+  const ExportPlan *plan = &gExport.plan;
+  gExport.tileW = GetScreenWidth();
+  gExport.tileH = GetScreenHeight();
+  if (gExport.tileW > EXPORT_TILE_MAX)
+    gExport.tileW = EXPORT_TILE_MAX;
+  if (gExport.tileH > EXPORT_TILE_MAX)
+    gExport.tileH = EXPORT_TILE_MAX;
+  if (gExport.tileW > plan->width)
+    gExport.tileW = plan->width;
+  if (gExport.tileH > plan->height)
+    gExport.tileH = plan->height;
+  if (gExport.tileW <= 0 || gExport.tileH <= 0)
+    return false;
+  gExport.cols = (plan->width + gExport.tileW - 1) / gExport.tileW;
+  gExport.bandCount = (plan->height + gExport.tileH - 1) / gExport.tileH;
+
+  for (int i = 0; i < EXPORT_BANDS_IN_FLIGHT; i++) {
+    gExport.bands[i].tiles = (Image *)calloc((size_t)gExport.cols, sizeof(Image));
+    if (!gExport.bands[i].tiles) {
+      FreeBands();
+      return false;
+    }
+  }
+  gExport.target = LoadRenderTexture(gExport.tileW, gExport.tileH);
+  if (gExport.target.texture.id == 0) {
+    FreeBands();
+    return false;
+  }
+  return true;
+}
+
+bool GuiExportStart(Canvas *canvas, const ExportPlan *plan, const char *path) {
+  if (gExport.running || !canvas || !plan || !path)
+    return false;
+  if (IsRaster(plan->format) && (plan->width <= 0 || plan->height <= 0))
+    return false;
+  // Placeholders of a chunked file are read first, as for a full save.
+  if (!CanvasEnsureLoaded(canvas))
+    return false;
+  gExport.snapshot = CanvasSnapshotCreate(canvas, true);
+  if (!gExport.snapshot)
+    return false;
+  gExport.snapshot->camera = plan->camera;
+  gExport.plan = *plan;
+  snprintf(gExport.path, sizeof(gExport.path), "%s", path);
+  gExport.renderBand = 0;
+  gExport.renderCol = 0;
+  gExport.rowsWritten = 0;
+  gExport.cancel = false;
+  gExport.ok = false;
+  gExport.done = 0;
+  gExport.target = (RenderTexture2D){0};
+
+  bool raster = IsRaster(plan->format);
+  if (raster && !SetUpRaster()) {
+    CanvasSnapshotFree(gExport.snapshot);
+    gExport.snapshot = NULL;
+    return false;
+  }
+  pthread_mutex_init(&gExport.lock, NULL);
+  pthread_cond_init(&gExport.wake, NULL);
+  if (pthread_create(&gExport.thread, NULL, ExportThreadMain, NULL) != 0) {
+    pthread_cond_destroy(&gExport.wake);
+    pthread_mutex_destroy(&gExport.lock);
+    if (raster) {
+      UnloadRenderTexture(gExport.target);
+      FreeBands();
+    }
+    CanvasSnapshotFree(gExport.snapshot);
+    gExport.snapshot = NULL;
+    return false;
+  }
+  gExport.running = true;
+  return true;
+}
+
+bool GuiExportBusy(void) { return gExport.running; }
+
+bool GuiExportProgress(float *progress) {
+  if (!gExport.running)
+    return false;
+  if (progress) {
+    int rows = __atomic_load_n(&gExport.rowsWritten, __ATOMIC_RELAXED);
+    *progress = IsRaster(gExport.plan.format)
+                    ? (float)rows / (float)gExport.plan.height
+                    : 0.0f;
+  }
+  return true;
+}
+
+// Draws and reads back tiles into free band slots until the frame's budget
+// is spent. The readback is all the GL work; the worker does the rest.
+static void DrawTiles(void) {
+  double start = GetTime();
+  while (gExport.renderBand < gExport.bandCount) {
+    ExportBand *b = &gExport.bands[gExport.renderBand % EXPORT_BANDS_IN_FLIGHT];
+    pthread_mutex_lock(&gExport.lock);
+    BandState state = b->state;
+    pthread_mutex_unlock(&gExport.lock);
+    if (state != BAND_FREE)
+      return;
+
+    Canvas *snapshot = gExport.snapshot;
+    Vector2 offset = gExport.plan.camera.offset;
+    snapshot->camera.offset =
+        (Vector2){offset.x - (float)(gExport.renderCol * gExport.tileW),
+                  offset.y - (float)(gExport.renderBand * gExport.tileH)};
+    BeginTextureMode(gExport.target);
+    DrawCanvas(snapshot);
+    EndTextureMode();
+    b->tiles[gExport.renderCol] = LoadImageFromTexture(gExport.target.texture);
+
+    if (++gExport.renderCol == gExport.cols) {
+      gExport.renderCol = 0;
+      gExport.renderBand++;
+      pthread_mutex_lock(&gExport.lock);
+      b->state = BAND_READY;
+      pthread_cond_signal(&gExport.wake);
+      pthread_mutex_unlock(&gExport.lock);
+    }
+    if (GetTime() - start > EXPORT_FRAME_BUDGET)
+      return;
+  }
+}
+
+static void Finish(void) {
+  pthread_join(gExport.thread, NULL);
+  pthread_cond_destroy(&gExport.wake);
+  pthread_mutex_destroy(&gExport.lock);
+  if (IsRaster(gExport.plan.format)) {
+    UnloadRenderTexture(gExport.target);
+    FreeBands();
+  }
+  CanvasSnapshotFree(gExport.snapshot);
+  gExport.snapshot = NULL;
+  gExport.running = false;
+}
+
+void GuiExportUpdate(GuiState *gui) {
+  if (!gExport.running)
+    return;
+  bool done = __atomic_load_n(&gExport.done, __ATOMIC_ACQUIRE) != 0;
+  if (!done) {
+    if (IsRaster(gExport.plan.format))
+      DrawTiles();
+    return;
+  }
+
+  Finish();
+  const char *label = (gExport.plan.format == EXPORT_FORMAT_SVG)   ? "SVG"
+                      : (gExport.plan.format == EXPORT_FORMAT_PDF) ? "PDF"
+                      : (gExport.plan.format == EXPORT_FORMAT_JPG) ? "JPG"
+                                                                   : "PNG";
+  char msg[64];
+  if (gExport.ok)
+    snprintf(msg, sizeof(msg), "Exported %s.", label);
+  else
+    snprintf(msg, sizeof(msg), "Export failed.");
+  GuiToastSet(gui, msg);
+}
+
+void GuiExportStop(void) {
+  if (!gExport.running)
+    return;
+  pthread_mutex_lock(&gExport.lock);
+  gExport.cancel = true;
+  pthread_cond_signal(&gExport.wake);
+  pthread_mutex_unlock(&gExport.lock);
+  Finish();
+}
@@ -1,3 +1,4 @@
+#include "export.h"
 #include "gui_internal.h"
 #include "nfd.h"
 #include "raymath.h"
@@ -154,7 +155,9 @@ static void EnsureExportExtension(char *path, size_t size, ExportFormat format)
     return;
   }
 
-  const char *ext = (format == EXPORT_FORMAT_SVG) ? ".svg" : ".png";
+  const char *ext = (format == EXPORT_FORMAT_SVG)   ? ".svg"
+                    : (format == EXPORT_FORMAT_PDF) ? ".pdf"
+                                                    : ".png";
   if (EndsWithExt(path, ext))
     return;
   if (strlen(path) + strlen(ext) + 1 >= size)
@@ -170,7 +173,9 @@ static void BuildDefaultExportPath(char *out, size_t size, const char *name,
   const char *base = (name && name[0] != '\0') ? name : "drawing";
   const char *ext = (format == EXPORT_FORMAT_SVG)
                         ? ".svg"
-                        : (format == EXPORT_FORMAT_JPG) ? ".jpg" : ".png";
+                        : (format == EXPORT_FORMAT_PDF)
+                              ? ".pdf"
+                              : (format == EXPORT_FORMAT_JPG) ? ".jpg" : ".png";
 
   char filename[256];
   snprintf(filename, sizeof(filename), "%s%s", base, ext);
@@ -199,219 +204,47 @@ static Rectangle GetCameraViewRect(const Camera2D *camera, int sw, int sh) {
   return (Rectangle){minX, minY, maxX - minX, maxY - minY};
 }
 
-static bool CanvasStrokeBounds(const Canvas *canvas, Rectangle *out) {
-  if (!canvas || !out)
-    return false;
-  bool hasAny = false;
-  float minX = 0.0f, minY = 0.0f, maxX = 0.0f, maxY = 0.0f;
-  for (int i = 0; i < canvas->strokeCount; i++) {
-    const Stroke *s = &canvas->strokes[i];
-    float radius = fmaxf(1.0f, s->thickness) * 0.5f;
-    for (int p = 0; p < s->pointCount; p++) {
-      float x = s->points[p].x;
-      float y = s->points[p].y;
-      if (!hasAny) {
-        minX = x - radius;
-        maxX = x + radius;
-        minY = y - radius;
-        maxY = y + radius;
-        hasAny = true;
-      } else {
-        minX = fminf(minX, x - radius);
-        maxX = fmaxf(maxX, x + radius);
-        minY = fminf(minY, y - radius);
-        maxY = fmaxf(maxY, y + radius);
-      }
-    }
-  }
-  if (!hasAny)
-    return false;
-  out->x = minX;
-  out->y = minY;
-  out->width = maxX - minX;
-  out->height = maxY - minY;
-  return true;
-}
-
-static float GridSpacingForZoom(float zoom) {
-  float spacing = 40.0f;
-  if (zoom > 2.0f)
-    spacing *= 0.5f;
-  if (zoom < 0.5f)
-    spacing *= 2.0f;
-  if (zoom < 0.25f)
-    spacing *= 4.0f;
-  return spacing;
-}
-
-static void ColorToHex(Color c, char *out, size_t size) {
-  snprintf(out, size, "#%02X%02X%02X", c.r, c.g, c.b);
-}
-
-static bool StrokeLooksLikeArrow(const Stroke *s) {
-  if (!s || s->pointCount != 5)
-    return false;
-  Point tip = s->points[1];
-  Point last = s->points[4];
-  float dx = tip.x - last.x;
-  float dy = tip.y - last.y;
-  return (dx * dx + dy * dy) <= 0.0001f;
-}
-
-static float CatmullRom(float p0, float p1, float p2, float p3, float t) {
-  float t2 = t * t;
-  float t3 = t2 * t;
-  return 0.5f * ((2.0f * p1) + (-p0 + p2) * t +
-                 (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
-                 (-p0 + 3.0f * p1 - 3.0f * p2 + p3) * t3);
-}
-
-static int BuildSmoothedPoints(const Stroke *s, Vector2 **outPts) {
-  if (!s || !outPts || s->pointCount < 2)
-    return 0;
-  const int samplesPerSegment = 7;
-  int segments = s->pointCount - 1;
-  int outCount = segments * samplesPerSegment + 1;
-  Vector2 *pts = (Vector2 *)malloc(sizeof(Vector2) * (size_t)outCount);
-  if (!pts)
-    return 0;
-
-  int index = 0;
-  for (int i = 0; i < segments; i++) {
-    int i0 = (i == 0) ? 0 : i - 1;
-    int i1 = i;
-    int i2 = i + 1;
-    int i3 = (i + 2 < s->pointCount) ? i + 2 : s->pointCount - 1;
-
-    Point p0 = s->points[i0];
-    Point p1 = s->points[i1];
-    Point p2 = s->points[i2];
-    Point p3 = s->points[i3];
-
-    for (int j = 0; j < samplesPerSegment; j++) {
-      float t = (float)j / (float)samplesPerSegment;
-      pts[index].x = CatmullRom(p0.x, p1.x, p2.x, p3.x, t);
-      pts[index].y = CatmullRom(p0.y, p1.y, p2.y, p3.y, t);
-      index++;
-    }
-  }
-
-  Point last = s->points[s->pointCount - 1];
-  pts[index++] = (Vector2){last.x, last.y};
-  *outPts = pts;
-  return index;
-}
-
-static int CollectStrokePoints(const Stroke *s, Vector2 **outPts) {
-  if (!s || !outPts || s->pointCount < 2)
-    return 0;
-  bool smooth = s->usePressure || s->pointCount > 12;
-  if (smooth)
-    return BuildSmoothedPoints(s, outPts);
-
-  Vector2 *pts = (Vector2 *)malloc(sizeof(Vector2) * (size_t)s->pointCount);
-  if (!pts)
-    return 0;
-  for (int i = 0; i < s->pointCount; i++)
-    pts[i] = (Vector2){s->points[i].x, s->points[i].y};
-  *outPts = pts;
-  return s->pointCount;
-}
-
-static void SvgWriteLine(FILE *f, float x1, float y1, float x2, float y2,
-                         Color c, float thickness) {
-  char hex[16];
-  ColorToHex(c, hex, sizeof(hex));
-  fprintf(f,
-          "<line x1=\"%.2f\" y1=\"%.2f\" x2=\"%.2f\" y2=\"%.2f\" "
-          "stroke=\"%s\" stroke-width=\"%.2f\" stroke-linecap=\"round\"",
-          x1, y1, x2, y2, hex, thickness);
-  if (c.a < 255)
-    fprintf(f, " stroke-opacity=\"%.3f\"", (float)c.a / 255.0f);
-  fprintf(f, " />\n");
-}
-
-static void SvgWritePolygon(FILE *f, Vector2 a, Vector2 b, Vector2 c, Color col) {
-  char hex[16];
-  ColorToHex(col, hex, sizeof(hex));
-  fprintf(f,
-          "<polygon points=\"%.2f,%.2f %.2f,%.2f %.2f,%.2f\" fill=\"%s\"",
-          a.x, a.y, b.x, b.y, c.x, c.y, hex);
-  if (col.a < 255)
-    fprintf(f, " fill-opacity=\"%.3f\"", (float)col.a / 255.0f);
-  fprintf(f, " />\n");
-}
-
-static void SvgWritePolyline(FILE *f, const Vector2 *pts, int count, Color col,
-                             float thickness) {
-  if (!f || !pts || count < 2)
-    return;
-  char hex[16];
-  ColorToHex(col, hex, sizeof(hex));
-  fprintf(f,
-          "<polyline fill=\"none\" stroke=\"%s\" stroke-width=\"%.2f\" "
-          "stroke-linecap=\"round\" stroke-linejoin=\"round\"",
-          hex, thickness);
-  if (col.a < 255)
-    fprintf(f, " stroke-opacity=\"%.3f\"", (float)col.a / 255.0f);
-  fprintf(f, " points=\"");
-  for (int i = 0; i < count; i++) {
-    fprintf(f, "%.2f,%.2f", pts[i].x, pts[i].y);
-    if (i + 1 < count)
-      fprintf(f, " ");
-  }
-  fprintf(f, "\" />\n");
-}
-
-static void SvgWriteGrid(FILE *f, Rectangle view, Color grid, float zoom) {
-  float spacing = GridSpacingForZoom(zoom);
-  if (spacing <= 0.0f)
-    return;
-
-  int startCol = (int)floorf(view.x / spacing);
-  int endCol = (int)ceilf((view.x + view.width) / spacing);
-  int startRow = (int)floorf(view.y / spacing);
-  int endRow = (int)ceilf((view.y + view.height) / spacing);
-
-  int maxLines = 2000;
-  int cols = endCol - startCol + 1;
-  int rows = endRow - startRow + 1;
-  while (cols > maxLines || rows > maxLines) {
-    spacing *= 2.0f;
-    startCol = (int)floorf(view.x / spacing);
-    endCol = (int)ceilf((view.x + view.width) / spacing);
-    startRow = (int)floorf(view.y / spacing);
-    endRow = (int)ceilf((view.y + view.height) / spacing);
-    cols = endCol - startCol + 1;
-    rows = endRow - startRow + 1;
-  }
-
-  char hex[16];
-  ColorToHex(grid, hex, sizeof(hex));
-  fprintf(f, "<g stroke=\"%s\" stroke-width=\"1\"", hex);
-  if (grid.a < 255)
-    fprintf(f, " stroke-opacity=\"%.3f\"", (float)grid.a / 255.0f);
-  fprintf(f, ">\n");
-
-  for (int i = startCol; i <= endCol; i++) {
-    float x = (float)i * spacing;
-    fprintf(f, "<line x1=\"%.2f\" y1=\"%.2f\" x2=\"%.2f\" y2=\"%.2f\" />\n",
-            x, view.y, x, view.y + view.height);
-  }
-  for (int i = startRow; i <= endRow; i++) {
-    float y = (float)i * spacing;
-    fprintf(f, "<line x1=\"%.2f\" y1=\"%.2f\" x2=\"%.2f\" y2=\"%.2f\" />\n",
-            view.x, y, view.x + view.width, y);
-  }
-
-  fprintf(f, "</g>\n");
-}
-
-static bool ExportCanvasRaster(const Canvas *canvas, ExportScope scope,
-                               ExportFormat format, const char *path) {
-  if (!canvas || !path)
-    return false;
-
+// Canvas units count as pixels at this density.
+#define EXPORT_BASE_DPI 96.0f
+#define EXPORT_MAX_PIXELS 65535
+
+// Size of a print-size export of `bw` x `bh` canvas units: the exact pixel
+// size when both are set, fitting the drawing inside; one set pixel size
+// with the other following the drawing; otherwise the drawing at the DPI.
+// Returns the zoom that fits.
+static float PrintExportSize(const GuiState *gui, float bw, float bh, int *width,
+                             int *height) {
+  float zoom = gui->exportDpi / EXPORT_BASE_DPI;
+  if (gui->exportWidth > 0 && gui->exportHeight > 0)
+    zoom = fminf((float)gui->exportWidth / bw, (float)gui->exportHeight / bh);
+  else if (gui->exportWidth > 0)
+    zoom = (float)gui->exportWidth / bw;
+  else if (gui->exportHeight > 0)
+    zoom = (float)gui->exportHeight / bh;
+  if (!(zoom > 0.0f))
+    zoom = 1.0f;
+  // Past the PNG size limit the whole drawing shrinks to fit.
+  float over = fmaxf(bw * zoom, bh * zoom) / (float)EXPORT_MAX_PIXELS;
+  if (over > 1.0f)
+    zoom /= over;
+
+  *width = (gui->exportWidth > 0 && gui->exportHeight > 0) ? gui->exportWidth
+                                                           : (int)ceilf(bw * zoom);
+  *height = (gui->exportWidth > 0 && gui->exportHeight > 0) ? gui->exportHeight
+                                                            : (int)ceilf(bh * zoom);
+  if (*width < 1)
+    *width = 1;
+  if (*height < 1)
+    *height = 1;
+  if (*width > EXPORT_MAX_PIXELS)
+    *width = EXPORT_MAX_PIXELS;
+  if (*height > EXPORT_MAX_PIXELS)
+    *height = EXPORT_MAX_PIXELS;
+  return zoom;
+}
+
+static bool PlanRasterExport(const GuiState *gui, Canvas *canvas,
+                             ExportScope scope, ExportPlan *plan) {
   int sw = GetScreenWidth();
   int sh = GetScreenHeight();
   if (sw <= 0 || sh <= 0)
@@ -419,6 +252,7 @@ static bool ExportCanvasRaster(const Canvas *canvas, ExportScope scope,
 
   int targetW = sw;
   int targetH = sh;
+  float dpi = 0.0f;
   Camera2D cam = canvas->camera;
   if (scope == EXPORT_SCOPE_VIEW_FHD) {
     targetW = 1920;
@@ -435,49 +269,29 @@ static bool ExportCanvasRaster(const Canvas *canvas, ExportScope scope,
   }
   if (scope == EXPORT_SCOPE_CANVAS) {
     Rectangle bounds;
-    if (CanvasStrokeBounds(canvas, &bounds)) {
-      float pad = 24.0f;
-      float bw = fmaxf(bounds.width + pad * 2.0f, 1.0f);
-      float bh = fmaxf(bounds.height + pad * 2.0f, 1.0f);
-      float zoomX = (float)targetW / bw;
-      float zoomY = (float)targetH / bh;
-      float zoom = fminf(zoomX, zoomY);
-      cam.target = (Vector2){bounds.x + bounds.width * 0.5f,
-                             bounds.y + bounds.height * 0.5f};
-      cam.offset = (Vector2){(float)targetW / 2.0f, (float)targetH / 2.0f};
-      cam.zoom = (zoom > 0.0f) ? zoom : 1.0f;
-      cam.rotation = 0.0f;
-    }
+    if (!CanvasStrokeBounds(canvas, &bounds))
+      bounds = GetCameraViewRect(&canvas->camera, sw, sh);
+    float pad = 24.0f;
+    float bw = fmaxf(bounds.width + pad * 2.0f, 1.0f);
+    float bh = fmaxf(bounds.height + pad * 2.0f, 1.0f);
+    float zoom = PrintExportSize(gui, bw, bh, &targetW, &targetH);
+    cam.target = (Vector2){bounds.x + bounds.width * 0.5f,
+                           bounds.y + bounds.height * 0.5f};
+    cam.offset = (Vector2){(float)targetW / 2.0f, (float)targetH / 2.0f};
+    cam.zoom = zoom;
+    cam.rotation = 0.0f;
+    dpi = gui->exportDpi;
   }
 
-  Canvas temp = *canvas;
-  temp.camera = cam;
-  temp.selectedStrokeIndex = -1;
-  temp.isDrawing = false;
-
-  RenderTexture2D target = LoadRenderTexture(targetW, targetH);
-  if (target.texture.id == 0)
-    return false;
-
-  BeginTextureMode(target);
-  DrawCanvas(&temp);
-  EndTextureMode();
-
-  Image img = LoadImageFromTexture(target.texture);
-  ImageFlipVertical(&img);
-  UnloadRenderTexture(target);
-
-  bool ok = ExportImage(img, path);
-  UnloadImage(img);
-  (void)format;
-  return ok;
+  plan->camera = cam;
+  plan->width = targetW;
+  plan->height = targetH;
+  plan->dpi = dpi;
+  return true;
 }
 
-static bool ExportCanvasSvg(const Canvas *canvas, ExportScope scope,
-                            const char *path) {
-  if (!canvas || !path)
-    return false;
-
+static bool PlanSvgExport(Canvas *canvas, ExportScope scope,
+                          ExportPlan *plan) {
   int sw = GetScreenWidth();
   int sh = GetScreenHeight();
   Rectangle view = {0, 0, (float)sw, (float)sh};
@@ -526,79 +340,7 @@ static bool ExportCanvasSvg(const Canvas *canvas, ExportScope scope,
     }
   }
 
-  if (view.width <= 0.0f)
-    view.width = 1.0f;
-  if (view.height <= 0.0f)
-    view.height = 1.0f;
-
-  FILE *f = fopen(path, "wb");
-  if (!f)
-    return false;
-
-  fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
-  fprintf(f,
-          "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%.2f\" "
-          "height=\"%.2f\" viewBox=\"%.2f %.2f %.2f %.2f\">\n",
-          outW, outH, view.x, view.y, view.width, view.height);
-
-  char bgHex[16];
-  ColorToHex(canvas->backgroundColor, bgHex, sizeof(bgHex));
-  fprintf(f,
-          "<rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" "
-          "fill=\"%s\"",
-          view.x, view.y, view.width, view.height, bgHex);
-  if (canvas->backgroundColor.a < 255)
-    fprintf(f, " fill-opacity=\"%.3f\"",
-            (float)canvas->backgroundColor.a / 255.0f);
-  fprintf(f, " />\n");
-
-  if (canvas->showGrid)
-    SvgWriteGrid(f, view, canvas->gridColor, zoom);
-
-  for (int i = 0; i < canvas->strokeCount; i++) {
-    const Stroke *s = &canvas->strokes[i];
-    if (s->pointCount < 2)
-      continue;
-
-    if (StrokeLooksLikeArrow(s)) {
-      Vector2 start = {s->points[0].x, s->points[0].y};
-      Vector2 tip = {s->points[1].x, s->points[1].y};
-      Vector2 st = Vector2Subtract(tip, start);
-      float len = Vector2Length(st);
-      if (len <= 0.0001f) {
-        SvgWriteLine(f, start.x, start.y, tip.x, tip.y, s->color, s->thickness);
-        continue;
-      }
-
-      Vector2 dir = Vector2Scale(st, 1.0f / len);
-      Vector2 perp = (Vector2){-dir.y, dir.x};
-
-      float headLen = fmaxf(16.0f, s->thickness * 4.0f);
-      headLen = fminf(headLen, len * 0.5f);
-      float headW = fmaxf(s->thickness * 3.0f, headLen * 1.10f);
-
-      Vector2 base = Vector2Subtract(tip, Vector2Scale(dir, headLen));
-      Vector2 left = Vector2Add(base, Vector2Scale(perp, headW * 0.5f));
-      Vector2 right = Vector2Subtract(base, Vector2Scale(perp, headW * 0.5f));
-
-      Vector2 shaftEnd = Vector2Add(base, Vector2Scale(dir, s->thickness * 0.25f));
-      SvgWriteLine(f, start.x, start.y, shaftEnd.x, shaftEnd.y, s->color,
-                   s->thickness);
-      SvgWritePolygon(f, tip, left, right, s->color);
-      continue;
-    }
-
-    Vector2 *pts = NULL;
-    int count = CollectStrokePoints(s, &pts);
-    if (count >= 2) {
-      float thickness = (s->thickness > 0.0f) ? s->thickness : 1.0f;
-      SvgWritePolyline(f, pts, count, s->color, thickness);
-    }
-    free(pts);
-  }
-
-  fprintf(f, "</svg>\n");
-  fclose(f);
+  plan->svg = (ExportView){view, outW, outH, zoom};
   return true;
 }
 
@@ -618,6 +360,10 @@ void GuiRequestOpen(GuiState *gui) {
     GuiToastSet(gui, "No GUI session for file dialogs.");
     return;
   }
+  if (GuiOpenBusy()) {
+    GuiToastSet(gui, "Still opening a file.");
+    return;
+  }
 
   char defaultPath[512];
   BuildDefaultDir(defaultPath, sizeof(defaultPath), gui->lastDir);
@@ -637,13 +383,21 @@ void GuiRequestOpen(GuiState *gui) {
       return;
     }
 
+    UpdateLastDir(gui, path);
+    UpdateLastFileName(gui, path);
+    // GuiOpenUpdate shows the strokes as they are read and finishes the open.
+    if (GuiOpenStart(doc, path)) {
+      GuiToastSet(gui, "Opening...");
+      free(path);
+      return;
+    }
+
     bool ok = LoadCanvasFromFile(&doc->canvas, path);
     GuiToastSet(gui, ok ? "Loaded." : "Load failed.");
     if (ok) {
       CopyPath(doc->path, sizeof(doc->path), path);
       doc->hasPath = true;
-      UpdateLastDir(gui, path);
-      UpdateLastFileName(gui, path);
+      doc->autosavedEdits = doc->canvas.editCount;
       free(path);
       return;
     }
@@ -668,11 +422,16 @@ void GuiRequestSave(GuiState *gui, Document *doc) {
     GuiToastSet(gui, "No document.");
     return;
   }
+  if (doc->loading) {
+    GuiToastSet(gui, "Still opening.");
+    return;
+  }
 
   if (doc->hasPath && doc->path[0] != '\0') {
     bool ok = SaveCanvasToFile(&doc->canvas, doc->path);
     GuiToastSet(gui, ok ? "Saved." : "Save failed.");
     if (ok) {
+      GuiAutosaveForget(doc);
       UpdateLastDir(gui, doc->path);
       UpdateLastFileName(gui, doc->path);
     }
@@ -700,6 +459,7 @@ void GuiRequestSave(GuiState *gui, Document *doc) {
     if (ok) {
       CopyPath(doc->path, sizeof(doc->path), resolved);
       doc->hasPath = true;
+      GuiAutosaveForget(doc);
       UpdateLastDir(gui, resolved);
       UpdateLastFileName(gui, resolved);
     }
@@ -711,7 +471,22 @@ void GuiRequestSave(GuiState *gui, Document *doc) {
     ShowDialogError(gui, "Save failed");
 }
 
-void GuiRequestExport(GuiState *gui, const Canvas *canvas, ExportFormat format,
+// Rewrites the document in full, dropping the edit journal that plain saves
+// append to the file.
+void GuiRequestCompactSave(GuiState *gui, Document *doc) {
+  if (!doc || !doc->hasPath || doc->path[0] == '\0') {
+    GuiRequestSave(gui, doc);
+    return;
+  }
+  gui->showMenu = false;
+  gui->showColorPicker = false;
+  bool ok = CompactCanvasFile(&doc->canvas, doc->path);
+  GuiToastSet(gui, ok ? "Saved and compacted." : "Save failed.");
+  if (ok)
+    GuiAutosaveForget(doc);
+}
+
+void GuiRequestExport(GuiState *gui, Canvas *canvas, ExportFormat format,
                       ExportScope scope) {
   gui->showMenu = false;
   gui->showColorPicker = false;
@@ -720,15 +495,30 @@ void GuiRequestExport(GuiState *gui, const Canvas *canvas, ExportFormat format,
     GuiToastSet(gui, "No canvas.");
     return;
   }
+  if (GuiActiveDocumentLoading(gui)) {
+    GuiToastSet(gui, "Still opening.");
+    return;
+  }
+
+  if (!CanvasEnsureLoaded(canvas)) {
+    GuiToastSet(gui, "Export failed.");
+    return;
+  }
 
   if (!HasGuiSession()) {
     GuiToastSet(gui, "No GUI session for file dialogs.");
     return;
   }
+  if (GuiExportBusy()) {
+    GuiToastSet(gui, "Still exporting.");
+    return;
+  }
 
   const char *filter = (format == EXPORT_FORMAT_SVG)
                            ? "svg"
-                           : (format == EXPORT_FORMAT_JPG) ? "jpg,jpeg" : "png";
+                           : (format == EXPORT_FORMAT_PDF)
+                                 ? "pdf"
+                                 : (format == EXPORT_FORMAT_JPG) ? "jpg,jpeg" : "png";
 
   char base[128];
   Document *doc = GuiGetActiveDocument(gui);
@@ -750,19 +540,15 @@ void GuiRequestExport(GuiState *gui, const Canvas *canvas, ExportFormat format,
     CopyPath(resolved, sizeof(resolved), path);
     EnsureExportExtension(resolved, sizeof(resolved), format);
 
-    bool ok = false;
-    if (format == EXPORT_FORMAT_SVG)
-      ok = ExportCanvasSvg(canvas, scope, resolved);
-    else
-      ok = ExportCanvasRaster(canvas, scope, format, resolved);
-
-    const char *label = (format == EXPORT_FORMAT_SVG)
-                            ? "SVG"
-                            : (format == EXPORT_FORMAT_JPG) ? "JPG" : "PNG";
-    if (ok) {
-      char msg[64];
-      snprintf(msg, sizeof(msg), "Exported %s.", label);
-      GuiToastSet(gui, msg);
+    ExportPlan plan = {0};
+    plan.format = format;
+    bool vector = format == EXPORT_FORMAT_SVG || format == EXPORT_FORMAT_PDF;
+    bool ok = vector ? PlanSvgExport(canvas, scope, &plan)
+                     : PlanRasterExport(gui, canvas, scope, &plan);
+    plan.pdf = (ExportPdfOptions){gui->pdfPageWidth, gui->pdfPageHeight, true};
+    // GuiExportUpdate renders the rest and reports when the file is written.
+    if (ok && GuiExportStart(canvas, &plan, resolved)) {
+      GuiToastSet(gui, "Exporting...");
       UpdateLastDir(gui, resolved);
       UpdateLastFileName(gui, resolved);
     } else {
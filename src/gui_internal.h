@@ -1,6 +1,7 @@
 #ifndef GUI_INTERNAL_H
 #define GUI_INTERNAL_H
 
+#include "export.h"
 #include "gui.h"
 
 typedef struct {
@@ -20,12 +21,13 @@ typedef struct {
 typedef enum {
   EXPORT_FORMAT_PNG = 0,
   EXPORT_FORMAT_JPG,
-  EXPORT_FORMAT_SVG
+  EXPORT_FORMAT_SVG,
+  EXPORT_FORMAT_PDF
 } ExportFormat;
 
 typedef enum {
   EXPORT_SCOPE_VIEW = 0,
-  EXPORT_SCOPE_CANVAS,
+  EXPORT_SCOPE_CANVAS, // the whole drawing; rasters at the print size
   EXPORT_SCOPE_VIEW_FHD
 } ExportScope;
 
@@ -59,6 +61,10 @@ void GuiDrawRulerTop(GuiState *gui, const Canvas *canvas, Theme t, int sw, int s
 void GuiDrawRulerLeft(GuiState *gui, const Canvas *canvas, Theme t, int sw,
                       int sh);
 void GuiDrawWelcome(GuiState *gui, Canvas *canvas, Theme t, int sw, int sh);
+bool GuiTextButton(Font font, Rectangle r, const char *label, Theme t,
+                   bool primary);
+void GuiDrawRecovery(GuiState *gui, Theme t, int sw, int sh);
+void GuiDrawCloseConfirm(GuiState *gui, Theme t, int sw, int sh);
 void GuiDrawMenu(GuiState *gui, Canvas *canvas, Theme t);
 void GuiDrawPalette(GuiState *gui, Canvas *canvas, Theme t, Color iconIdle,
                     Color iconHover, int sw, int sh, float paletteX,
@@ -70,10 +76,43 @@ void GuiDrawFooter(GuiState *gui, Canvas *canvas, Theme t, int sw, int sh);
 
 void GuiMarkNewDocument(GuiState *gui);
 void GuiRequestOpen(GuiState *gui);
+bool GuiOpenStart(Document *doc, const char *path);
+bool GuiOpenBusy(void);
 void GuiRequestSave(GuiState *gui, Document *doc);
-void GuiRequestExport(GuiState *gui, const Canvas *canvas, ExportFormat format,
+void GuiRequestCompactSave(GuiState *gui, Document *doc);
+void GuiAutosaveNameDocument(Document *doc);
+// The document's file (or an intentional close) now covers its edits; drops
+// the sidecar.
+void GuiAutosaveForget(Document *doc);
+// Sidecars waiting on the recovery card, by document path ("" for untitled).
+// Recovering opens each in a tab; discarding deletes them.
+int GuiAutosavePendingCount(void);
+const char *GuiAutosavePendingPath(int index);
+void GuiAutosaveRecover(GuiState *gui, int screenWidth, int screenHeight);
+void GuiAutosaveDiscard(GuiState *gui);
+void GuiRequestExport(GuiState *gui, Canvas *canvas, ExportFormat format,
                       ExportScope scope);
 
+// An export as chosen: rasters draw through `camera` into width x height
+// pixels, SVG and PDF write the `svg` view, PDF on `pdf` pages.
+typedef struct {
+  ExportFormat format;
+  Camera2D camera;
+  int width;
+  int height;
+  float dpi; // recorded in PNGs; 0 for none
+  ExportView svg;
+  ExportPdfOptions pdf;
+} ExportPlan;
+
+// Exports a snapshot of `canvas` while editing goes on. Raster tiles are
+// drawn and read back a few per frame by GuiExportUpdate; a worker thread
+// assembles, encodes and writes them.
+bool GuiExportStart(Canvas *canvas, const ExportPlan *plan, const char *path);
+bool GuiExportBusy(void);
+// False when no export runs; otherwise the share of the output written.
+bool GuiExportProgress(float *progress);
+
 void GuiDocumentsInit(GuiState *gui, int screenWidth, int screenHeight,
                       bool showGrid);
 void GuiDocumentsFree(GuiState *gui);
@@ -83,5 +122,8 @@ Document *GuiAddDocument(GuiState *gui, int screenWidth, int screenHeight,
                          bool showGrid, bool makeActive);
 void GuiCloseDocument(GuiState *gui, int index, int screenWidth, int screenHeight,
                       bool showGrid);
+// Closes a tab from the user: a recovered, unsaved one is confirmed first.
+// Returns true when the tab was closed now.
+bool GuiRequestCloseDocument(GuiState *gui, int index);
 
 #endif
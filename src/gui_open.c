@@ -0,0 +1,120 @@
+#include "gui_internal.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+// One file opens at a time. The worker loads into gOpen.canvas while the
+// document shows the strokes decoded so far; when it finishes, the loaded
+// canvas replaces that preview.
+static struct {
+  pthread_t thread;
+  CanvasLoadFeed *feed;
+  Canvas canvas;
+  char path[256];
+  char docName[48]; // autosave name of the document showing the preview
+  bool ok;
+  int done;
+  bool cancelled;
+  bool running;
+} gOpen;
+
+static void *OpenThreadMain(void *arg) {
+  (void)arg;
+  gOpen.ok = LoadCanvasFromFileFed(&gOpen.canvas, gOpen.path, gOpen.feed);
+  __atomic_store_n(&gOpen.done, 1, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+static int FindPreviewDocument(GuiState *gui) {
+  for (int i = 0; i < gui->documentCount; i++) {
+    if (strcmp(gui->documents[i].autosaveName, gOpen.docName) == 0)
+      return i;
+  }
+  return -1;
+}
+
+bool GuiOpenStart(Document *doc, const char *path) {
+  if (gOpen.running || !doc || !path)
+    return false;
+  gOpen.feed = CanvasLoadFeedCreate();
+  if (!gOpen.feed)
+    return false;
+  InitCanvas(&gOpen.canvas, GetScreenWidth(), GetScreenHeight());
+  gOpen.canvas.showGrid = doc->canvas.showGrid;
+  snprintf(gOpen.path, sizeof(gOpen.path), "%s", path);
+  memcpy(gOpen.docName, doc->autosaveName, sizeof(gOpen.docName));
+  gOpen.ok = false;
+  gOpen.done = 0;
+  gOpen.cancelled = false;
+  if (pthread_create(&gOpen.thread, NULL, OpenThreadMain, NULL) != 0) {
+    FreeCanvas(&gOpen.canvas);
+    CanvasLoadFeedFree(gOpen.feed);
+    gOpen.feed = NULL;
+    return false;
+  }
+  gOpen.running = true;
+  doc->loading = true;
+  doc->loadProgress = 0.0f;
+  return true;
+}
+
+bool GuiOpenBusy(void) { return gOpen.running; }
+
+static void Finish(void) {
+  pthread_join(gOpen.thread, NULL);
+  gOpen.running = false;
+  CanvasLoadFeedFree(gOpen.feed);
+  gOpen.feed = NULL;
+}
+
+void GuiOpenUpdate(GuiState *gui) {
+  if (!gOpen.running)
+    return;
+
+  int index = FindPreviewDocument(gui);
+  Document *doc = index >= 0 ? &gui->documents[index] : NULL;
+  // Closing the tab cancels too.
+  if (!doc || (index == gui->activeDocument && IsKeyPressed(KEY_ESCAPE))) {
+    CanvasLoadFeedCancel(gOpen.feed);
+    gOpen.cancelled = true;
+  }
+
+  bool done = __atomic_load_n(&gOpen.done, __ATOMIC_ACQUIRE) != 0;
+  if (doc) {
+    CanvasLoadFeedTake(gOpen.feed, &doc->canvas);
+    doc->loadProgress = CanvasLoadFeedProgress(gOpen.feed);
+  }
+  if (!done)
+    return;
+
+  Finish();
+  if (!doc) {
+    FreeCanvas(&gOpen.canvas);
+    return;
+  }
+  if (!gOpen.ok || gOpen.cancelled) {
+    FreeCanvas(&gOpen.canvas);
+    GuiCloseDocument(gui, index, GetScreenWidth(), GetScreenHeight(),
+                     doc->canvas.showGrid);
+    GuiToastSet(gui, gOpen.cancelled ? "Open cancelled." : "Load failed.");
+    return;
+  }
+
+  // The preview already carries the saved view, or wherever the user moved it.
+  gOpen.canvas.camera = doc->canvas.camera;
+  FreeCanvas(&doc->canvas);
+  doc->canvas = gOpen.canvas;
+  doc->loading = false;
+  snprintf(doc->path, sizeof(doc->path), "%s", gOpen.path);
+  doc->hasPath = true;
+  doc->autosavedEdits = doc->canvas.editCount;
+  GuiToastSet(gui, "Loaded.");
+}
+
+void GuiOpenStop(void) {
+  if (!gOpen.running)
+    return;
+  CanvasLoadFeedCancel(gOpen.feed);
+  Finish();
+  FreeCanvas(&gOpen.canvas);
+}
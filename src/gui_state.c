@@ -33,11 +33,16 @@ void InitGui(GuiState *gui) {
   gui->activeTool = TOOL_PEN;
   gui->currentColor = WHITE;
   gui->currentThickness = 3.0f;
+  gui->simplifyTolerance = 0.35f;
+  gui->compressSaves = false;
+  gui->exportDpi = 300.0f;
   gui->toolbarRect = (Rectangle){0, 0, (float)GetScreenWidth(), 88};
 
   gui->showRulers = true;
   gui->showWelcome = false;
   gui->hasSeenWelcome = false;
+  gui->showRecovery = false;
+  gui->confirmCloseDocument = -1;
 
   gui->paletteRect = (Rectangle){0, 0, 0, 0};
   gui->paletteButtonRect = (Rectangle){0, 0, 0, 0};
@@ -101,7 +106,7 @@ void InitGui(GuiState *gui) {
 }
 
 bool IsMouseOverGui(GuiState *gui) {
-  if (gui->showWelcome)
+  if (gui->showWelcome || gui->showRecovery || gui->confirmCloseDocument >= 0)
     return true;
 
   const float topH = 88.0f;
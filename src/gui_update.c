@@ -106,6 +106,12 @@ void UpdateGui(GuiState *gui, Canvas *canvas) {
   canvas->gridColor = t.grid;
   canvas->selectionColor = t.primary;
 
+  Document *doc = GuiGetActiveDocument(gui);
+  if (doc && !doc->unreadableReported && CanvasStreamFailed(canvas)) {
+    doc->unreadableReported = true;
+    GuiToastSet(gui, "Part of this file could not be read. Saving is off.");
+  }
+
   bool ctrl = IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL);
   bool shift = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT);
   bool alt = IsKeyDown(KEY_LEFT_ALT) || IsKeyDown(KEY_RIGHT_ALT);
@@ -116,6 +122,14 @@ void UpdateGui(GuiState *gui, Canvas *canvas) {
       gui->hasSeenWelcome = true;
       GuiToastSet(gui, "Welcome!");
     }
+  } else if (gui->showRecovery) {
+    if (IsKeyPressed(KEY_ENTER))
+      GuiAutosaveRecover(gui, GetScreenWidth(), GetScreenHeight());
+    else if (IsKeyPressed(KEY_ESCAPE))
+      GuiAutosaveDiscard(gui);
+  } else if (gui->confirmCloseDocument >= 0) {
+    if (IsKeyPressed(KEY_ENTER) || IsKeyPressed(KEY_ESCAPE))
+      gui->confirmCloseDocument = -1;
   } else {
     AiSettingsUiUpdate(gui, GetScreenWidth(),
                        GetScreenHeight());
@@ -126,12 +140,17 @@ void UpdateGui(GuiState *gui, Canvas *canvas) {
 
     canvas->currentStroke.color = gui->currentColor;
     canvas->currentStroke.thickness = gui->currentThickness;
+    canvas->simplifyTolerance = gui->simplifyTolerance;
+    canvas->compressSaves = gui->compressSaves;
 
-    if (ctrl && IsKeyPressed(KEY_Z))
+    bool loading = GuiActiveDocumentLoading(gui);
+    if (ctrl && IsKeyPressed(KEY_Z) && !loading)
       Undo(canvas);
-    if (ctrl && IsKeyPressed(KEY_Y))
+    if (ctrl && IsKeyPressed(KEY_Y) && !loading)
       Redo(canvas);
-    if (ctrl && IsKeyPressed(KEY_S))
+    if (ctrl && shift && IsKeyPressed(KEY_S))
+      GuiRequestCompactSave(gui, GuiGetActiveDocument(gui));
+    else if (ctrl && IsKeyPressed(KEY_S))
       GuiRequestSave(gui, GuiGetActiveDocument(gui));
     if (ctrl && IsKeyPressed(KEY_O))
       GuiRequestOpen(gui);
@@ -142,13 +161,9 @@ void UpdateGui(GuiState *gui, Canvas *canvas) {
       GuiToastSet(gui, "New canvas.");
     }
     if (ctrl && IsKeyPressed(KEY_W)) {
-      Document *active = GuiGetActiveDocument(gui);
-      bool showGrid = active ? active->canvas.showGrid : true;
-      if (gui->activeDocument >= 0) {
-        GuiCloseDocument(gui, gui->activeDocument, GetScreenWidth(),
-                         GetScreenHeight(), showGrid);
+      if (gui->activeDocument >= 0 &&
+          GuiRequestCloseDocument(gui, gui->activeDocument))
         GuiToastSet(gui, "Tab closed.");
-      }
     }
 
     if (!gui->isTyping && !ctrl && !alt) {
@@ -193,6 +208,16 @@ void UpdateGui(GuiState *gui, Canvas *canvas) {
   now.darkMode = gui->darkMode;
   now.showGrid = canvas->showGrid;
   now.hasSeenWelcome = gui->hasSeenWelcome;
+  now.simplifyTolerance = gui->simplifyTolerance;
+  now.compressSaves = gui->compressSaves;
+  now.exportDpi = gui->exportDpi;
+  now.exportWidth = gui->exportWidth;
+  now.exportHeight = gui->exportHeight;
+  now.pdfPageWidth = gui->pdfPageWidth;
+  now.pdfPageHeight = gui->pdfPageHeight;
+  CanvasLoadLimits limits = CanvasGetLoadLimits();
+  now.maxLoadStrokes = limits.maxStrokes;
+  now.maxLoadPoints = limits.maxTotalPoints;
   if (!hasLastPrefs) {
     lastPrefs = now;
     hasLastPrefs = true;
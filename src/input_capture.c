@@ -0,0 +1,359 @@
+#include "input_capture.h"
+#include <math.h>
+#include <stdint.h>
+#include <time.h>
+
+#if defined(CDRAW_HAVE_XI2)
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+#include <X11/extensions/XInput2.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// Single-producer/single-consumer ring. The producer is the capture thread
+// (or the main thread in polling mode); the consumer is always the pen tool.
+typedef struct {
+  InputSample samples[INPUT_CAPTURE_CAPACITY];
+  uint32_t head; // next slot to write, owned by the producer
+  uint32_t tail; // next slot to read, owned by the consumer
+} SampleRing;
+
+static SampleRing gRing;
+static bool gThreaded = false;
+
+static bool RingPush(const InputSample *sample) {
+  uint32_t head = __atomic_load_n(&gRing.head, __ATOMIC_RELAXED);
+  uint32_t tail = __atomic_load_n(&gRing.tail, __ATOMIC_ACQUIRE);
+  if (head - tail >= INPUT_CAPTURE_CAPACITY)
+    return false;
+  gRing.samples[head & (INPUT_CAPTURE_CAPACITY - 1)] = *sample;
+  __atomic_store_n(&gRing.head, head + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+int InputCaptureDrain(InputSample *out, int max) {
+  if (!out || max <= 0)
+    return 0;
+  uint32_t tail = __atomic_load_n(&gRing.tail, __ATOMIC_RELAXED);
+  uint32_t head = __atomic_load_n(&gRing.head, __ATOMIC_ACQUIRE);
+  uint32_t avail = head - tail;
+  if (avail > (uint32_t)max)
+    avail = (uint32_t)max;
+  for (uint32_t i = 0; i < avail; i++)
+    out[i] = gRing.samples[(tail + i) & (INPUT_CAPTURE_CAPACITY - 1)];
+  __atomic_store_n(&gRing.tail, tail + avail, __ATOMIC_RELEASE);
+  return (int)avail;
+}
+
+double InputCaptureNow(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+void InputCapturePoll(float x, float y, bool down) {
+  if (gThreaded)
+    return;
+  InputSample sample = {x, y, InputCaptureNow(), down};
+  (void)RingPush(&sample);
+}
+
+bool InputCaptureIsThreaded(void) { return gThreaded; }
+
+#if defined(CDRAW_HAVE_XI2)
+
+// Devices whose x/y axes are tracked, and the most motion events kept from
+// one drain of the connection.
+#define CAPTURE_MAX_DEVICES 16
+#define CAPTURE_MAX_BATCH 512
+
+// Turns a device's axis 0 (x) and 1 (y) values into screen-pixel deltas.
+// Relative axes already are; absolute ones (tablets) are differenced and
+// scaled from the axis range to the screen.
+typedef struct {
+  int id;
+  bool absolute[2];
+  double scale[2];
+  double last[2];
+  bool hasLast[2];
+} CaptureDevice;
+
+// One event of a drain: when it happened, how far it moved the pointer, the
+// button state after it and, once placed, where it left the pointer.
+typedef struct {
+  double time;
+  double dx, dy;
+  bool down;
+  double x, y;
+} CaptureMotion;
+
+static struct {
+  Display *display;
+  Window window;
+  int xiOpcode;
+  pthread_t thread;
+  int stop;
+  CaptureDevice devices[CAPTURE_MAX_DEVICES];
+  int deviceCount;
+  uint32_t lastMs;
+  uint64_t msEpoch;
+  bool haveServerTime;
+  double clockOffset;
+  bool haveClock;
+} gX11;
+
+static Window FindWindowByPid(Display *dpy, Window w, Atom pidAtom,
+                              unsigned long pid) {
+  Atom type = None;
+  int format = 0;
+  unsigned long count = 0, after = 0;
+  unsigned char *data = NULL;
+  if (XGetWindowProperty(dpy, w, pidAtom, 0, 1, False, XA_CARDINAL, &type,
+                         &format, &count, &after, &data) == Success &&
+      data) {
+    bool match = type == XA_CARDINAL && format == 32 && count == 1 &&
+                 *(unsigned long *)data == pid;
+    XFree(data);
+    if (match)
+      return w;
+  }
+
+  Window root = None, parent = None, *children = NULL;
+  unsigned int n = 0;
+  if (!XQueryTree(dpy, w, &root, &parent, &children, &n))
+    return None;
+  Window found = None;
+  for (unsigned int i = 0; i < n && found == None; i++)
+    found = FindWindowByPid(dpy, children[i], pidAtom, pid);
+  if (children)
+    XFree(children);
+  return found;
+}
+
+static CaptureDevice *CaptureDeviceFor(Display *dpy, int id) {
+  for (int i = 0; i < gX11.deviceCount; i++) {
+    if (gX11.devices[i].id == id)
+      return &gX11.devices[i];
+  }
+  if (gX11.deviceCount >= CAPTURE_MAX_DEVICES)
+    return NULL;
+
+  CaptureDevice *d = &gX11.devices[gX11.deviceCount++];
+  *d = (CaptureDevice){.id = id, .scale = {1.0, 1.0}};
+  int screen = DefaultScreen(dpy);
+  double extent[2] = {DisplayWidth(dpy, screen), DisplayHeight(dpy, screen)};
+  int count = 0;
+  XIDeviceInfo *info = XIQueryDevice(dpy, id, &count);
+  for (int c = 0; info && c < info->num_classes; c++) {
+    if (info->classes[c]->type != XIValuatorClass)
+      continue;
+    XIValuatorClassInfo *v = (XIValuatorClassInfo *)info->classes[c];
+    if (v->number < 2 && v->mode == XIModeAbsolute && v->max > v->min) {
+      d->absolute[v->number] = true;
+      d->scale[v->number] = extent[v->number] / (v->max - v->min);
+    }
+  }
+  if (info)
+    XIFreeDeviceInfo(info);
+  return d;
+}
+
+static void CaptureRawDelta(CaptureDevice *d, const XIRawEvent *raw,
+                            double delta[2]) {
+  delta[0] = delta[1] = 0.0;
+  const double *value = raw->valuators.values;
+  for (int axis = 0; axis < 2 && axis < raw->valuators.mask_len * 8; axis++) {
+    if (!XIMaskIsSet(raw->valuators.mask, axis))
+      continue;
+    double v = *value++;
+    if (!d || !d->absolute[axis]) {
+      delta[axis] = v;
+      continue;
+    }
+    if (d->hasLast[axis])
+      delta[axis] = (v - d->last[axis]) * d->scale[axis];
+    d->last[axis] = v;
+    d->hasLast[axis] = true;
+  }
+}
+
+// Server timestamps are 32-bit milliseconds on the server's own clock; this
+// unwraps them into seconds, still on the server clock.
+static double CaptureServerTime(Time serverTime) {
+  uint32_t ms = (uint32_t)serverTime;
+  if (gX11.haveServerTime && ms < gX11.lastMs &&
+      gX11.lastMs - ms > 0x80000000u)
+    gX11.msEpoch += (uint64_t)1 << 32;
+  gX11.lastMs = ms;
+  gX11.haveServerTime = true;
+  return (double)(gX11.msEpoch + ms) * 1e-3;
+}
+
+// Moves a drain's server times onto our clock by the smallest delivery delay
+// seen so far, the closest estimate of the offset between the two clocks.
+static void CaptureSyncClock(double serverTime, double now) {
+  double offset = now - serverTime;
+  if (!gX11.haveClock || offset < gX11.clockOffset)
+    gX11.clockOffset = offset;
+  gX11.haveClock = true;
+}
+
+// Raw events are delivered to root-window listeners even while the toolkit
+// holds the implicit button grab, so each one becomes a sample stamped with
+// its own event time. They carry device deltas rather than positions: the
+// pointer query after a drain pins the last event to the exact window
+// position, and the earlier ones are placed by walking their deltas back.
+static void *CaptureThreadMain(void *arg) {
+  (void)arg;
+  Display *dpy = gX11.display;
+  int fd = ConnectionNumber(dpy);
+  float lastX = -1.0f, lastY = -1.0f;
+  bool lastDown = false;
+  static CaptureMotion batch[CAPTURE_MAX_BATCH];
+
+  while (!__atomic_load_n(&gX11.stop, __ATOMIC_ACQUIRE)) {
+    int count = 0;
+    bool down = lastDown;
+    while (XPending(dpy) > 0) {
+      XEvent ev;
+      XNextEvent(dpy, &ev);
+      XGenericEventCookie *cookie = &ev.xcookie;
+      if (cookie->type != GenericEvent || cookie->extension != gX11.xiOpcode ||
+          !XGetEventData(dpy, cookie))
+        continue;
+
+      XIRawEvent *raw = (XIRawEvent *)cookie->data;
+      bool press = cookie->evtype == XI_RawButtonPress;
+      if (cookie->evtype == XI_RawMotion ||
+          ((press || cookie->evtype == XI_RawButtonRelease) && raw->detail == 1)) {
+        if (cookie->evtype != XI_RawMotion)
+          down = press;
+        double delta[2] = {0.0, 0.0};
+        if (cookie->evtype == XI_RawMotion)
+          CaptureRawDelta(CaptureDeviceFor(dpy, raw->sourceid), raw, delta);
+        CaptureMotion motion = {CaptureServerTime(raw->time), delta[0],
+                                delta[1], down};
+        // A full batch merges its last two entries, keeping their motion.
+        if (count == CAPTURE_MAX_BATCH) {
+          CaptureMotion *a = &batch[count - 2], *b = &batch[count - 1];
+          a->time = b->time;
+          a->dx += b->dx;
+          a->dy += b->dy;
+          a->down = b->down;
+          count--;
+        }
+        batch[count++] = motion;
+      }
+      XFreeEventData(dpy, cookie);
+    }
+
+    if (count > 0) {
+      Window rootRet, childRet;
+      int rootX, rootY, winX, winY;
+      unsigned int mask = 0;
+      if (XQueryPointer(dpy, gX11.window, &rootRet, &childRet, &rootX, &rootY,
+                        &winX, &winY, &mask)) {
+        batch[count - 1].down = (mask & Button1Mask) != 0;
+        batch[count - 1].x = winX;
+        batch[count - 1].y = winY;
+        for (int i = count - 1; i > 0; i--) {
+          batch[i - 1].x = batch[i].x - batch[i].dx;
+          batch[i - 1].y = batch[i].y - batch[i].dy;
+        }
+
+        double now = InputCaptureNow();
+        CaptureSyncClock(batch[count - 1].time, now);
+        for (int i = 0; i < count; i++) {
+          double time = fmin(batch[i].time + gX11.clockOffset, now);
+          InputSample sample = {(float)batch[i].x, (float)batch[i].y, time,
+                                batch[i].down};
+          if (sample.x == lastX && sample.y == lastY && sample.down == lastDown)
+            continue;
+          (void)RingPush(&sample);
+          lastX = sample.x;
+          lastY = sample.y;
+          lastDown = sample.down;
+        }
+      }
+      continue;
+    }
+
+    struct pollfd pfd = {fd, POLLIN, 0};
+    (void)poll(&pfd, 1, 50);
+  }
+  return NULL;
+}
+
+bool InputCaptureStart(void) {
+  if (gThreaded)
+    return true;
+
+  Display *dpy = XOpenDisplay(NULL);
+  if (!dpy)
+    return false;
+
+  int event = 0, error = 0;
+  int major = 2, minor = 2;
+  if (!XQueryExtension(dpy, "XInputExtension", &gX11.xiOpcode, &event, &error) ||
+      XIQueryVersion(dpy, &major, &minor) != Success) {
+    XCloseDisplay(dpy);
+    return false;
+  }
+
+  Atom pidAtom = XInternAtom(dpy, "_NET_WM_PID", True);
+  Window window = (pidAtom != None)
+                      ? FindWindowByPid(dpy, DefaultRootWindow(dpy), pidAtom,
+                                        (unsigned long)getpid())
+                      : None;
+  if (window == None) {
+    XCloseDisplay(dpy);
+    return false;
+  }
+
+  unsigned char bits[XIMaskLen(XI_LASTEVENT)] = {0};
+  XISetMask(bits, XI_RawMotion);
+  XISetMask(bits, XI_RawButtonPress);
+  XISetMask(bits, XI_RawButtonRelease);
+  XIEventMask mask;
+  mask.deviceid = XIAllMasterDevices;
+  mask.mask_len = (int)sizeof(bits);
+  mask.mask = bits;
+  XISelectEvents(dpy, DefaultRootWindow(dpy), &mask, 1);
+  XFlush(dpy);
+
+  gX11.display = dpy;
+  gX11.window = window;
+  gX11.stop = 0;
+  gX11.deviceCount = 0;
+  gX11.haveClock = false;
+  gX11.haveServerTime = false;
+  gX11.msEpoch = 0;
+  if (pthread_create(&gX11.thread, NULL, CaptureThreadMain, NULL) != 0) {
+    XCloseDisplay(dpy);
+    gX11.display = NULL;
+    return false;
+  }
+
+  gThreaded = true;
+  return true;
+}
+
+void InputCaptureStop(void) {
+  if (!gThreaded)
+    return;
+  __atomic_store_n(&gX11.stop, 1, __ATOMIC_RELEASE);
+  pthread_join(gX11.thread, NULL);
+  XCloseDisplay(gX11.display);
+  gX11.display = NULL;
+  gThreaded = false;
+}
+
+#else
+
+bool InputCaptureStart(void) { return false; }
+
+void InputCaptureStop(void) {}
+
+#endif
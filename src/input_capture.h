@@ -0,0 +1,32 @@
+#ifndef INPUT_CAPTURE_H
+#define INPUT_CAPTURE_H
+
+#include <stdbool.h>
+
+// One pointer position in window coordinates, stamped on the capture clock.
+typedef struct {
+  float x;
+  float y;
+  double time;
+  bool down;
+} InputSample;
+
+#define INPUT_CAPTURE_CAPACITY 4096
+
+// Starts the high-rate capture thread (XInput2 raw motion on X11). Returns
+// false when it is unavailable; callers then feed samples with
+// InputCapturePoll once per frame.
+bool InputCaptureStart(void);
+void InputCaptureStop(void);
+bool InputCaptureIsThreaded(void);
+
+// Per-frame fallback sample. No-op while the capture thread is running.
+void InputCapturePoll(float x, float y, bool down);
+
+// Moves up to `max` pending samples, oldest first, into `out`.
+int InputCaptureDrain(InputSample *out, int max);
+
+// Current time on the clock used for sample timestamps, in seconds.
+double InputCaptureNow(void);
+
+#endif
@@ -0,0 +1,153 @@
+#include "lz_block.h"
+#include <string.h>
+
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 14
+#define LZ_MAX_OFFSET 65535
+// The last bytes of a block are always literals, which lets the decoder copy
+// matches without checking for the end of input inside the match loop.
+#define LZ_TAIL_LITERALS 5
+
+static uint32_t Load32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static uint32_t Hash32(uint32_t v) { return (v * 2654435761u) >> (32 - LZ_HASH_BITS); }
+
+size_t LzBlockBound(size_t size) { return size + size / 255 + 16; }
+
+static uint8_t *PutLength(uint8_t *op, size_t len) {
+  while (len >= 255) {
+    *op++ = 255;
+    len -= 255;
+  }
+  *op++ = (uint8_t)len;
+  return op;
+}
+
+static uint8_t *PutSequence(uint8_t *op, const uint8_t *literals, size_t litLen,
+                            size_t offset, size_t matchLen) {
+  uint8_t *token = op++;
+  size_t litCode = litLen < 15 ? litLen : 15;
+  size_t matchCode = 0;
+  if (matchLen > 0) {
+    size_t extra = matchLen - LZ_MIN_MATCH;
+    matchCode = extra < 15 ? extra : 15;
+  }
+  *token = (uint8_t)((litCode << 4) | matchCode);
+  if (litCode == 15)
+    op = PutLength(op, litLen - 15);
+  memcpy(op, literals, litLen);
+  op += litLen;
+  if (matchLen > 0) {
+    *op++ = (uint8_t)(offset & 0xFF);
+    *op++ = (uint8_t)(offset >> 8);
+    if (matchCode == 15)
+      op = PutLength(op, matchLen - LZ_MIN_MATCH - 15);
+  }
+  return op;
+}
+
+size_t LzCompressBlock(const uint8_t *src, size_t size, uint8_t *dst, size_t dstCap) {
+  if (!src || !dst || dstCap < LzBlockBound(size))
+    return 0;
+
+  uint32_t table[1 << LZ_HASH_BITS];
+  memset(table, 0, sizeof(table));
+
+  uint8_t *op = dst;
+  size_t anchor = 0;
+  size_t ip = 0;
+  size_t limit = size > LZ_TAIL_LITERALS + LZ_MIN_MATCH ? size - LZ_TAIL_LITERALS - LZ_MIN_MATCH : 0;
+
+  // Positions are stored +1 so 0 can mean "empty".
+  while (ip < limit) {
+    uint32_t seq = Load32(src + ip);
+    uint32_t h = Hash32(seq);
+    size_t cand = table[h];
+    table[h] = (uint32_t)(ip + 1);
+    if (cand == 0 || ip - (cand - 1) > LZ_MAX_OFFSET || Load32(src + cand - 1) != seq) {
+      ip++;
+      continue;
+    }
+    cand -= 1;
+
+    size_t matchLen = LZ_MIN_MATCH;
+    size_t maxLen = size - LZ_TAIL_LITERALS - ip;
+    while (matchLen < maxLen && src[cand + matchLen] == src[ip + matchLen])
+      matchLen++;
+    // Extend backwards over literals that also match.
+    while (ip > anchor && cand > 0 && src[ip - 1] == src[cand - 1]) {
+      ip--;
+      cand--;
+      matchLen++;
+    }
+
+    op = PutSequence(op, src + anchor, ip - anchor, ip - cand, matchLen);
+    ip += matchLen;
+    anchor = ip;
+    if (ip >= 2 && ip - 2 < limit)
+      table[Hash32(Load32(src + ip - 2))] = (uint32_t)(ip - 2 + 1);
+  }
+
+  op = PutSequence(op, src + anchor, size - anchor, 0, 0);
+  return (size_t)(op - dst);
+}
+
+static bool GetLength(const uint8_t **ip, const uint8_t *end, size_t *len) {
+  uint8_t b;
+  do {
+    if (*ip >= end)
+      return false;
+    b = *(*ip)++;
+    *len += b;
+  } while (b == 255);
+  return true;
+}
+
+bool LzDecompressBlock(const uint8_t *src, size_t size, uint8_t *dst, size_t rawSize) {
+  if (!src || (!dst && rawSize > 0))
+    return false;
+  const uint8_t *ip = src;
+  const uint8_t *end = src + size;
+  uint8_t *op = dst;
+  uint8_t *opEnd = dst + rawSize;
+
+  while (ip < end) {
+    uint8_t token = *ip++;
+    size_t litLen = token >> 4;
+    if (litLen == 15 && !GetLength(&ip, end, &litLen))
+      return false;
+    if (litLen > (size_t)(end - ip) || litLen > (size_t)(opEnd - op))
+      return false;
+    memcpy(op, ip, litLen);
+    ip += litLen;
+    op += litLen;
+    if (ip == end)
+      break;
+
+    if (end - ip < 2)
+      return false;
+    size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+    ip += 2;
+    size_t matchLen = token & 15;
+    if (matchLen == 15 && !GetLength(&ip, end, &matchLen))
+      return false;
+    matchLen += LZ_MIN_MATCH;
+    if (offset == 0 || offset > (size_t)(op - dst) || matchLen > (size_t)(opEnd - op))
+      return false;
+
+    // Byte copy: matches may overlap their own output.
+    const uint8_t *match = op - offset;
+    if (offset >= matchLen) {
+      memcpy(op, match, matchLen);
+      op += matchLen;
+    } else {
+      for (size_t i = 0; i < matchLen; i++)
+        *op++ = match[i];
+    }
+  }
+  return op == opEnd;
+}
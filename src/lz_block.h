@@ -0,0 +1,20 @@
+#ifndef LZ_BLOCK_H
+#define LZ_BLOCK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Small LZ77 block codec (LZ4-style sequences: a token with literal and match
+// lengths, the literals, then a 16-bit match offset). Blocks are independent.
+
+// Largest compressed size for `size` input bytes.
+size_t LzBlockBound(size_t size);
+
+// Returns the compressed size, or 0 if the output would not fit in `dstCap`.
+size_t LzCompressBlock(const uint8_t *src, size_t size, uint8_t *dst, size_t dstCap);
+
+// Decodes exactly `rawSize` bytes; false on malformed or truncated input.
+bool LzDecompressBlock(const uint8_t *src, size_t size, uint8_t *dst, size_t rawSize);
+
+#endif // LZ_BLOCK_H
@@ -1,12 +1,16 @@
 #include "app_paths.h"
 #include "canvas.h"
 #include "gui.h"
+#include "input_capture.h"
 #include "prefs.h"
 #include "raylib.h"
+#include <dirent.h>
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <time.h>
 
 #ifndef PATH_MAX
 #define PATH_MAX 4096
@@ -90,14 +94,102 @@ static void StartBackend(void) {}
 static void StopBackend(void) {}
 #endif
 
-int main(void) {
+// cdraw --convert IN OUT: rewrites any file cdraw opens, legacy text
+// included, in the current binary format. No window is opened.
+static int RunConvert(const char *inPath, const char *outPath) {
+  AppPrefs prefs = PrefsDefaults();
+  (void)PrefsLoad(&prefs);
+  CanvasSetLoadLimits((CanvasLoadLimits){prefs.maxLoadStrokes, prefs.maxLoadPoints});
+
+  Canvas canvas;
+  InitCanvas(&canvas, 1000, 800);
+  clock_t start = clock();
+  if (!LoadCanvasFromFile(&canvas, inPath) || !CanvasEnsureLoaded(&canvas)) {
+    fprintf(stderr, "Convert: cannot load %s\n", inPath);
+    FreeCanvas(&canvas);
+    return 1;
+  }
+  double loadSeconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  if (!WriteCanvasFile(&canvas, outPath)) {
+    fprintf(stderr, "Convert: cannot write %s\n", outPath);
+    FreeCanvas(&canvas);
+    return 1;
+  }
+  fprintf(stderr, "Converted %d strokes, %lld points (loaded in %.2fs)\n",
+          canvas.strokeCount, (long long)canvas.totalPoints, loadSeconds);
+  FreeCanvas(&canvas);
+  return 0;
+}
+
+static bool VerifyOne(const char *path) {
+  bool checksummed = false;
+  char error[128];
+  if (!CanvasVerifyFile(path, &checksummed, error, sizeof(error))) {
+    printf("BAD  %s: %s\n", path, error);
+    return false;
+  }
+  printf("ok   %s%s\n", path, checksummed ? "" : " (no checksums; loads)");
+  return true;
+}
+
+// Checks each file, and each .cdraw file directly inside each directory.
+static int RunVerify(int count, char **paths) {
+  int checked = 0;
+  int bad = 0;
+  for (int i = 0; i < count; i++) {
+    struct stat st;
+    if (stat(paths[i], &st) == 0 && S_ISDIR(st.st_mode)) {
+      DIR *dir = opendir(paths[i]);
+      if (!dir) {
+        printf("BAD  %s: cannot open\n", paths[i]);
+        checked++;
+        bad++;
+        continue;
+      }
+      struct dirent *entry;
+      while ((entry = readdir(dir)) != NULL) {
+        size_t len = strlen(entry->d_name);
+        if (len <= 6 || strcmp(entry->d_name + len - 6, ".cdraw") != 0)
+          continue;
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", paths[i], entry->d_name);
+        checked++;
+        bad += !VerifyOne(path);
+      }
+      closedir(dir);
+      continue;
+    }
+    checked++;
+    bad += !VerifyOne(paths[i]);
+  }
+  fprintf(stderr, "%d checked, %d bad\n", checked, bad);
+  return bad > 0 ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
   const int screenWidth = 1000;
   const int screenHeight = 800;
 
+  if (argc > 1 && strcmp(argv[1], "--convert") == 0) {
+    if (argc != 4) {
+      fprintf(stderr, "usage: %s --convert IN OUT\n", argv[0]);
+      return 2;
+    }
+    return RunConvert(argv[2], argv[3]);
+  }
+  if (argc > 1 && strcmp(argv[1], "--verify") == 0) {
+    if (argc < 3) {
+      fprintf(stderr, "usage: %s --verify FILE|DIR...\n", argv[0]);
+      return 2;
+    }
+    return RunVerify(argc - 2, argv + 2);
+  }
+
   BackendSetEnv();
   SetConfigFlags(FLAG_WINDOW_RESIZABLE | FLAG_MSAA_4X_HINT);
   InitWindow(screenWidth, screenHeight, "cdraw - Vector Drawing");
   SetExitKey(KEY_NULL);
+  (void)InputCaptureStart();
 
   GuiState gui;
   InitGui(&gui);
@@ -105,6 +197,14 @@ int main(void) {
   AppPrefs prefs = PrefsDefaults();
   (void)PrefsLoad(&prefs);
   gui.darkMode = prefs.darkMode;
+  gui.simplifyTolerance = prefs.simplifyTolerance;
+  gui.compressSaves = prefs.compressSaves;
+  gui.exportDpi = prefs.exportDpi;
+  gui.exportWidth = prefs.exportWidth;
+  gui.exportHeight = prefs.exportHeight;
+  gui.pdfPageWidth = prefs.pdfPageWidth;
+  gui.pdfPageHeight = prefs.pdfPageHeight;
+  CanvasSetLoadLimits((CanvasLoadLimits){prefs.maxLoadStrokes, prefs.maxLoadPoints});
   GuiDocumentsInit(&gui, screenWidth, screenHeight, prefs.showGrid);
   gui.hasSeenWelcome = prefs.hasSeenWelcome;
   gui.showWelcome = !prefs.hasSeenWelcome;
@@ -112,19 +212,25 @@ int main(void) {
     gui.hasSeenWelcome = true;
 
   StartBackend();
+  GuiAutosaveStart(&gui);
 
   SetTargetFPS(60);
 
   while (!WindowShouldClose() && !gui.requestExit) {
     // Update
+    GuiOpenUpdate(&gui);
+    GuiExportUpdate(&gui);
     bool mouseOverGui = IsMouseOverGui(&gui);
     Canvas *canvas = GuiGetActiveCanvas(&gui);
     if (!canvas)
       continue;
 
     UpdateGui(&gui, canvas);
-    UpdateCanvasState(canvas, mouseOverGui, gui.activeTool);
+    // A document that is still opening can be looked around, not edited.
+    UpdateCanvasState(canvas, mouseOverGui,
+                      GuiActiveDocumentLoading(&gui) ? TOOL_PAN : gui.activeTool);
     UpdateCursor(&gui, canvas, mouseOverGui);
+    GuiAutosaveUpdate(&gui);
 
     // Draw
     BeginDrawing();
@@ -139,13 +245,26 @@ int main(void) {
   Document *doc = GuiGetActiveDocument(&gui);
   finalPrefs.showGrid = doc ? doc->canvas.showGrid : prefs.showGrid;
   finalPrefs.hasSeenWelcome = gui.hasSeenWelcome;
+  finalPrefs.simplifyTolerance = gui.simplifyTolerance;
+  finalPrefs.compressSaves = gui.compressSaves;
+  finalPrefs.exportDpi = gui.exportDpi;
+  finalPrefs.exportWidth = gui.exportWidth;
+  finalPrefs.exportHeight = gui.exportHeight;
+  finalPrefs.pdfPageWidth = gui.pdfPageWidth;
+  finalPrefs.pdfPageHeight = gui.pdfPageHeight;
+  finalPrefs.maxLoadStrokes = prefs.maxLoadStrokes;
+  finalPrefs.maxLoadPoints = prefs.maxLoadPoints;
   (void)PrefsSave(&finalPrefs);
 
+  GuiOpenStop();
+  GuiExportStop();
+  GuiAutosaveStop(&gui);
   GuiDocumentsFree(&gui);
   UnloadGui(&gui);
   ShowCursor();
   SetMouseCursor(MOUSE_CURSOR_DEFAULT);
   StopBackend();
+  InputCaptureStop();
   CloseWindow();
 
   return 0;
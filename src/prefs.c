@@ -1,6 +1,7 @@
 #include "prefs.h"
 #include <ctype.h>
 #include <errno.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -151,6 +152,15 @@ AppPrefs PrefsDefaults(void) {
       .darkMode = true,
       .showGrid = true,
       .hasSeenWelcome = false,
+      .simplifyTolerance = 0.35f,
+      .compressSaves = false,
+      .exportDpi = 300.0f,
+      .exportWidth = 0,
+      .exportHeight = 0,
+      .pdfPageWidth = 0.0f,
+      .pdfPageHeight = 0.0f,
+      .maxLoadStrokes = 8000000,
+      .maxLoadPoints = 1ull << 32,
   };
 }
 
@@ -200,6 +210,49 @@ bool PrefsLoad(AppPrefs *outPrefs) {
     } else if (strcmp(key, "hasSeenWelcome") == 0) {
       if (ParseBool(val, &b))
         outPrefs->hasSeenWelcome = b;
+    } else if (strcmp(key, "simplifyTolerance") == 0) {
+      char *end = NULL;
+      float v = strtof(val, &end);
+      if (end != val && v >= 0.0f && v <= 16.0f)
+        outPrefs->simplifyTolerance = v;
+    } else if (strcmp(key, "compressSaves") == 0) {
+      if (ParseBool(val, &b))
+        outPrefs->compressSaves = b;
+    } else if (strcmp(key, "exportDpi") == 0) {
+      char *end = NULL;
+      float v = strtof(val, &end);
+      if (end != val && v >= 24.0f && v <= 2400.0f)
+        outPrefs->exportDpi = v;
+    } else if (strcmp(key, "exportWidth") == 0) {
+      char *end = NULL;
+      long v = strtol(val, &end, 10);
+      if (end != val && v >= 0 && v <= 65535)
+        outPrefs->exportWidth = (int)v;
+    } else if (strcmp(key, "exportHeight") == 0) {
+      char *end = NULL;
+      long v = strtol(val, &end, 10);
+      if (end != val && v >= 0 && v <= 65535)
+        outPrefs->exportHeight = (int)v;
+    } else if (strcmp(key, "pdfPageWidth") == 0) {
+      char *end = NULL;
+      float v = strtof(val, &end);
+      if (end != val && v >= 0.0f && v <= 14400.0f)
+        outPrefs->pdfPageWidth = v;
+    } else if (strcmp(key, "pdfPageHeight") == 0) {
+      char *end = NULL;
+      float v = strtof(val, &end);
+      if (end != val && v >= 0.0f && v <= 14400.0f)
+        outPrefs->pdfPageHeight = v;
+    } else if (strcmp(key, "maxLoadStrokes") == 0) {
+      char *end = NULL;
+      unsigned long long v = strtoull(val, &end, 10);
+      if (end != val && v > 0 && v <= INT_MAX)
+        outPrefs->maxLoadStrokes = (uint32_t)v;
+    } else if (strcmp(key, "maxLoadPoints") == 0) {
+      char *end = NULL;
+      unsigned long long v = strtoull(val, &end, 10);
+      if (end != val && v > 0)
+        outPrefs->maxLoadPoints = (uint64_t)v;
     }
   }
 
@@ -225,6 +278,15 @@ bool PrefsSave(const AppPrefs *prefs) {
   fprintf(f, "darkMode=%d\n", prefs->darkMode ? 1 : 0);
   fprintf(f, "showGrid=%d\n", prefs->showGrid ? 1 : 0);
   fprintf(f, "hasSeenWelcome=%d\n", prefs->hasSeenWelcome ? 1 : 0);
+  fprintf(f, "simplifyTolerance=%.3f\n", prefs->simplifyTolerance);
+  fprintf(f, "compressSaves=%d\n", prefs->compressSaves ? 1 : 0);
+  fprintf(f, "exportDpi=%.1f\n", prefs->exportDpi);
+  fprintf(f, "exportWidth=%d\n", prefs->exportWidth);
+  fprintf(f, "exportHeight=%d\n", prefs->exportHeight);
+  fprintf(f, "pdfPageWidth=%.1f\n", prefs->pdfPageWidth);
+  fprintf(f, "pdfPageHeight=%.1f\n", prefs->pdfPageHeight);
+  fprintf(f, "maxLoadStrokes=%lu\n", (unsigned long)prefs->maxLoadStrokes);
+  fprintf(f, "maxLoadPoints=%llu\n", (unsigned long long)prefs->maxLoadPoints);
 
   fclose(f);
   return true;
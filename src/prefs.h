@@ -2,11 +2,24 @@
 #define PREFS_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 typedef struct {
   bool darkMode;
   bool showGrid;
   bool hasSeenWelcome;
+  float simplifyTolerance; // pen stroke simplification, screen pixels
+  bool compressSaves;      // write the compressed .cdraw format
+  // Print-size PNG export; a pixel size of 0 follows the drawing at the DPI.
+  float exportDpi;
+  int exportWidth;
+  int exportHeight;
+  // PDF export pages in points; 0 puts the drawing on one page its size.
+  float pdfPageWidth;
+  float pdfPageHeight;
+  // Files with more are refused on load (CanvasLoadLimits).
+  uint32_t maxLoadStrokes;
+  uint64_t maxLoadPoints;
 } AppPrefs;
 
 AppPrefs PrefsDefaults(void);
@@ -0,0 +1,194 @@
+#include "text_reader.h"
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEXT_BLOCK_SIZE (1 << 20)
+// Longer tokens are not anything the formats contain.
+#define TEXT_MAX_TOKEN 128
+
+bool TextReaderInit(TextReader *r, FILE *f) {
+  memset(r, 0, sizeof(*r));
+  r->f = f;
+  r->buf = (char *)malloc(TEXT_BLOCK_SIZE);
+  return r->buf != NULL;
+}
+
+void TextReaderFree(TextReader *r) {
+  free(r->buf);
+  r->buf = NULL;
+}
+
+// Moves the unread bytes to the front and reads behind them.
+static bool Refill(TextReader *r) {
+  if (r->eof)
+    return false;
+  memmove(r->buf, r->buf + r->pos, r->len - r->pos);
+  r->len -= r->pos;
+  r->pos = 0;
+  size_t n = fread(r->buf + r->len, 1, TEXT_BLOCK_SIZE - r->len, r->f);
+  if (n == 0)
+    r->eof = true;
+  r->len += n;
+  return n > 0;
+}
+
+static bool IsSpace(char c) {
+  return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+const char *TextReaderNext(TextReader *r, size_t *len) {
+  for (;;) {
+    while (r->pos < r->len && IsSpace(r->buf[r->pos])) {
+      if (r->buf[r->pos] == '\n')
+        r->line++;
+      r->pos++;
+    }
+    if (r->pos < r->len)
+      break;
+    if (!Refill(r))
+      return NULL;
+  }
+  if (r->line == 0)
+    r->line = 1;
+
+  size_t end = r->pos;
+  for (;;) {
+    while (end < r->len && !IsSpace(r->buf[end]))
+      end++;
+    if (end - r->pos > TEXT_MAX_TOKEN)
+      return NULL;
+    if (end < r->len || r->eof)
+      break;
+    size_t scanned = end - r->pos;
+    if (!Refill(r) && r->len == 0)
+      return NULL;
+    end = r->pos + scanned;
+  }
+  const char *token = r->buf + r->pos;
+  *len = end - r->pos;
+  r->pos = end;
+  return token;
+}
+
+bool TextReaderKeyword(TextReader *r, const char *word) {
+  size_t len = 0;
+  const char *token = TextReaderNext(r, &len);
+  return token && len == strlen(word) && memcmp(token, word, len) == 0;
+}
+
+bool TextReaderInt(TextReader *r, int64_t min, int64_t max, int64_t *out) {
+  size_t len = 0;
+  const char *p = TextReaderNext(r, &len);
+  if (!p || len == 0)
+    return false;
+  const char *end = p + len;
+  bool neg = false;
+  if (*p == '+' || *p == '-')
+    neg = *p++ == '-';
+  // 18 digits cannot overflow; no field comes close.
+  if (p == end || end - p > 18)
+    return false;
+  int64_t v = 0;
+  for (; p < end; p++) {
+    if (*p < '0' || *p > '9')
+      return false;
+    v = v * 10 + (*p - '0');
+  }
+  if (neg)
+    v = -v;
+  if (v < min || v > max)
+    return false;
+  *out = v;
+  return true;
+}
+
+bool TextReaderFloat(TextReader *r, float *out) {
+  size_t len = 0;
+  const char *p = TextReaderNext(r, &len);
+  return p && TextParseFloat(p, len, out);
+}
+
+static bool ParseFloatSlow(const char *p, size_t len, float *out) {
+  char tmp[TEXT_MAX_TOKEN + 1];
+  if (len == 0 || len > TEXT_MAX_TOKEN)
+    return false;
+  memcpy(tmp, p, len);
+  tmp[len] = '\0';
+  char *end = NULL;
+  float v = strtof(tmp, &end);
+  if (end != tmp + len)
+    return false;
+  *out = v;
+  return true;
+}
+
+// Clinger's fast path: with at most 2^53 as the digits and a power of ten
+// that is exact in a double, one multiply or divide is correctly rounded.
+// Rounding that double to float again is only ambiguous when it lands on a
+// float midpoint, which goes to strtof instead. So does anything unusual
+// (long mantissas, big exponents, subnormals, inf, nan, hex).
+bool TextParseFloat(const char *p, size_t len, float *out) {
+  static const double kPow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                  1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                  1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  const char *s = p;
+  const char *end = p + len;
+  bool neg = false;
+  if (s < end && (*s == '+' || *s == '-'))
+    neg = *s++ == '-';
+
+  uint64_t m = 0;
+  int digits = 0;
+  int exp10 = 0;
+  bool any = false;
+  for (; s < end && *s >= '0' && *s <= '9'; s++) {
+    if (digits >= 19)
+      return ParseFloatSlow(p, len, out);
+    m = m * 10 + (uint64_t)(*s - '0');
+    digits += m != 0;
+    any = true;
+  }
+  if (s < end && *s == '.') {
+    for (s++; s < end && *s >= '0' && *s <= '9'; s++) {
+      if (digits >= 19)
+        return ParseFloatSlow(p, len, out);
+      m = m * 10 + (uint64_t)(*s - '0');
+      digits += m != 0;
+      exp10--;
+      any = true;
+    }
+  }
+  if (any && s < end && (*s == 'e' || *s == 'E')) {
+    s++;
+    bool expNeg = false;
+    if (s < end && (*s == '+' || *s == '-'))
+      expNeg = *s++ == '-';
+    int e = 0;
+    bool expAny = false;
+    for (; s < end && *s >= '0' && *s <= '9'; s++) {
+      if (e < 10000)
+        e = e * 10 + (*s - '0');
+      expAny = true;
+    }
+    if (!expAny)
+      return ParseFloatSlow(p, len, out);
+    exp10 += expNeg ? -e : e;
+  }
+  if (!any || s != end || m > (1ull << 53) || exp10 < -22 || exp10 > 22)
+    return ParseFloatSlow(p, len, out);
+
+  double d = exp10 < 0 ? (double)m / kPow10[-exp10] : (double)m * kPow10[exp10];
+  if (d == 0.0) {
+    *out = neg ? -0.0f : 0.0f;
+    return true;
+  }
+  if (d < FLT_MIN || d > FLT_MAX)
+    return ParseFloatSlow(p, len, out);
+  uint64_t bits;
+  memcpy(&bits, &d, sizeof(bits));
+  if ((bits & ((1ull << 29) - 1)) == (1ull << 28))
+    return ParseFloatSlow(p, len, out);
+  *out = (float)(neg ? -d : d);
+  return true;
+}
@@ -0,0 +1,34 @@
+#ifndef TEXT_READER_H
+#define TEXT_READER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Whitespace-separated tokens from a stream read in large blocks, for the
+// legacy text formats. Numbers parse like fscanf's %d, %u and %f, without
+// its per-call locking and locale work.
+typedef struct {
+  FILE *f;
+  char *buf;
+  size_t len;
+  size_t pos;
+  bool eof;
+  int line; // of the last token returned, from 1
+} TextReader;
+
+bool TextReaderInit(TextReader *r, FILE *f);
+void TextReaderFree(TextReader *r);
+
+// Next token, not NUL-terminated; NULL at the end of input or when a token
+// is too long to be a number or keyword.
+const char *TextReaderNext(TextReader *r, size_t *len);
+bool TextReaderKeyword(TextReader *r, const char *word);
+bool TextReaderInt(TextReader *r, int64_t min, int64_t max, int64_t *out);
+bool TextReaderFloat(TextReader *r, float *out);
+
+// Correctly rounded like strtof; false unless the whole token is a number.
+bool TextParseFloat(const char *p, size_t len, float *out);
+
+#endif // TEXT_READER_H
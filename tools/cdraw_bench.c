@@ -0,0 +1,176 @@
+// cdraw-bench: times saving and opening generated boards against memcpy of
+// the same point bytes. Files go through the page cache, so the numbers show
+// what the format code costs on top of moving the bytes, not disk speed.
+
+#include "canvas_format.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_RUNS 3
+#define BENCH_STROKE_POINTS 500
+
+static double Now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Random walks from a fixed seed, so every run times the same board.
+static bool FillBoard(Canvas *canvas, int64_t points) {
+  int strokes = (int)((points + BENCH_STROKE_POINTS - 1) / BENCH_STROKE_POINTS);
+  canvas->strokes = (Stroke *)calloc((size_t)strokes, sizeof(Stroke));
+  if (!canvas->strokes)
+    return false;
+  canvas->capacity = strokes;
+  uint32_t seed = 1;
+  for (int i = 0; i < strokes; i++) {
+    int64_t left = points - canvas->totalPoints;
+    int count = left < BENCH_STROKE_POINTS ? (int)left : BENCH_STROKE_POINTS;
+    Stroke *s = &canvas->strokes[i];
+    s->points = (Point *)malloc(sizeof(Point) * (size_t)count);
+    if (!s->points)
+      return false;
+    s->pointCount = count;
+    s->capacity = count;
+    s->color = (Color){(unsigned char)(i * 37), (unsigned char)(i * 91), 200, 255};
+    s->thickness = 2.0f + (float)(i % 6);
+    s->usePressure = i % 3 == 0;
+    s->cacheDirty = true;
+    float x = (float)(i % 100) * 40.0f, y = (float)(i / 100) * 40.0f;
+    for (int j = 0; j < count; j++) {
+      seed = seed * 1664525u + 1013904223u;
+      x += (float)((seed >> 8) & 255) / 64.0f - 2.0f;
+      y += (float)((seed >> 16) & 255) / 64.0f - 2.0f;
+      s->points[j] = (Point){x, y, 0.5f + (float)(seed >> 28) / 16.0f};
+    }
+    canvas->strokeCount++;
+    canvas->totalPoints += count;
+  }
+  return true;
+}
+
+static uint32_t FileVersion(const char *path) {
+  uint8_t head[8] = {0};
+  FILE *f = fopen(path, "rb");
+  if (f) {
+    if (fread(head, 1, sizeof(head), f) != sizeof(head))
+      memset(head, 0, sizeof(head));
+    fclose(f);
+  }
+  uint32_t version;
+  memcpy(&version, head + 4, sizeof(version));
+  return version;
+}
+
+// Saves no longer write v1, but older files still open through its record
+// reader, so the benchmark writes one itself.
+static bool WriteRecordsFile(const Canvas *canvas, const char *path) {
+  FILE *f = fopen(path, "wb");
+  if (!f)
+    return false;
+  uint8_t head[4 + BINARY_HEADER_SIZE];
+  memcpy(head, kBinaryMagic, sizeof(kBinaryMagic));
+  PackHeader(canvas, kBinaryVersionRecords, (uint32_t)canvas->strokeCount, head + 4);
+  bool ok = fwrite(head, 1, sizeof(head), f) == sizeof(head);
+  for (int i = 0; ok && i < canvas->strokeCount; i++) {
+    const Stroke *s = &canvas->strokes[i];
+    uint8_t record[BINARY_STROKE_SIZE];
+    PackStrokeRecord(s, record);
+    ok = fwrite(record, 1, sizeof(record), f) == sizeof(record) &&
+         fwrite(s->points, sizeof(Point), (size_t)s->pointCount, f) == (size_t)s->pointCount;
+  }
+  return fclose(f) == 0 && ok;
+}
+
+static bool LoadAll(const char *path, int64_t points) {
+  Canvas loaded;
+  InitCanvas(&loaded, 1000, 800);
+  bool ok = LoadCanvasFromFile(&loaded, path) && CanvasEnsureLoaded(&loaded) &&
+            loaded.totalPoints == points;
+  FreeCanvas(&loaded);
+  return ok;
+}
+
+static void Report(const char *what, double seconds, double bytes) {
+  printf("  %-8s %9.1f ms %9.0f MiB/s\n", what, seconds * 1e3,
+         bytes / (1024.0 * 1024.0) / seconds);
+}
+
+// Best of BENCH_RUNS for memcpy of the points, a full save, a load that
+// leaves every stroke in memory or mapped, and a load of the same board as v1.
+static bool BenchBoard(int64_t points, const char *dir) {
+  char path[4096], recordsPath[4096];
+  snprintf(path, sizeof(path), "%s/cdraw-bench.cdraw", dir);
+  snprintf(recordsPath, sizeof(recordsPath), "%s/cdraw-bench-v1.cdraw", dir);
+  Canvas canvas;
+  InitCanvas(&canvas, 1000, 800);
+  if (!FillBoard(&canvas, points)) {
+    fprintf(stderr, "out of memory for %lld points\n", (long long)points);
+    FreeCanvas(&canvas);
+    return false;
+  }
+  double bytes = (double)points * sizeof(Point);
+  Point *copy = (Point *)malloc(sizeof(Point) * (size_t)points);
+  if (!copy) {
+    FreeCanvas(&canvas);
+    return false;
+  }
+
+  double best[4] = {1e30, 1e30, 1e30, 1e30};
+  bool ok = WriteRecordsFile(&canvas, recordsPath);
+  for (int run = 0; ok && run < BENCH_RUNS; run++) {
+    double start = Now();
+    Point *out = copy;
+    for (int i = 0; i < canvas.strokeCount; i++) {
+      memcpy(out, canvas.strokes[i].points, sizeof(Point) * (size_t)canvas.strokes[i].pointCount);
+      out += canvas.strokes[i].pointCount;
+    }
+    double copied = Now();
+    ok = WriteCanvasFile(&canvas, path);
+    double saved = Now();
+
+    ok = ok && LoadAll(path, points);
+    double opened = Now();
+    ok = ok && LoadAll(recordsPath, points);
+    double openedRecords = Now();
+
+    best[0] = copied - start < best[0] ? copied - start : best[0];
+    best[1] = saved - copied < best[1] ? saved - copied : best[1];
+    best[2] = opened - saved < best[2] ? opened - saved : best[2];
+    best[3] = openedRecords - opened < best[3] ? openedRecords - opened : best[3];
+  }
+
+  if (ok) {
+    printf("%lld points in %d strokes (%.1f MiB), saved as v%u:\n", (long long)points,
+           canvas.strokeCount, bytes / (1024.0 * 1024.0), FileVersion(path));
+    Report("memcpy", best[0], bytes);
+    Report("save", best[1], bytes);
+    Report("load", best[2], bytes);
+    Report("load v1", best[3], bytes);
+  } else {
+    fprintf(stderr, "%s: save or load failed\n", path);
+  }
+  remove(path);
+  remove(recordsPath);
+  free(copy);
+  FreeCanvas(&canvas);
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 2) {
+    fprintf(stderr, "usage: %s [DIR]\n  Boards are written to DIR (default .) and removed.\n",
+            argv[0]);
+    return 2;
+  }
+  const char *dir = argc == 2 ? argv[1] : ".";
+  // One board below the chunked save threshold and one above it. Mapped (v5)
+  // loads read points on first use, so their load time is mostly the table.
+  static const int64_t kBoards[] = {1000000, 8000000};
+  bool ok = true;
+  for (int i = 0; ok && i < (int)(sizeof(kBoards) / sizeof(kBoards[0])); i++)
+    ok = BenchBoard(kBoards[i], dir);
+  return ok ? 0 : 1;
+}
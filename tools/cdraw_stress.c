@@ -0,0 +1,271 @@
+// cdraw-stress: round-trips a board of more than 2^31 points through a
+// chunked (v4) save and a full load, then compares counts and sampled points.
+// The loaded board's extent is checked against the source, and a window of
+// it rasterized: every stroke crosses the whole board, so building that
+// window's scene walks every point. (Rasterizing all of it would take one
+// primitive per segment, beyond what one raster holds.) A small chunked board
+// with a journal is checked first.
+// The saved board's strokes all borrow windows of one shared point buffer,
+// and the load maps the file, so memory stays small; the file takes about 12
+// bytes per point of disk.
+
+#include "canvas_internal.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Below CHUNKED_MAX_POINTS, so chunks hold a single stroke.
+#define STRESS_STROKE_POINTS 60000
+#define STRESS_SOURCE_POINTS (1 << 20)
+#define STRESS_SAMPLES 8
+#define STRESS_RASTER_SIZE 64
+
+static double Now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int StrokePoints(int64_t points, int i) {
+  int64_t left = points - (int64_t)i * STRESS_STROKE_POINTS;
+  return left < STRESS_STROKE_POINTS ? (int)left : STRESS_STROKE_POINTS;
+}
+
+// Where stroke `i` starts in the source buffer; strokes overlap but no two
+// neighbours start at the same point.
+static const Point *StrokeSource(const Point *source, int i) {
+  return source + ((uint64_t)i * 7919u) % (STRESS_SOURCE_POINTS - STRESS_STROKE_POINTS);
+}
+
+static Color StrokeColor(int i) {
+  return (Color){(unsigned char)i, (unsigned char)(i >> 8), (unsigned char)(i >> 16), 255};
+}
+
+static bool FillBoard(Canvas *canvas, PointStore *store, const Point *source,
+                      int64_t points) {
+  int strokes = (int)((points + STRESS_STROKE_POINTS - 1) / STRESS_STROKE_POINTS);
+  canvas->strokes = (Stroke *)calloc((size_t)strokes, sizeof(Stroke));
+  if (!canvas->strokes)
+    return false;
+  canvas->capacity = strokes;
+  for (int i = 0; i < strokes; i++) {
+    Stroke *s = &canvas->strokes[i];
+    s->points = (Point *)StrokeSource(source, i);
+    s->pointCount = StrokePoints(points, i);
+    s->capacity = s->pointCount;
+    s->store = store;
+    PointStoreRetain(store);
+    s->color = StrokeColor(i);
+    s->thickness = 1.0f + (float)(i % 8);
+    s->cacheDirty = true;
+    canvas->strokeCount++;
+    canvas->totalPoints += s->pointCount;
+  }
+  return true;
+}
+
+// Counts, colors, both ends of every stroke and STRESS_SAMPLES points between.
+static bool CheckBoard(const Canvas *canvas, const Point *source, int64_t points) {
+  int strokes = (int)((points + STRESS_STROKE_POINTS - 1) / STRESS_STROKE_POINTS);
+  if (canvas->strokeCount != strokes || canvas->totalPoints != points) {
+    fprintf(stderr, "loaded %d strokes and %lld points, expected %d and %lld\n",
+            canvas->strokeCount, (long long)canvas->totalPoints, strokes,
+            (long long)points);
+    return false;
+  }
+  uint32_t seed = 1;
+  for (int i = 0; i < strokes; i++) {
+    const Stroke *s = &canvas->strokes[i];
+    const Point *expected = StrokeSource(source, i);
+    Color c = StrokeColor(i);
+    if (s->pointCount != StrokePoints(points, i) || s->color.r != c.r ||
+        s->color.g != c.g || s->color.b != c.b) {
+      fprintf(stderr, "stroke %d: wrong point count or color\n", i);
+      return false;
+    }
+    for (int k = 0; k < STRESS_SAMPLES + 2; k++) {
+      seed = seed * 1664525u + 1013904223u;
+      int j = k == 0 ? 0 : (k == 1 ? s->pointCount - 1 : (int)(seed % (uint32_t)s->pointCount));
+      if (memcmp(&s->points[j], &expected[j], sizeof(Point)) != 0) {
+        fprintf(stderr, "stroke %d: point %d differs\n", i, j);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// CanvasStrokeBounds over the loaded board against the extent of the source
+// windows, each grown by half its stroke's thickness as the canvas does.
+static bool CheckBounds(Canvas *canvas, const Point *source, int64_t points) {
+  double start = Now();
+  Rectangle got;
+  if (!CanvasStrokeBounds(canvas, &got)) {
+    fprintf(stderr, "no bounds for the loaded board\n");
+    return false;
+  }
+  double measured = Now();
+  float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f;
+  for (int i = 0; i < canvas->strokeCount; i++) {
+    const Point *p = StrokeSource(source, i);
+    float r = fmaxf(1.0f, canvas->strokes[i].thickness) * 0.5f;
+    for (int j = 0; j < StrokePoints(points, i); j++) {
+      minX = fminf(minX, p[j].x - r);
+      minY = fminf(minY, p[j].y - r);
+      maxX = fmaxf(maxX, p[j].x + r);
+      maxY = fmaxf(maxY, p[j].y + r);
+    }
+  }
+  if (got.x != minX || got.y != minY || got.x + got.width != maxX ||
+      got.y + got.height != maxY) {
+    fprintf(stderr, "bounds (%g, %g)-(%g, %g), expected (%g, %g)-(%g, %g)\n", got.x, got.y,
+            got.x + got.width, got.y + got.height, minX, minY, maxX, maxY);
+    return false;
+  }
+  printf("bounds in %.1f s\n", measured - start);
+  return true;
+}
+
+// CanvasRasterize of a window at the board's centre, which must draw strokes.
+static bool CheckRaster(Canvas *canvas) {
+  Rectangle extent;
+  if (!CanvasStrokeBounds(canvas, &extent))
+    return false;
+  static uint8_t rgba[STRESS_RASTER_SIZE * STRESS_RASTER_SIZE * 4];
+  canvas->showGrid = false;
+  canvas->camera = (Camera2D){
+      .offset = {STRESS_RASTER_SIZE / 2.0f, STRESS_RASTER_SIZE / 2.0f},
+      .target = {extent.x + extent.width / 2.0f, extent.y + extent.height / 2.0f},
+      .zoom = 4.0f};
+  double start = Now();
+  if (!CanvasRasterize(canvas, 0, 0, STRESS_RASTER_SIZE, STRESS_RASTER_SIZE, rgba,
+                       STRESS_RASTER_SIZE * 4, 0)) {
+    fprintf(stderr, "cannot rasterize the board\n");
+    return false;
+  }
+  double drawn = Now();
+  Color bg = canvas->backgroundColor;
+  int inked = 0;
+  for (int i = 0; i < STRESS_RASTER_SIZE * STRESS_RASTER_SIZE; i++)
+    if (rgba[i * 4] != bg.r || rgba[i * 4 + 1] != bg.g || rgba[i * 4 + 2] != bg.b)
+      inked++;
+  if (inked == 0) {
+    fprintf(stderr, "rasterized window is blank\n");
+    return false;
+  }
+  printf("rasterized a %dx%d window in %.1f s\n", STRESS_RASTER_SIZE, STRESS_RASTER_SIZE,
+         drawn - start);
+  return true;
+}
+
+// Journal frames appended to a chunked file must apply to strokes that are
+// still placeholders when the file opens: a stroke far outside the saved
+// view is moved, the move appended, and the file loaded again.
+static bool CheckJournalReplay(const char *dir) {
+  char path[4096];
+  snprintf(path, sizeof(path), "%s/cdraw-stress-journal.cdraw", dir);
+  Canvas canvas;
+  InitCanvas(&canvas, 1000, 800);
+  // Enough points near the origin to be saved chunked, then the far stroke,
+  // too long to share a chunk with them.
+  const int nearStrokes = 40;
+  bool ok = true;
+  for (int i = 0; ok && i <= nearStrokes; i++) {
+    int count = i < nearStrokes ? STRESS_STROKE_POINTS : STRESS_STROKE_POINTS / 2;
+    Point *points = (Point *)malloc(sizeof(Point) * (size_t)count);
+    ok = points != NULL;
+    for (int j = 0; ok && j < count; j++)
+      points[j] = i < nearStrokes ? (Point){(float)j * 0.01f, (float)i, 1.0f}
+                                  : (Point){100000.0f + (float)j, 0.0f, 1.0f};
+    if (ok)
+      AddStroke(&canvas, (Stroke){.points = points, .pointCount = count, .capacity = count,
+                                  .color = {255, 255, 255, 255}, .thickness = 2.0f,
+                                  .cacheDirty = true});
+  }
+  ok = ok && SaveCanvasToFile(&canvas, path);
+  if (ok)
+    CanvasTranslateStroke(&canvas, nearStrokes, (Vector2){5.0f, 5.0f});
+  ok = ok && SaveCanvasToFile(&canvas, path);
+  FreeCanvas(&canvas);
+
+  InitCanvas(&canvas, 1000, 800);
+  ok = ok && LoadCanvasFromFile(&canvas, path) && CanvasEnsureLoaded(&canvas) &&
+       canvas.strokeCount == nearStrokes + 1 &&
+       canvas.strokes[nearStrokes].points[0].x == 100005.0f &&
+       canvas.strokes[nearStrokes].points[0].y == 5.0f;
+  FreeCanvas(&canvas);
+  remove(path);
+  printf("journal replay on a chunked file %s\n", ok ? "ok" : "FAILED");
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  int64_t points = (1ll << 31) + 1000003;
+  int arg = 1;
+  if (argc == 4 && strcmp(argv[1], "-p") == 0) {
+    points = strtoll(argv[2], NULL, 10);
+    arg = 3;
+  }
+  if (arg != argc - 1 || points < 1) {
+    fprintf(stderr,
+            "usage: %s [-p POINTS] DIR\n"
+            "  Saves a board of POINTS points (default 2^31 + 1000003) to DIR, loads it\n"
+            "  back and compares. Needs about 12 bytes per point of disk.\n",
+            argv[0]);
+    return 2;
+  }
+  char path[4096];
+  snprintf(path, sizeof(path), "%s/cdraw-stress.cdraw", argv[arg]);
+  if (!CheckJournalReplay(argv[arg]))
+    return 1;
+
+  Point *source = (Point *)malloc(sizeof(Point) * STRESS_SOURCE_POINTS);
+  PointStore *store = source ? PointStoreAdopt(source, sizeof(Point) * STRESS_SOURCE_POINTS) : NULL;
+  if (!store) {
+    free(source);
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  uint32_t seed = 7;
+  for (int j = 0; j < STRESS_SOURCE_POINTS; j++) {
+    seed = seed * 1664525u + 1013904223u;
+    source[j] = (Point){(float)(seed >> 8) / 4096.0f, (float)(j % 4096) * 0.25f,
+                        (float)(seed & 255) / 64.0f};
+  }
+  CanvasLoadLimits limits = CanvasGetLoadLimits();
+  if (limits.maxTotalPoints < (uint64_t)points)
+    limits.maxTotalPoints = (uint64_t)points;
+  CanvasSetLoadLimits(limits);
+
+  Canvas canvas;
+  InitCanvas(&canvas, 1000, 800);
+  double start = Now();
+  bool ok = FillBoard(&canvas, store, source, points) && WriteCanvasFile(&canvas, path);
+  double saved = Now();
+  FreeCanvas(&canvas);
+  if (!ok) {
+    fprintf(stderr, "%s: cannot save %lld points\n", path, (long long)points);
+    remove(path);
+    PointStoreRelease(store);
+    return 1;
+  }
+  printf("saved %lld points in %.1f s\n", (long long)points, saved - start);
+
+  InitCanvas(&canvas, 1000, 800);
+  ok = LoadCanvasFromFile(&canvas, path) && CanvasEnsureLoaded(&canvas);
+  double loaded = Now();
+  if (ok) {
+    printf("loaded in %.1f s\n", loaded - saved);
+    ok = CheckBoard(&canvas, source, points) && CheckBounds(&canvas, source, points) &&
+         CheckRaster(&canvas);
+  } else {
+    fprintf(stderr, "%s: cannot load\n", path);
+  }
+  FreeCanvas(&canvas);
+  remove(path);
+  PointStoreRelease(store);
+  printf("%s\n", ok ? "round trip ok" : "round trip FAILED");
+  return ok ? 0 : 1;
+}